@@ -0,0 +1,117 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <sys/resource.h>
+#include <vector>
+
+namespace bench {
+
+// Measurements of one benchmark run. A sample is one timed call of measure(): a single
+// operation for the microbenchmarks, a whole pass over the graph for the macrobenchmarks.
+class Recorder {
+private:
+  std::vector<double> sampleNs;
+  std::size_t items = 0;
+
+public:
+  // Times fn, which processes nrOfItems items (edges, vertices or queries)
+  template <typename Fn>
+  void measure(std::size_t nrOfItems, Fn &&fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    sampleNs.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+    items += nrOfItems;
+  }
+
+  // Counts items that were processed outside of a timed call
+  void addItems(std::size_t nrOfItems) { items += nrOfItems; }
+
+  const std::vector<double> &getSamples() const { return sampleNs; }
+  std::size_t getNrOfItems() const { return items; }
+};
+
+struct Result {
+  std::string name;
+  int size = 0; // the requested number of vertices
+  std::size_t vertices = 0;
+  std::size_t edges = 0;
+  std::size_t samples = 0;
+  std::size_t items = 0;
+  double seconds = 0;
+  double itemsPerSecond = 0;
+  double minNs = 0, p50Ns = 0, p90Ns = 0, p99Ns = 0, maxNs = 0, meanNs = 0;
+  long peakRssKb = 0;   // peak resident set of the process after the run
+  long rssGrowthKb = 0; // how much the run raised the peak
+};
+
+// Peak resident set size of the process in KB
+inline long getPeakRssKb() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+inline double percentile(const std::vector<double> &sorted, double p) {
+  if (sorted.empty())
+    return 0;
+  const std::size_t rank = std::min(sorted.size() - 1, (std::size_t)(p * (sorted.size() - 1) + 0.5));
+  return sorted[rank];
+}
+
+inline Result summarize(const std::string &name, int size, std::size_t vertices, std::size_t edges,
+                        const Recorder &recorder, long peakBeforeKb) {
+  Result result{name, size, vertices, edges};
+  std::vector<double> sorted = recorder.getSamples();
+  std::sort(sorted.begin(), sorted.end());
+  result.samples = sorted.size();
+  result.items = recorder.getNrOfItems();
+  for (double ns : sorted)
+    result.seconds += ns / 1e9;
+  result.itemsPerSecond = result.seconds > 0 ? result.items / result.seconds : 0;
+  if (!sorted.empty()) {
+    result.minNs = sorted.front();
+    result.maxNs = sorted.back();
+    result.meanNs = result.seconds * 1e9 / sorted.size();
+    result.p50Ns = percentile(sorted, 0.50);
+    result.p90Ns = percentile(sorted, 0.90);
+    result.p99Ns = percentile(sorted, 0.99);
+  }
+  result.peakRssKb = getPeakRssKb();
+  result.rssGrowthKb = result.peakRssKb - peakBeforeKb;
+  return result;
+}
+
+// One line per benchmark so that results files can be compared (and diffed) line by line
+inline std::string toJson(const Result &r) {
+  char buffer[1024];
+  std::snprintf(buffer, sizeof(buffer),
+                "{\"name\": \"%s\", \"size\": %d, \"vertices\": %zu, \"edges\": %zu, \"samples\": %zu, "
+                "\"items\": %zu, \"seconds\": %.6f, \"itemsPerSecond\": %.1f, "
+                "\"latencyNs\": {\"min\": %.0f, \"p50\": %.0f, \"p90\": %.0f, \"p99\": %.0f, \"max\": %.0f, \"mean\": %.0f}, "
+                "\"peakRssKb\": %ld, \"rssGrowthKb\": %ld}",
+                r.name.c_str(), r.size, r.vertices, r.edges, r.samples, r.items, r.seconds, r.itemsPerSecond,
+                r.minNs, r.p50Ns, r.p90Ns, r.p99Ns, r.maxNs, r.meanNs, r.peakRssKb, r.rssGrowthKb);
+  return buffer;
+}
+
+// Extracts a numeric field written by toJson (0 if it is missing)
+inline double jsonNumber(const std::string &line, const std::string &field) {
+  const auto position = line.find("\"" + field + "\": ");
+  if (position == std::string::npos)
+    return 0;
+  return std::stod(line.substr(position + field.size() + 4));
+}
+
+inline std::string jsonString(const std::string &line, const std::string &field) {
+  const auto position = line.find("\"" + field + "\": \"");
+  if (position == std::string::npos)
+    return "";
+  const auto begin = position + field.size() + 5;
+  return line.substr(begin, line.find('"', begin) - begin);
+}
+
+} // namespace bench
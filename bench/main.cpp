@@ -0,0 +1,413 @@
+#include "Bench.hpp"
+#include "../graph/algorithms/DirectedGraphAlgorithms.hpp"
+#include "../graph/algorithms/UndirectedGraphAlgorithms.hpp"
+#include "../graph/directed_graph/DirectedGraph.hpp"
+#include "../graph/special/ActivityGraph.hpp"
+#include "../graph/undirected_graph/UndirectedGraph.hpp"
+#include "../graph/vertices/ActivityVertex.hpp"
+#include "../graph/vertices/StringVertex.hpp"
+#include "../service/GraphService.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <unordered_set>
+#include <vector>
+
+#ifndef GRAPH_BENCH_BUILD_TYPE
+#define GRAPH_BENCH_BUILD_TYPE "unknown"
+#endif
+
+namespace {
+
+using EdgeList = std::vector<std::pair<int, int>>;
+
+struct Context {
+  int size;           // number of vertices
+  int repetitions;
+  std::mt19937 rng;
+  bench::Recorder recorder{};
+  std::size_t vertices = 0;
+  std::size_t edges = 0;
+};
+
+struct Benchmark {
+  std::string name;
+  int maxSize; // larger sizes are skipped (the cubic algorithms)
+  std::function<void(Context &)> run;
+};
+
+const int EDGES_PER_VERTEX = 4;
+const int NR_OF_QUERIES = 100;
+
+// m distinct edges without self loops; in a DAG every edge goes from a lower to a higher vertex
+EdgeList randomEdges(int n, std::size_t m, std::mt19937 &rng, bool acyclic = false) {
+  EdgeList edges;
+  if (n < 2)
+    return edges;
+  m = std::min<std::size_t>(m, (std::size_t)n * (n - 1) / 2);
+  std::unordered_set<std::uint64_t> seen;
+  std::uniform_int_distribution<int> vertex(0, n - 1);
+  while (edges.size() < m) {
+    int from = vertex(rng), to = vertex(rng);
+    if (from == to)
+      continue;
+    if (acyclic && from > to)
+      std::swap(from, to);
+    // undirected benchmarks need {a, b} and {b, a} to be the same edge
+    const std::uint64_t key = ((std::uint64_t)std::min(from, to) << 32) | (std::uint32_t)std::max(from, to);
+    if (seen.insert(key).second)
+      edges.push_back({from, to});
+  }
+  return edges;
+}
+
+template <typename G>
+G makeGraph(int n, const EdgeList &edges, std::mt19937 &rng) {
+  G g;
+  for (int i = 0; i < n; ++i)
+    g.addVertex(std::make_shared<graph::StringVertex>(std::to_string(i)));
+  std::uniform_int_distribution<int> weight(1, 100);
+  for (const auto &[from, to] : edges)
+    g.addEdge(std::to_string(from), std::to_string(to), weight(rng));
+  return g;
+}
+
+std::vector<std::pair<std::string, std::string>> randomPairs(int n, std::mt19937 &rng) {
+  std::uniform_int_distribution<int> vertex(0, n - 1);
+  std::vector<std::pair<std::string, std::string>> pairs;
+  for (int i = 0; i < NR_OF_QUERIES; ++i)
+    pairs.push_back({std::to_string(vertex(rng)), std::to_string(vertex(rng))});
+  return pairs;
+}
+
+std::string temporaryPath() {
+  return (std::filesystem::temp_directory_path() / ("graph_bench_" + std::to_string(getpid()) + ".txt")).string();
+}
+
+// Mutation benchmarks: every sample is a single call
+template <typename G>
+void benchAddVertex(Context &ctx) {
+  for (int r = 0; r < ctx.repetitions; ++r) {
+    G g;
+    for (int i = 0; i < ctx.size; ++i) {
+      auto vertex = std::make_shared<graph::StringVertex>(std::to_string(i));
+      ctx.recorder.measure(1, [&]() { g.addVertex(vertex); });
+    }
+    ctx.vertices = g.getNrOfVertices();
+  }
+}
+
+template <typename G>
+void benchAddEdge(Context &ctx) {
+  const auto edges = randomEdges(ctx.size, (std::size_t)ctx.size * EDGES_PER_VERTEX, ctx.rng);
+  for (int r = 0; r < ctx.repetitions; ++r) {
+    G g = makeGraph<G>(ctx.size, {}, ctx.rng);
+    for (const auto &[from, to] : edges) {
+      const std::string fromId = std::to_string(from), toId = std::to_string(to);
+      ctx.recorder.measure(1, [&]() { g.addEdge(fromId, toId, 1); });
+    }
+    ctx.vertices = g.getNrOfVertices();
+    ctx.edges = g.getNrOfEdges();
+  }
+}
+
+template <typename G>
+void benchRemoveEdge(Context &ctx) {
+  const auto edges = randomEdges(ctx.size, (std::size_t)ctx.size * EDGES_PER_VERTEX, ctx.rng);
+  for (int r = 0; r < ctx.repetitions; ++r) {
+    G g = makeGraph<G>(ctx.size, edges, ctx.rng);
+    ctx.vertices = g.getNrOfVertices();
+    ctx.edges = g.getNrOfEdges();
+    for (const auto &[from, to] : edges) {
+      const std::string fromId = std::to_string(from), toId = std::to_string(to);
+      ctx.recorder.measure(1, [&]() { g.removeEdge(fromId, toId); });
+    }
+  }
+}
+
+template <typename G>
+void benchGetEdges(Context &ctx) {
+  const G g = makeGraph<G>(ctx.size, randomEdges(ctx.size, (std::size_t)ctx.size * EDGES_PER_VERTEX, ctx.rng), ctx.rng);
+  ctx.vertices = g.getNrOfVertices();
+  ctx.edges = g.getNrOfEdges();
+  for (int r = 0; r < ctx.repetitions; ++r)
+    ctx.recorder.measure(g.getNrOfEdges(), [&]() { return g.getEdges(); });
+}
+
+// One sample per vertex, the items are the edges returned
+template <typename G>
+void benchGetAdjacentEdges(Context &ctx) {
+  const G g = makeGraph<G>(ctx.size, randomEdges(ctx.size, (std::size_t)ctx.size * EDGES_PER_VERTEX, ctx.rng), ctx.rng);
+  ctx.vertices = g.getNrOfVertices();
+  ctx.edges = g.getNrOfEdges();
+  for (int r = 0; r < ctx.repetitions; ++r)
+    for (const auto &[vertexId, _] : g) {
+      std::size_t degree = 0;
+      ctx.recorder.measure(0, [&]() {
+        for (const auto &edge : g.getAdjacentEdges(vertexId)) {
+          (void)edge;
+          ++degree;
+        }
+      });
+      ctx.recorder.addItems(degree);
+    }
+}
+
+// Point to point queries between random vertices, one sample per query
+template <typename Query>
+void benchQueries(Context &ctx, const graph::DirectedGraph &g, Query &&query) {
+  ctx.vertices = g.getNrOfVertices();
+  ctx.edges = g.getNrOfEdges();
+  for (int r = 0; r < ctx.repetitions; ++r)
+    for (const auto &[from, to] : randomPairs(ctx.size, ctx.rng))
+      ctx.recorder.measure(1, [&]() { query(from, to); });
+}
+
+graph::DirectedGraph randomDirected(Context &ctx) {
+  return makeGraph<graph::DirectedGraph>(ctx.size, randomEdges(ctx.size, (std::size_t)ctx.size * EDGES_PER_VERTEX, ctx.rng), ctx.rng);
+}
+
+graph::special::ActivityGraph makeActivityGraph(Context &ctx) {
+  graph::special::ActivityGraph g;
+  std::uniform_int_distribution<int> duration(1, 20);
+  for (int i = 0; i < ctx.size; ++i)
+    g.addVertex(std::make_shared<graph::special::Activity>(std::to_string(i), "", duration(ctx.rng)));
+  for (const auto &[from, to] : randomEdges(ctx.size, (std::size_t)ctx.size * EDGES_PER_VERTEX, ctx.rng, true))
+    g.addEdge(std::to_string(from), std::to_string(to));
+  return g;
+}
+
+// Same graph, saved through a service so that the files have the console's format
+void benchSaveGraph(Context &ctx) {
+  GraphService service(std::make_unique<graph::DirectedGraph>(randomDirected(ctx)));
+  const std::string path = temporaryPath();
+  ctx.vertices = ctx.size;
+  ctx.edges = service.getEdges().size();
+  for (int r = 0; r < ctx.repetitions; ++r)
+    ctx.recorder.measure(ctx.edges, [&]() { service.saveGraph(path); });
+  std::filesystem::remove(path);
+}
+
+void benchLoadGraph(Context &ctx) {
+  const std::string path = temporaryPath();
+  GraphService(std::make_unique<graph::DirectedGraph>(randomDirected(ctx))).saveGraph(path);
+  GraphService service;
+  service.loadGraph(path, "directed");
+  ctx.vertices = service.getVertices().size();
+  ctx.edges = service.getEdges().size();
+  for (int r = 0; r < ctx.repetitions; ++r)
+    ctx.recorder.measure(ctx.edges, [&]() { service.loadGraph(path, "directed"); });
+  std::filesystem::remove(path);
+}
+
+std::vector<Benchmark> getBenchmarks() {
+  const int ANY = std::numeric_limits<int>::max();
+  return {
+      {"directed/add_vertex", ANY, benchAddVertex<graph::DirectedGraph>},
+      {"undirected/add_vertex", ANY, benchAddVertex<graph::UndirectedGraph>},
+      {"directed/add_edge", ANY, benchAddEdge<graph::DirectedGraph>},
+      {"undirected/add_edge", ANY, benchAddEdge<graph::UndirectedGraph>},
+      {"directed/remove_edge", ANY, benchRemoveEdge<graph::DirectedGraph>},
+      {"undirected/remove_edge", ANY, benchRemoveEdge<graph::UndirectedGraph>},
+      {"directed/get_edges", ANY, benchGetEdges<graph::DirectedGraph>},
+      {"undirected/get_edges", ANY, benchGetEdges<graph::UndirectedGraph>},
+      {"directed/get_adjacent_edges", ANY, benchGetAdjacentEdges<graph::DirectedGraph>},
+      {"undirected/get_adjacent_edges", ANY, benchGetAdjacentEdges<graph::UndirectedGraph>},
+      {"directed/bfs_forward", ANY, [](Context &ctx) {
+         auto g = randomDirected(ctx);
+         benchQueries(ctx, g, [&](const auto &from, const auto &to) { graph::algorithms::lowestLengthFBfs(g, from, to); });
+       }},
+      {"directed/bfs_backward", ANY, [](Context &ctx) {
+         auto g = randomDirected(ctx);
+         benchQueries(ctx, g, [&](const auto &from, const auto &to) { graph::algorithms::lowestLengthBBfs(g, from, to); });
+       }},
+      {"directed/lowest_cost_walk_floyd", 500, [](Context &ctx) {
+         auto g = randomDirected(ctx);
+         GraphService service(std::make_unique<graph::DirectedGraph>(g));
+         ctx.repetitions = std::min(ctx.repetitions, 3); // every query is cubic
+         ctx.vertices = g.getNrOfVertices();
+         ctx.edges = g.getNrOfEdges();
+         for (int r = 0; r < ctx.repetitions; ++r) {
+           auto pair = randomPairs(ctx.size, ctx.rng).front();
+           ctx.recorder.measure(1, [&]() { service.findLowestCostWalk(pair.first, pair.second); });
+         }
+       }},
+      {"directed/lowest_cost_walk_ch", ANY, [](Context &ctx) {
+         auto g = randomDirected(ctx);
+         GraphService service(std::make_unique<graph::DirectedGraph>(g));
+         service.buildContractionHierarchy();
+         benchQueries(ctx, g, [&](const auto &from, const auto &to) { service.findLowestCostWalk(from, to); });
+       }},
+      {"directed/topological_order", ANY, [](Context &ctx) {
+         const auto g = makeGraph<graph::DirectedGraph>(ctx.size, randomEdges(ctx.size, (std::size_t)ctx.size * EDGES_PER_VERTEX, ctx.rng, true), ctx.rng);
+         ctx.vertices = g.getNrOfVertices();
+         ctx.edges = g.getNrOfEdges();
+         for (int r = 0; r < ctx.repetitions; ++r)
+           ctx.recorder.measure(ctx.edges, [&]() { graph::algorithms::getTopologicalOrder(g); });
+       }},
+      {"undirected/connected_components", ANY, [](Context &ctx) {
+         // about one edge per vertex leaves many components
+         const auto g = makeGraph<graph::UndirectedGraph>(ctx.size, randomEdges(ctx.size, ctx.size, ctx.rng), ctx.rng);
+         ctx.vertices = g.getNrOfVertices();
+         ctx.edges = g.getNrOfEdges();
+         for (int r = 0; r < ctx.repetitions; ++r)
+           ctx.recorder.measure(ctx.edges, [&]() { graph::algorithms::getConnectedComponentsDFS(g); });
+       }},
+      {"activity/compute_schedule", ANY, [](Context &ctx) {
+         auto g = makeActivityGraph(ctx);
+         ctx.vertices = g.getNrOfVertices();
+         ctx.edges = g.getNrOfEdges();
+         for (int r = 0; r < ctx.repetitions; ++r)
+           ctx.recorder.measure(ctx.edges, [&]() {
+             if (!g.computeSchedule())
+               throw std::runtime_error("The activity graph has a cycle");
+           });
+       }},
+      {"io/save_graph", ANY, benchSaveGraph},
+      {"io/load_graph", ANY, benchLoadGraph},
+  };
+}
+
+std::vector<int> parseSizes(const std::string &text) {
+  std::vector<int> sizes;
+  std::stringstream stream(text);
+  std::string token;
+  while (std::getline(stream, token, ','))
+    sizes.push_back(std::stoi(token));
+  return sizes;
+}
+
+std::string formatRate(double rate) {
+  char buffer[32];
+  if (rate >= 1e6)
+    std::snprintf(buffer, sizeof(buffer), "%.2fM/s", rate / 1e6);
+  else if (rate >= 1e3)
+    std::snprintf(buffer, sizeof(buffer), "%.2fK/s", rate / 1e3);
+  else
+    std::snprintf(buffer, sizeof(buffer), "%.2f/s", rate);
+  return buffer;
+}
+
+// Prints the change of every benchmark that is also in the baseline file
+void compare(const std::vector<bench::Result> &results, const std::string &baselinePath) {
+  std::ifstream fin(baselinePath);
+  if (!fin.is_open())
+    throw std::runtime_error("Could not open file '" + baselinePath + "' for reading");
+  std::map<std::pair<std::string, int>, std::pair<double, double>> baseline; // throughput, p50
+  std::string line;
+  while (std::getline(fin, line)) {
+    const std::string name = bench::jsonString(line, "name");
+    if (!name.empty())
+      baseline[{name, (int)bench::jsonNumber(line, "size")}] = {bench::jsonNumber(line, "itemsPerSecond"), bench::jsonNumber(line, "p50")};
+  }
+
+  std::printf("\n%-36s %8s %12s %12s\n", "compared to baseline", "size", "throughput", "p50 latency");
+  for (const auto &r : results) {
+    auto it = baseline.find({r.name, r.size});
+    if (it == baseline.end())
+      continue;
+    const auto &[throughput, p50] = it->second;
+    std::printf("%-36s %8d %+11.1f%% %+11.1f%%\n", r.name.c_str(), r.size,
+                throughput > 0 ? (r.itemsPerSecond / throughput - 1) * 100 : 0.0,
+                p50 > 0 ? (r.p50Ns / p50 - 1) * 100 : 0.0);
+  }
+}
+
+void printUsage() {
+  std::cout << "Usage: graph_bench [--sizes 200,2000,20000] [--repetitions 5] [--seed 42] [--filter <text>]\n"
+               "                   [--json <file_path>] [--compare <baseline.json>] [--list]\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::vector<int> sizes{200, 2000, 20000};
+  int repetitions = 5;
+  unsigned seed = 42;
+  std::string filter, jsonPath, baselinePath;
+  bool list = false;
+
+  try {
+    for (int i = 1; i < argc; ++i) {
+      const std::string arg = argv[i];
+      auto value = [&]() -> std::string {
+        if (i + 1 >= argc)
+          throw std::runtime_error(arg + " needs a value");
+        return argv[++i];
+      };
+      if (arg == "--sizes")
+        sizes = parseSizes(value());
+      else if (arg == "--repetitions")
+        repetitions = std::max(1, std::stoi(value()));
+      else if (arg == "--seed")
+        seed = std::stoul(value());
+      else if (arg == "--filter")
+        filter = value();
+      else if (arg == "--json")
+        jsonPath = value();
+      else if (arg == "--compare")
+        baselinePath = value();
+      else if (arg == "--list")
+        list = true;
+      else {
+        printUsage();
+        return arg == "--help" ? 0 : 1;
+      }
+    }
+
+    const auto benchmarks = getBenchmarks();
+    if (list) {
+      for (const auto &benchmark : benchmarks)
+        std::cout << benchmark.name << "\n";
+      return 0;
+    }
+
+    std::vector<bench::Result> results;
+    std::printf("build type: %s, seed: %u, repetitions: %d\n\n", GRAPH_BENCH_BUILD_TYPE, seed, repetitions);
+    std::printf("%-36s %8s %9s %12s %10s %10s %10s %10s\n", "benchmark", "size", "samples", "throughput", "p50 ns", "p90 ns",
+                "p99 ns", "peak RSS");
+    for (const auto &benchmark : benchmarks) {
+      if (!filter.empty() && benchmark.name.find(filter) == std::string::npos)
+        continue;
+      for (int size : sizes) {
+        if (size > benchmark.maxSize)
+          continue;
+        // every benchmark gets its own generator, so the graphs do not depend on which ones ran before
+        Context ctx{size, repetitions, std::mt19937(seed ^ (unsigned)std::hash<std::string>()(benchmark.name) ^ size)};
+        const long peakBefore = bench::getPeakRssKb();
+        benchmark.run(ctx);
+        results.push_back(bench::summarize(benchmark.name, size, ctx.vertices, ctx.edges, ctx.recorder, peakBefore));
+        const auto &r = results.back();
+        std::printf("%-36s %8d %9zu %12s %10.0f %10.0f %10.0f %8ldMB\n", r.name.c_str(), r.size, r.samples,
+                    formatRate(r.itemsPerSecond).c_str(), r.p50Ns, r.p90Ns, r.p99Ns, r.peakRssKb / 1024);
+        std::fflush(stdout);
+      }
+    }
+
+    if (!jsonPath.empty()) {
+      std::ofstream fout(jsonPath);
+      if (!fout.is_open())
+        throw std::runtime_error("Could not open file '" + jsonPath + "' for writing");
+      fout << "{\"buildType\": \"" << GRAPH_BENCH_BUILD_TYPE << "\", \"seed\": " << seed << ", \"repetitions\": " << repetitions
+           << ", \"benchmarks\": [\n";
+      for (std::size_t i = 0; i < results.size(); ++i)
+        fout << bench::toJson(results[i]) << (i + 1 < results.size() ? ",\n" : "\n");
+      fout << "]}\n";
+    }
+    if (!baselinePath.empty())
+      compare(results, baselinePath);
+  } catch (const std::exception &e) {
+    std::cerr << "Error: " << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
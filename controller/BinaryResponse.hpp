@@ -0,0 +1,49 @@
+#pragma once
+#include "../graph/abstract/edges/Edge.hpp"
+#include "../graph/utils/BinaryIO.hpp"
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Binary encodings of the list responses, for the server clients that ask for them.
+// Native byte order (the server only listens locally). A string is a uint32 length and its bytes.
+
+// uint32 number of ids, the ids, uint32 number of edges, then (uint32 from, uint32 to, int32 weight)
+// for every edge, from and to being positions in the id table
+inline std::string encodeEdges(const std::vector<graph::Edge> &edges) {
+  std::unordered_map<graph::idT, std::uint32_t> position;
+  std::vector<const graph::idT *> ids;
+  std::vector<std::uint32_t> endpoints;
+  endpoints.reserve(2 * edges.size());
+  for (const auto &edge : edges)
+    for (const graph::idT *id : {&edge.fromId, &edge.toId}) {
+      auto [it, inserted] = position.try_emplace(*id, ids.size());
+      if (inserted)
+        ids.push_back(id);
+      endpoints.push_back(it->second);
+    }
+
+  std::ostringstream out;
+  graph::utils::writePod<std::uint32_t>(out, ids.size());
+  for (const graph::idT *id : ids)
+    graph::utils::writeString(out, *id);
+  graph::utils::writePod<std::uint32_t>(out, edges.size());
+  for (std::size_t e = 0; e < edges.size(); ++e) {
+    graph::utils::writePod<std::uint32_t>(out, endpoints[2 * e]);
+    graph::utils::writePod<std::uint32_t>(out, endpoints[2 * e + 1]);
+    graph::utils::writePod<std::int32_t>(out, edges[e].weight);
+  }
+  return out.str();
+}
+
+// uint32 number of vertices, the vertex ids in order, int32 cost (an empty path has cost 0)
+inline std::string encodePath(const std::vector<graph::idT> &path, int cost) {
+  std::ostringstream out;
+  graph::utils::writePod<std::uint32_t>(out, path.size());
+  for (const auto &id : path)
+    graph::utils::writeString(out, id);
+  graph::utils::writePod<std::int32_t>(out, path.empty() ? 0 : cost);
+  return out.str();
+}
@@ -1,11 +1,38 @@
 #include "CommandController.hpp"
+#include "BinaryResponse.hpp"
 #include "../errors/InvalidInputError.cpp"
 #include "../graph/vertices/StringVertex.hpp"
 #include "ActivityGraph.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
 #include <memory>
 #include <string>
 #include <format>
 
+// Reports the progress of a semi-external algorithm on stderr, at most once a second
+static graph::algorithms::ExternalProgressCallback reportProgress(const std::string &command) {
+  auto last = std::make_shared<std::chrono::steady_clock::time_point>(std::chrono::steady_clock::now());
+  return [command, last](const graph::algorithms::ExternalProgress &progress) {
+    const auto now = std::chrono::steady_clock::now();
+    if (now - *last < std::chrono::seconds(1))
+      return;
+    *last = now;
+    std::cerr << std::format("{}: step {}, {} of {} edges read, {} in {} reads\n", command, progress.step,
+                             progress.edgesRead, progress.nrOfEdges,
+                             graph::utils::MemoryReport::formatBytes(progress.io.bytesRead), progress.io.nrOfReads);
+  };
+}
+
+
+// "Read 25.30 MB in 12 reads (1.62 passes over the edges)"
+static std::string describeIo(const graph::compact::GraphFileReader::IoStats &io) {
+  return std::format("Read {} in {} reads ({:.2f} passes over the edges)",
+                     graph::utils::MemoryReport::formatBytes(io.bytesRead), io.nrOfReads,
+                     io.edgeBytes == 0 ? 0.0 : (double)io.bytesRead / io.edgeBytes);
+}
+
+
 CommandController::CommandController(Console& console, GraphService& graphService)
   : graphService(graphService) {
 
@@ -19,7 +46,20 @@ CommandController::CommandController(Console& console, GraphService& graphServic
     }
     commandsMan = commandsMan.substr(0, commandsMan.length() - 1); // eliminate the last new line
     return {commandsMan};
-  });
+  }, CommandAccess::Read);
+
+  console.documentCommand("stats", "Shows the call counts, errors and latencies of the commands: stats [json|reset]");
+  console.registerCommand("stats", [&](const auto& args) -> CommandResult {
+    if (args.size() > 2 || (args.size() == 2 && args[1] != "json" && args[1] != "reset"))
+      throw InvalidUsageError("Usage: stats [json|reset]");
+    if (args.size() == 2 && args[1] == "reset") {
+      console.getStats().reset();
+      return {"Statistics reset."};
+    }
+    if (args.size() == 2)
+      return {console.getStats().toJson()};
+    return {console.getStats().toString()};
+  }, CommandAccess::Read);
 
   console.documentCommand("exit", "Exits the program");
   console.registerCommand("exit", [&](const auto& args) -> CommandResult {
@@ -54,7 +94,7 @@ CommandController::CommandController(Console& console, GraphService& graphServic
 
     const graph::idT vertexId = args[1];
     return {std::format("Vertex {} is {}in the graph.", vertexId, graphService.isVertex(vertexId) ? "" : "not ")};
-  });
+  }, CommandAccess::Read);
 
   console.documentCommand("add_edge", "Adds an edge between two existing vertices to the graph");
   console.registerCommand("add_edge", [&](const auto& args) -> CommandResult {
@@ -103,22 +143,36 @@ CommandController::CommandController(Console& console, GraphService& graphServic
                         graphService.isEdge(fromVertexId, toVertexId) ? "" : " not"
                         )
     };
-  });
+  }, CommandAccess::Read);
 
 
   console.documentCommand("list_vertices", "Display all the vertices in the current graph");
   console.registerCommand("list_vertices", [&](const auto& args) -> CommandResult {
     if (args.size() != 1)
       throw InvalidUsageError("Usage: list_vertices");
-    std::vector<graph::VertexSharedPtr> vertices = graphService.getVertices();
-    if (vertices.empty())
+    const auto pinned = graphService.snapshot();
+    const graph::Graph &graph = pinned.getGraph();
+    console.beginOutput();
+    if (auto mapped = pinned.getMappedGraph(); mapped && mapped->getNrOfVertices() > 0) {
+      const graph::compact::MappedGraph::SequentialScan scan(*mapped);
+      auto &out = console.output();
+      out.write(mapped->getNrOfVertices() > 1 ? "The vertices in the graph are:" : "The vertex in the graph is:");
+      for (int v = 0; v < mapped->getNrOfVertices(); ++v) {
+        out.put('\n');
+        out.write(mapped->getId(v));
+      }
+      return {};
+    }
+    if (graph.getNrOfVertices() == 0)
       return {"The graph contains no vertices!"};
-    std::string output = (vertices.size() > 1 ? "The vertices in the graph are:\n" : "The vertex in the graph is:\n");
-    for (const auto &vertex : vertices)
-      output += vertex->toString() + "\n";
-    output = output.substr(0, output.size() - 1); // eliminate the last newline character
-    return {output};
-  });
+    auto &out = console.output();
+    out.write(graph.getNrOfVertices() > 1 ? "The vertices in the graph are:" : "The vertex in the graph is:");
+    for (const auto &[_, vertex] : graph) {
+      out.put('\n');
+      out.write(vertex->toString());
+    }
+    return {};
+  }, CommandAccess::Read);
 
   console.documentCommand("get_project_info", "Display all the information for the current project (only ActivityGraph)");
   console.registerCommand("get_project_info", [&](const auto& args) -> CommandResult {
@@ -126,20 +180,27 @@ CommandController::CommandController(Console& console, GraphService& graphServic
       throw InvalidUsageError("Usage: get_project_info");
     if (graphService.getGraphType() != graph::GraphType::Activity)
       throw InvalidUsageError("get_project_info only works with ActivityGraph!");
-    std::string output = "";
-    output += "Total project time: " + std::to_string(graphService.getTotalProjectTime()) + "\n";
-    output += "Critical activities: ";
-    for (const auto &criticalActivityId : graphService.getCriticalActivities())
-      output += criticalActivityId + " ";
-    output += "\n";
-    std::vector<graph::VertexSharedPtr> vertices = graphService.getVertices();
-    if (vertices.empty())
+    const int totalProjectTime = graphService.getTotalProjectTime();
+    const auto criticalActivities = graphService.getCriticalActivities();
+    const auto pinned = graphService.snapshot();
+    const graph::Graph &graph = pinned.getGraph();
+    console.beginOutput();
+    if (graph.getNrOfVertices() == 0)
       return {"The graph contains no vertices!"};
-    output += "The Activities are: \n";
-    for (const auto &vertex : vertices)
-      output += vertex->toString() + "\n";
-    output = output.substr(0, output.size() - 1); // eliminate the last newline character
-    return {output};
+    auto &out = console.output();
+    out.write("Total project time: ");
+    out.write(totalProjectTime);
+    out.write("\nCritical activities: ");
+    for (const auto &criticalActivityId : criticalActivities) {
+      out.write(criticalActivityId);
+      out.put(' ');
+    }
+    out.write("\nThe Activities are: ");
+    for (const auto &[_, vertex] : graph) {
+      out.put('\n');
+      out.write(vertex->toString());
+    }
+    return {};
   });
 
   console.documentCommand("list_adj", "Display all the vertices adjacent with the given vertex");
@@ -149,6 +210,9 @@ CommandController::CommandController(Console& console, GraphService& graphServic
 
     graph::idT vertexId = args[1];
     std::vector<graph::Edge> edges = graphService.getAdjacentEdges(vertexId);
+    console.beginOutput();
+    if (console.wantsBinary())
+      return {encodeEdges(edges), false, true};
     if (edges.empty())
       return {"The vertex is isolated!"};
     std::string verticesSeparator = "--";
@@ -162,65 +226,407 @@ CommandController::CommandController(Console& console, GraphService& graphServic
     for (const auto &[_, toId, cost] : edges)
       output += verticesSeparator + " " + toId + " (" + std::to_string(cost) + ")\n";
     output = output.substr(0, output.size() - 1); // eliminate the last newline character
-    return {};
-  });
+    return {output};
+  }, CommandAccess::Read);
   
 
-  console.documentCommand("list_edges", "Display all the edges in the graph");
+  console.documentCommand("list_edges", "Display the edges in the graph, all of them or a page:\n"
+                                        "    list_edges [limit=<count>] [offset=<count>] [after=<token>]: the listing\n"
+                                        "    goes on from the token a page ends with, on the graph it started on");
   console.registerCommand("list_edges", [&](const auto& args) -> CommandResult {
-    if (args.size() != 1)
-      throw InvalidUsageError("Usage: list_edges");
-    std::vector<graph::Edge> edges = graphService.getEdges();
-    if (edges.empty())
-      return {"The graph contains no edges!"};
-    std::string verticesSeparator = "--";
-    if (graphService.getGraphType() == graph::GraphType::Directed || graphService.getGraphType() == graph::GraphType::Activity) 
-      verticesSeparator = "->";
-    std::string output = "The edges are:\n";
-    for (const auto &[fromId, toId, cost] : edges)
-      output += fromId + " " + verticesSeparator + " " + toId + " (" + std::to_string(cost) + ")\n";
-    output = output.substr(0, output.size() - 1); // eliminate the last newline character
-    return {output};
-  });
+    std::size_t limit = 0, offset = 0;
+    std::string token;
+    for (std::size_t i = 1; i < args.size(); ++i) {
+      const std::string &arg = args[i];
+      const auto separator = arg.find('=');
+      const std::string key = arg.substr(0, separator), value = separator == std::string::npos ? "" : arg.substr(separator + 1);
+      if ((key == "limit" || key == "offset") && !value.empty()) {
+        const unsigned long long count = std::stoull(value);
+        if (value.find('-') != std::string::npos || (key == "limit" && count == 0))
+          throw std::runtime_error("The " + key + " must be a count" + (key == "limit" ? " above 0" : ""));
+        (key == "limit" ? limit : offset) = count;
+      } else if (key == "after" && !value.empty())
+        token = value;
+      else
+        throw InvalidUsageError("Usage: list_edges [limit=<count>] [offset=<count>] [after=<token>]");
+    }
+
+    const bool paged = limit != 0 || offset != 0 || !token.empty();
+    std::vector<graph::Edge> edges; // for the binary encoding only
+    auto &out = console.output();
+    auto page = graphService.visitEdges(token, offset, limit, [&](graph::GraphType graphType,
+                                                                  std::size_t nrOfEdges) -> graph::EdgeVisitor {
+      console.beginOutput(); // the edges are formatted as they are visited
+      if (console.wantsBinary())
+        return [&](const graph::idT &fromId, const graph::idT &toId, int cost) { edges.emplace_back(fromId, toId, cost); };
+      if (nrOfEdges == 0 && !paged) {
+        out.write("The graph contains no edges!");
+        return {};
+      }
+      out.write("The edges are:");
+      const std::string_view verticesSeparator = graphType == graph::GraphType::Undirected ? " -- " : " -> ";
+      return [&out, verticesSeparator](const graph::idT &fromId, const graph::idT &toId, int cost) {
+        out.put('\n');
+        out.write(fromId);
+        out.write(verticesSeparator);
+        out.write(toId);
+        out.write(" (");
+        out.write(cost);
+        out.put(')');
+      };
+    });
+    if (console.wantsBinary())
+      return {encodeEdges(edges), false, true};
+    if (!page.nextToken.empty())
+      out.write("\nNext page: after=" + page.nextToken);
+    return {};
+  }, CommandAccess::Read);
 
-  console.documentCommand("load_graph", "Loads a graph from a file");
+  console.documentCommand("load_graph", "Loads a graph from a file: load_graph <directed|undirected|activity|mapped> <file_path>\n"
+                                        "    mapped: maps a file save_graph mapped wrote, read only, its pages are read on demand");
   console.registerCommand("load_graph", [&](const auto& args) -> CommandResult {
     if (args.size() != 3)
-      throw InvalidUsageError("Usage: load_graph <graph_type> <file_path>");
+      throw InvalidUsageError("Usage: load_graph <directed|undirected|activity|mapped> <file_path>");
     std::string graphType = args[1];
     std::string path = args[2];
     graphService.loadGraph(path, graphType);
     return {"Graph loaded successfully"};
   });
 
-  console.documentCommand("save_graph", "Saves the graph to file");
+  console.documentCommand("save_graph", "Saves the graph to file: save_graph [file_path]\n"
+                                        "    save_graph mapped <file_path>: the directed graph as a binary file for load_graph mapped\n"
+                                        "    save_graph header <file_path>: the vertices renumbered 0..n-1 under a "
+                                        "'vertex_count edge_count' line");
   console.registerCommand("save_graph", [&](const auto& args) -> CommandResult {
+    if (args.size() == 3 && args[1] == "mapped") {
+      graphService.saveMappedGraph(args[2]);
+      return {"Graph saved successfully"};
+    }
+    if (args.size() == 3 && args[1] == "header") {
+      graphService.saveGraph(args[2], true);
+      return {"Graph saved successfully"};
+    }
     if (args.size() != 2 && args.size() != 1)
-      throw InvalidUsageError("Usage: save_graph [file_path]");
+      throw InvalidUsageError("Usage: save_graph [file_path] | save_graph <mapped|header> <file_path>");
     std::string path = "graph.txt";
     if (args.size() == 2)
       path = args[1];
     graphService.saveGraph(path);
     return {"Graph saved successfully"};
+  }, CommandAccess::Read);
+
+  console.documentCommand("open_log", "Logs every change to a directory, so that the graph survives a crash without "
+                                      "save_graph: open_log <directory> [sync=<ms>] [checkpoint=<MB>]\n"
+                                      "    recovers the graph of the directory when it has one, otherwise starts from the current graph;\n"
+                                      "    sync=0 (default): a change returns once it is on disk, sync=<ms>: synced every <ms>\n"
+                                      "    milliseconds, a crash loses at most that; checkpoint: log size between checkpoints (64)");
+  console.registerCommand("open_log", [&](const auto& args) -> CommandResult {
+    if (args.size() < 2 || args.size() > 4)
+      throw InvalidUsageError("Usage: open_log <directory> [sync=<ms>] [checkpoint=<MB>]");
+    MutationLog::Options options;
+    for (std::size_t i = 2; i < args.size(); ++i) {
+      const std::string &arg = args[i];
+      const auto separator = arg.find('=');
+      const std::string key = arg.substr(0, separator), value = separator == std::string::npos ? "" : arg.substr(separator + 1);
+      if (key == "sync" && !value.empty())
+        options.syncIntervalMs = std::max(0, std::stoi(value));
+      else if (key == "checkpoint" && !value.empty()) {
+        const unsigned long long megabytes = std::stoull(value);
+        if (value.find('-') != std::string::npos || megabytes > (SIZE_MAX >> 20))
+          throw std::runtime_error("The checkpoint size must be between 1 and " + std::to_string(SIZE_MAX >> 20) + " MB");
+        options.checkpointBytes = std::max<std::size_t>(1, megabytes) << 20;
+      }
+      else
+        throw InvalidUsageError("Unknown option '" + arg + "'");
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const auto recovery = graphService.openLog(args[1], options);
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    if (!recovery.fromCheckpoint)
+      return {std::format("Logging the changes to {}, the current graph is its checkpoint", args[1])};
+    std::string output = std::format("Recovered the graph of {} in {}: checkpoint at change {}, {} changes replayed, "
+                                     "last change {}", args[1], formatDuration(elapsed.count()),
+                                     recovery.checkpointLsn, recovery.nrOfReplayed, recovery.lastLsn);
+    if (recovery.truncatedBytes > 0)
+      output += std::format("\nCut off a partial record of {} bytes at the end of the log", recovery.truncatedBytes);
+    return {output};
+  });
+
+  console.documentCommand("checkpoint", "Writes the graph as the checkpoint of the log and deletes the log segments it covers");
+  console.registerCommand("checkpoint", [&](const auto& args) -> CommandResult {
+    if (args.size() != 1)
+      throw InvalidUsageError("Usage: checkpoint");
+    const auto start = std::chrono::steady_clock::now();
+    const std::uint64_t lsn = graphService.checkpoint();
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return {std::format("Checkpoint at change {} written in {}", lsn, formatDuration(elapsed.count()))};
+  });
+
+  console.documentCommand("close_log", "Syncs the log and stops logging the changes");
+  console.registerCommand("close_log", [&](const auto& args) -> CommandResult {
+    if (args.size() != 1)
+      throw InvalidUsageError("Usage: close_log");
+    graphService.closeLog();
+    return {"Log closed"};
   });
 
-  console.documentCommand("get_connected_components", "Returns the connected components of the undirected graph");
+  console.documentCommand("log_stats", "Shows the state of the mutation log");
+  console.registerCommand("log_stats", [&](const auto& args) -> CommandResult {
+    if (args.size() != 1)
+      throw InvalidUsageError("Usage: log_stats");
+    const auto stats = graphService.getLogStats();
+    return {std::format("Last change: {}\nOn disk up to change: {}\nSyncs since open_log: {}\n"
+                        "Since the last checkpoint: {} in {} segments",
+                        stats.lastLsn, stats.durableLsn, stats.nrOfSyncs,
+                        graph::utils::MemoryReport::formatBytes(stats.bytesSinceCheckpoint), stats.nrOfSegments) +
+            (stats.nrOfFailedCheckpoints == 0 ? "" : std::format("\nFailed background checkpoints: {} (last: {})",
+                                                                 stats.nrOfFailedCheckpoints, stats.lastCheckpointError))};
+  }, CommandAccess::Read);
+
+  console.documentCommand("generate", "Generates a synthetic graph: generate <directed|undirected|activity> <model> <parameters...> "
+                                      "[seed=<seed>] [weights=<min>,<max>] [threads=<count>] [file=<file_path>]\n"
+                                      "    models: rmat <scale> <edge_factor> | erdos_renyi <nr_of_vertices> <nr_of_edges> |\n"
+                                      "            barabasi_albert <nr_of_vertices> <edges_per_vertex> | grid <rows> <cols> |\n"
+                                      "            layered_dag <layers> <width> <degree>\n"
+                                      "    with file=<file_path> the graph is only written to the file (in the load_graph format)");
+  console.registerCommand("generate", [&](const auto& args) -> CommandResult {
+    if (args.size() < 3)
+      throw InvalidUsageError("Usage: generate <directed|undirected|activity> <model> <parameters...> [seed=<seed>] "
+                              "[weights=<min>,<max>] [threads=<count>] [file=<file_path>]");
+    graph::generators::GeneratorOptions options;
+    std::vector<long long> parameters;
+    std::string path;
+    for (std::size_t i = 3; i < args.size(); ++i) {
+      const std::string &arg = args[i];
+      const auto separator = arg.find('=');
+      if (separator == std::string::npos) {
+        parameters.push_back(std::stoll(arg));
+        continue;
+      }
+      const std::string key = arg.substr(0, separator), value = arg.substr(separator + 1);
+      if (key == "seed")
+        options.seed = std::stoull(value);
+      else if (key == "threads")
+        options.nrThreads = std::max(1, std::stoi(value));
+      else if (key == "file")
+        path = value;
+      else if (key == "weights" && value.find(',') != std::string::npos) {
+        options.minWeight = std::stoi(value.substr(0, value.find(',')));
+        options.maxWeight = std::stoi(value.substr(value.find(',') + 1));
+      } else
+        throw InvalidUsageError("Unknown option '" + arg + "'");
+    }
+
+    if (!path.empty()) {
+      const std::size_t nrOfEdges = graphService.generateGraphFile(path, args[1], args[2], parameters, options);
+      return {std::format("Generated graph with {} edges written to {}", nrOfEdges, path)};
+    }
+    const std::size_t nrOfEdges = graphService.generateGraph(args[1], args[2], parameters, options);
+    return {std::format("Generated graph with {} vertices and {} edges", graphService.getVertices().size(), nrOfEdges)};
+  });
+
+  console.documentCommand("mem_stats", "Shows where the memory of the graph and of its caches and indexes goes\n"
+                                       "    mem_stats project <directed|undirected|activity> <nr_of_vertices> <nr_of_edges> [id_length]\n"
+                                       "    mem_stats file <directed|undirected|activity> <file_path>: projections before building a graph");
+  console.registerCommand("mem_stats", [&](const auto& args) -> CommandResult {
+    if (args.size() == 1)
+      return {graphService.getMemoryUsage().toString()};
+    if (args[1] == "project" && (args.size() == 5 || args.size() == 6)) {
+      const std::size_t idLength = args.size() == 6 ? std::stoull(args[5]) : 8;
+      return {"Projected:\n" + GraphService::projectMemoryUsage(args[2], std::stoull(args[3]), std::stoull(args[4]),
+                                                                 idLength).toString()};
+    }
+    if (args[1] == "file" && args.size() == 4)
+      return {"Projected:\n" + GraphService::projectLoadMemoryUsage(args[3], args[2]).toString()};
+    throw InvalidUsageError("Usage: mem_stats [project <graph_type> <nr_of_vertices> <nr_of_edges> [id_length] | "
+                            "file <graph_type> <file_path>]");
+  }, CommandAccess::Read);
+
+  console.documentCommand("memory_limit", "Shows or sets the memory (in MB) graph loads are refused beyond (off: the available memory)");
+  console.registerCommand("memory_limit", [&](const auto& args) -> CommandResult {
+    if (args.size() > 2)
+      throw InvalidUsageError("Usage: memory_limit [<megabytes>|off]");
+    if (args.size() == 2 && args[1] == "off")
+      graphService.setMemoryLimit(0);
+    else if (args.size() == 2) {
+      const unsigned long long megabytes = std::stoull(args[1]);
+      if (args[1].find('-') != std::string::npos || megabytes > (SIZE_MAX >> 20))
+        throw std::runtime_error("The memory limit must be between 0 and " + std::to_string(SIZE_MAX >> 20) + " MB");
+      graphService.setMemoryLimit(megabytes << 20);
+    }
+    if (graphService.getMemoryLimit() == 0)
+      return {"Loads are limited by the available memory"};
+    return {"Loads are limited to " + graph::utils::MemoryReport::formatBytes(graphService.getMemoryLimit())};
+  });
+
+  console.documentCommand("fork_branch", "Forks a what-if branch from the current graph and switches to it");
+  console.registerCommand("fork_branch", [&](const auto& args) -> CommandResult {
+    if (args.size() != 2)
+      throw InvalidUsageError("Usage: fork_branch <name>");
+    const auto start = std::chrono::steady_clock::now();
+    graphService.forkBranch(args[1]);
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return {std::format("Switched to the new branch {} (forked in {})", args[1], formatDuration(elapsed.count()))};
+  });
+
+  console.documentCommand("switch_branch", "Makes the commands work on another branch");
+  console.registerCommand("switch_branch", [&](const auto& args) -> CommandResult {
+    if (args.size() != 2)
+      throw InvalidUsageError("Usage: switch_branch <name>");
+    graphService.switchBranch(args[1]);
+    return {"Switched to branch " + args[1]};
+  });
+
+  console.documentCommand("discard_branch", "Drops a branch and the versions only it uses");
+  console.registerCommand("discard_branch", [&](const auto& args) -> CommandResult {
+    if (args.size() != 2)
+      throw InvalidUsageError("Usage: discard_branch <name>");
+    graphService.discardBranch(args[1]);
+    return {"Branch " + args[1] + " discarded."};
+  });
+
+  console.documentCommand("list_branches", "Lists the branches with the version, vertex and edge counts of their graphs");
+  console.registerCommand("list_branches", [&](const auto& args) -> CommandResult {
+    if (args.size() != 1)
+      throw InvalidUsageError("Usage: list_branches");
+    std::string output;
+    for (const auto &branch : graphService.getBranches())
+      output += std::format("{}{} {} (version {}, {} vertices, {} edges)", output.empty() ? "" : "\n",
+                            branch.current ? "*" : " ", branch.name, branch.version, branch.nrOfVertices,
+                            branch.nrOfEdges);
+    return {output};
+  });
+
+  console.documentCommand("compress_graph", "Keeps a read only compressed copy of the directed graph, for the queries that can use it");
+  console.registerCommand("compress_graph", [&](const auto& args) -> CommandResult {
+    if (args.size() != 1)
+      throw InvalidUsageError("Usage: compress_graph");
+    const auto report = graphService.compressGraph();
+    return {std::format("Compressed graph ({:.1f} bits per edge):\n{}",
+                        8.0 * report.getTotalBytes() / std::max<std::size_t>(1, report.nrOfEdges), report.toString())};
+  });
+
+  console.documentCommand("reorder_graph", "Renumbers the compact graph the parallel algorithms and the indexes use, "
+                                           "for locality: reorder_graph <insertion|degree|rcm|gorder>");
+  console.registerCommand("reorder_graph", [&](const auto& args) -> CommandResult {
+    if (args.size() != 2)
+      throw InvalidUsageError("Usage: reorder_graph <insertion|degree|rcm|gorder>");
+    const auto start = std::chrono::steady_clock::now();
+    const auto [before, after] = graphService.reorderGraph(args[1]);
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return {std::format("Reordered by {} in {}\n"
+                        "Average edge gap: {:.1f} -> {:.1f}\n"
+                        "Average log2 edge gap: {:.2f} -> {:.2f}\n"
+                        "Average neighbor gap: {:.1f} -> {:.1f}",
+                        args[1], formatDuration(elapsed.count()), before.averageEdgeGap, after.averageEdgeGap,
+                        before.averageLogEdgeGap, after.averageLogEdgeGap, before.averageNeighborGap,
+                        after.averageNeighborGap)};
+  });
+
+  console.documentCommand("get_connected_components", "Returns the connected components of the undirected graph "
+                                                      "(the weakly connected ones of a compressed directed graph)");
   console.registerCommand("get_connected_components", [&](const auto& args) -> CommandResult {
     if (args.size() != 1)
       throw InvalidUsageError("Usage: get_connected_components");
-    auto graphs = graphService.getConnectedComponentsOfUnorderedGraph();
-    std::string output = "";
+    auto components = graphService.getConnectedComponentsOfUnorderedGraph();
+    console.beginOutput();
+    auto &out = console.output();
     int connected_component_id = 1;
-    for (const auto &graph : graphs) {
-      output += "Component " + std::to_string(connected_component_id++) + "\n";
-      for (const auto &[vertexId, _] : graph) {
-        output += vertexId + " ";
+    for (const auto &component : components) {
+      if (connected_component_id > 1)
+        out.put('\n');
+      out.write("Component ");
+      out.write(connected_component_id++);
+      out.put('\n');
+      for (const auto &vertexId : component) {
+        out.write(vertexId);
+        out.put(' ');
       }
-      output += "\n";
     }
-    output = output.substr(0, output.length() - 1);
+    return {};
+  }, CommandAccess::Read);
+
+  console.documentCommand("external_bfs", "BFS levels from a vertex of a mapped graph file, streamed from the file without "
+                                          "loading it: external_bfs <file_path> <source> [output_file]");
+  console.registerCommand("external_bfs", [&](const auto& args) -> CommandResult {
+    if (args.size() != 3 && args.size() != 4)
+      throw InvalidUsageError("Usage: external_bfs <file_path> <source> [output_file]");
+    const auto result = GraphService::runExternalBfs(args[1], args[2], args.size() == 4 ? args[3] : "",
+                                                     reportProgress("external_bfs"));
+    return {std::format("Reached {} of {} vertices in {} levels\n{}", result.nrOfReached, result.level.size(),
+                        result.nrOfLevels, describeIo(result.io))};
+  }, CommandAccess::Read);
+
+  console.documentCommand("external_cc", "Weakly connected components of a mapped graph file, streamed from the file "
+                                         "without loading it: external_cc <file_path> [output_file]");
+  console.registerCommand("external_cc", [&](const auto& args) -> CommandResult {
+    if (args.size() != 2 && args.size() != 3)
+      throw InvalidUsageError("Usage: external_cc <file_path> [output_file]");
+    const auto result = GraphService::runExternalComponents(args[1], args.size() == 3 ? args[2] : "",
+                                                            reportProgress("external_cc"));
+    return {std::format("{} components, the largest has {} vertices\n{}", result.nrOfComponents,
+                        result.largestComponent, describeIo(result.io))};
+  }, CommandAccess::Read);
+
+  console.documentCommand("partition_graph", "Splits the directed graph into shard files <prefix>.0 .. <prefix>.<k-1> "
+                                             "for run_partitioned: partition_graph <k> <hash|greedy> <prefix>");
+  console.registerCommand("partition_graph", [&](const auto& args) -> CommandResult {
+    if (args.size() != 4)
+      throw InvalidUsageError("Usage: partition_graph <k> <hash|greedy> <prefix>");
+    const auto partition = graphService.partitionGraph(std::stoi(args[1]), args[2], args[3]);
+    std::string output = std::format("Wrote {} shards to {}.0 .. {}.{}\nEdge cut: {} of {} edges ({:.1f}%)",
+                                     partition.nrOfShards, args[3], args[3], partition.nrOfShards - 1,
+                                     partition.cutEdges, partition.nrOfEdges,
+                                     100.0 * partition.cutEdges / std::max<std::size_t>(1, partition.nrOfEdges));
+    for (int shard = 0; shard < partition.nrOfShards; ++shard)
+      output += std::format("\nShard {}: {} vertices, {} edges", shard, partition.shardVertices[shard],
+                            partition.shardEdges[shard]);
     return {output};
-  });
+  }, CommandAccess::Read);
+
+  console.documentCommand("run_partitioned", "Runs bfs, cc (weakly connected components) or sssp on the shards of "
+                                             "partition_graph in one worker process per shard, in supersteps: "
+                                             "run_partitioned <prefix> <bfs|cc|sssp> [source] [output_file]");
+  console.registerCommand("run_partitioned", [&](const auto& args) -> CommandResult {
+    const bool withSource = args.size() >= 3 && args[2] != "cc";
+    const std::size_t nrOfArgs = withSource ? 4 : 3; // without the output file
+    if (args.size() < 3 || args.size() < nrOfArgs || args.size() > nrOfArgs + 1)
+      throw InvalidUsageError("Usage: run_partitioned <prefix> <bfs|cc|sssp> [source] [output_file]");
+    const std::string output = args.size() > nrOfArgs ? args.back() : "";
+    const auto result = GraphService::runPartitioned(args[1], args[2], withSource ? args[3] : "", output);
+
+    std::string summary;
+    if (withSource) {
+      const auto reached = std::count_if(result.value.begin(), result.value.end(), [](std::int64_t value) {
+        return value != graph::distributed::PartitionedResult::UNREACHED;
+      });
+      summary = std::format("Reached {} of {} vertices", reached, result.value.size());
+    } else {
+      std::vector<std::size_t> sizes;
+      for (const std::int64_t component : result.value) {
+        if ((std::size_t)component >= sizes.size())
+          sizes.resize(component + 1, 0);
+        ++sizes[component];
+      }
+      summary = std::format("{} components, the largest has {} vertices", sizes.size(),
+                            sizes.empty() ? 0 : *std::max_element(sizes.begin(), sizes.end()));
+    }
+    summary += std::format("\n{} shards, edge cut {} of {} edges ({:.1f}%)", result.nrOfShards, result.cutEdges,
+                           result.nrOfEdges, 100.0 * result.cutEdges / std::max<std::uint64_t>(1, result.nrOfEdges));
+    std::uint64_t messages = 0, bytes = 0;
+    for (std::size_t step = 0; step < result.supersteps.size(); ++step) {
+      const auto &superstep = result.supersteps[step];
+      summary += std::format("\nSuperstep {}: {} active vertices, {} edges relaxed, {} messages ({}) in {}", step,
+                             superstep.activeVertices, superstep.edgesRelaxed, superstep.messages,
+                             graph::utils::MemoryReport::formatBytes(superstep.bytes),
+                             formatDuration(superstep.seconds * 1e9));
+      messages += superstep.messages;
+      bytes += superstep.bytes;
+    }
+    summary += std::format("\n{} supersteps, {} messages ({}) between the workers", result.supersteps.size(),
+                           messages, graph::utils::MemoryReport::formatBytes(bytes));
+    return {summary};
+  }, CommandAccess::Read);
 
   console.documentCommand("get_lowest_cost_walk", "Returns the lowest cost walk between two vertices");
   console.registerCommand("get_lowest_cost_walk", [&](const auto& args) -> CommandResult {
@@ -228,9 +634,12 @@ CommandController::CommandController(Console& console, GraphService& graphServic
       throw InvalidUsageError("Usage: get_shortest_path <start> <end>");
     const graph::idT startId = args[1];
     const graph::idT endId = args[2];
-    auto walkResult = graphService.getLowestCostWalk(startId, endId);
-    std::vector<std::string> cheapestPath = walkResult.first;
-    int cost = walkResult.second;
+    auto walkResult = graphService.findLowestCostWalk(startId, endId);
+    console.beginOutput();
+    if (console.wantsBinary())
+      return {encodePath(walkResult.path, walkResult.cost), false, true};
+    std::vector<std::string> cheapestPath = walkResult.path;
+    int cost = walkResult.cost;
     if (cheapestPath.size() == 0)
       return {"There is not path between " + startId + " and " + endId};
     std::string output = std::format("The shortest path between {} and {} is:\n", startId, endId);
@@ -238,30 +647,135 @@ CommandController::CommandController(Console& console, GraphService& graphServic
       output += vertex + " ";
     }
     output += "\nWith cost " + std::to_string(cost);
+    if (walkResult.settledVertices > 0)
+      output += "\nSettled " + std::to_string(walkResult.settledVertices) + " vertices";
     return {output};
+  }, CommandAccess::Read);
+
+  console.documentCommand("build_alt", "Builds the landmark (ALT) index used by get_lowest_cost_walk");
+  console.registerCommand("build_alt", [&](const auto& args) -> CommandResult {
+    if (args.size() != 2 && args.size() != 3)
+      throw InvalidUsageError("Usage: build_alt <nr_of_landmarks> [farthest|avoid = avoid]");
+    int nrLandmarks = std::stoi(args[1]);
+    std::string selection = "avoid";
+    if (args.size() == 3)
+      selection = args[2];
+    graphService.buildAltIndex(nrLandmarks, selection);
+    return {"ALT index built."};
+  });
+
+  console.documentCommand("save_alt", "Saves the ALT index to a file");
+  console.registerCommand("save_alt", [&](const auto& args) -> CommandResult {
+    if (args.size() != 2)
+      throw InvalidUsageError("Usage: save_alt <file_path>");
+    graphService.saveAltIndex(args[1]);
+    return {"ALT index saved successfully"};
+  }, CommandAccess::Read);
+
+  console.documentCommand("load_alt", "Loads an ALT index built for the current graph");
+  console.registerCommand("load_alt", [&](const auto& args) -> CommandResult {
+    if (args.size() != 2)
+      throw InvalidUsageError("Usage: load_alt <file_path>");
+    graphService.loadAltIndex(args[1]);
+    return {"ALT index loaded successfully"};
+  });
+
+  console.documentCommand("sssp", "Writes the shortest distances and parents from a source vertex to a file");
+  console.registerCommand("sssp", [&](const auto& args) -> CommandResult {
+    if (args.size() < 2 || args.size() > 4)
+      throw InvalidUsageError("Usage: sssp <source> [file_path = sssp.txt] [delta]");
+    const graph::idT sourceId = args[1];
+    std::string path = "sssp.txt";
+    if (args.size() >= 3)
+      path = args[2];
+    int delta = 0;
+    if (args.size() == 4)
+      delta = std::stoi(args[3]);
+    graphService.saveShortestPathTree(sourceId, path, delta);
+    return {"Shortest paths from " + sourceId + " saved to " + path};
+  }, CommandAccess::Read);
+
+  console.documentCommand("build_ch", "Builds the contraction hierarchy used by get_lowest_cost_walk");
+  console.registerCommand("build_ch", [&](const auto& args) -> CommandResult {
+    if (args.size() != 1)
+      throw InvalidUsageError("Usage: build_ch");
+    graphService.buildContractionHierarchy();
+    return {std::format("Contraction hierarchy built ({} shortcuts).", graphService.getNrOfShortcuts())};
   });
 
+  console.documentCommand("save_ch", "Saves the contraction hierarchy to a file");
+  console.registerCommand("save_ch", [&](const auto& args) -> CommandResult {
+    if (args.size() != 2)
+      throw InvalidUsageError("Usage: save_ch <file_path>");
+    graphService.saveContractionHierarchy(args[1]);
+    return {"Contraction hierarchy saved successfully"};
+  }, CommandAccess::Read);
+
+  console.documentCommand("load_ch", "Loads a contraction hierarchy built for the current graph");
+  console.registerCommand("load_ch", [&](const auto& args) -> CommandResult {
+    if (args.size() != 2)
+      throw InvalidUsageError("Usage: load_ch <file_path>");
+    graphService.loadContractionHierarchy(args[1]);
+    return {"Contraction hierarchy loaded successfully"};
+  });
+
+  console.documentCommand("can_reach", "Checks if there is a walk from one vertex to another");
+  console.registerCommand("can_reach", [&](const auto& args) -> CommandResult {
+    if (args.size() != 3)
+      throw InvalidUsageError("Usage: can_reach <from_vertex_id> <to_vertex_id>");
+    const graph::idT fromVertexId = args[1];
+    const graph::idT toVertexId = args[2];
+    return {std::format("{} can{} reach {}", fromVertexId, graphService.canReach(fromVertexId, toVertexId) ? "" : "not", toVertexId)};
+  }, CommandAccess::Read);
+
   console.documentCommand("get_topological_sort", "Returns the vertices topologically sorted");
   console.registerCommand("get_topological_sort", [&](const auto& args) -> CommandResult {
     if (args.size() != 1)
       throw InvalidUsageError("Usage: get_topological_sort");
+    const auto order = graphService.topologicalSort();
+    console.beginOutput();
     std::string output = "";
-    for (const auto &v : graphService.topologicalSort()) {
+    for (const auto &v : order) {
       output += v + " ";
     }
     if (output == "")
       return {"Unable to topologically sort!"};
     return {output};
-  });
+  }, CommandAccess::Read);
+
+  console.documentCommand("get_scc", "Returns the strongly connected components (in reverse topological order)");
+  console.registerCommand("get_scc", [&](const auto& args) -> CommandResult {
+    if (args.size() > 2 || (args.size() == 2 && args[1] != "parallel"))
+      throw InvalidUsageError("Usage: get_scc [parallel]");
+    const auto components = graphService.getStronglyConnectedComponents(args.size() == 2);
+    console.beginOutput();
+    std::string output = std::format("The graph has {} strongly connected components:", components.size());
+    for (std::size_t i = 0; i < components.size(); ++i) {
+      output += "\n" + std::to_string(i) + ":";
+      for (const auto &vertexId : components[i])
+        output += " " + vertexId;
+    }
+    return {output};
+  }, CommandAccess::Read);
+
+  console.documentCommand("save_condensation", "Saves the DAG of the strongly connected components (vertex i is component i of get_scc)");
+  console.registerCommand("save_condensation", [&](const auto& args) -> CommandResult {
+    if (args.size() < 2 || args.size() > 3 || (args.size() == 3 && args[2] != "parallel"))
+      throw InvalidUsageError("Usage: save_condensation <file_path> [parallel]");
+    graphService.saveCondensation(args[1], args.size() == 3);
+    return {"Condensation saved to " + args[1]};
+  }, CommandAccess::Read);
 
   console.documentCommand("get_mvc", "Returns the minimum vertex cover");
   console.registerCommand("get_mvc", [&](const auto& args) -> CommandResult {
     if (args.size() != 1)
       throw InvalidUsageError("Usage: get_mvc");
+    const auto cover = graphService.getMinimumVertexCover();
+    console.beginOutput();
     std::string output = "";
-    for (const auto &vId : graphService.getMinimumVertexCover()) {
+    for (const auto &vId : cover) {
       output += vId + " ";
     }
     return {output};
-  });
+  }, CommandAccess::Read);
 }
@@ -1,13 +1,21 @@
 #pragma once
+#include <cstdint>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include "../vertices/BaseVertex.hpp"
 #include "views/AdjacentEdgesView.hpp"
+#include "../utils/CowHashTable.hpp"
+#include <functional>
 #include <memory>
 
 namespace graph {
 
 using VertexSharedPtr = std::shared_ptr<BaseVertex>;
+// Copy-on-write tables: copying a graph shares them, and the copies diverge chunk by chunk as they change
+using VertexMap = utils::CowHashTable<std::unordered_map<idT, VertexSharedPtr>>;
+using AdjacencyMap = utils::CowHashTable<std::unordered_map<idT, utils::CowPtr<std::unordered_set<idT>>>>;
+using EdgeSet = utils::CowHashTable<std::unordered_set<Edge, EdgeHash>>;
 
 enum class GraphType {
   Directed,
@@ -17,10 +25,24 @@ enum class GraphType {
 
 class AdjacentEdgesView;
 
+// Where an enumeration of the edges (Graph::visitEdges) stopped. It stays valid as long as the graph it
+// was taken on does not change, which a snapshot guarantees.
+struct EdgeCursor {
+  std::size_t chunk = 0;
+  std::size_t offset = 0; // entries of the chunk already passed
+  idT neighbor; // an undirected graph stopped inside a neighbor list: the neighbor it resumes at
+  bool atEnd = false;
+  std::size_t endChunk = SIZE_MAX; // the enumeration ends before this chunk: a range for a parallel enumeration
+};
+
+using EdgeVisitor = std::function<void(const idT &fromId, const idT &toId, int weight)>;
+
 class Graph {
 public:
   virtual ~Graph() = default;
   virtual GraphType getGraphType() const = 0;
+  // A copy of the same type; it shares the storage of this graph until one of the two changes
+  virtual std::unique_ptr<Graph> clone() const = 0;
 
   virtual void addVertex(const VertexSharedPtr &v) = 0;
 
@@ -37,11 +59,19 @@ public:
   virtual int getEdgeWeight(const idT &fromId, const idT &toId) const = 0;
 
   virtual std::vector<Edge> getEdges() const = 0;
+  // Visits up to limit edges from cursor on, in the order getEdges lists them, and moves the cursor past
+  // them; without a visitor the edges are only skipped. Nothing is copied. Returns the number of edges passed.
+  virtual std::size_t visitEdges(EdgeCursor &cursor, std::size_t limit, const EdgeVisitor &visit) const = 0;
+  // The chunks visitEdges goes through; the ranges {chunk = first, endChunk = last} of them can be visited apart
+  virtual std::size_t getNrOfEdgeChunks() const = 0;
   virtual void clear() = 0;
 
-  virtual std::unordered_map<idT, VertexSharedPtr>::const_iterator begin() const = 0;
-  virtual std::unordered_map<idT, VertexSharedPtr>::const_iterator end() const = 0;
+  virtual VertexMap::const_iterator begin() const = 0;
+  virtual VertexMap::const_iterator end() const = 0;
 
   virtual AdjacentEdgesView getAdjacentEdges(const idT &id) const = 0;
+
+  // Byte level breakdown of the memory held by the graph
+  virtual utils::MemoryReport getMemoryUsage() const = 0;
 };
 } // namespace graph
@@ -1,71 +1,35 @@
 #include "DirectedGraphAlgorithms.hpp"
+#include "GenericAlgorithms.hpp"
+#include "../core/Adapters.hpp"
 #include "../directed_graph/DirectedGraph.hpp"
 #include "../directed_graph/iterators/Iterators.hpp"
+#include "../vertices/StringVertex.hpp"
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <span>
 #include <queue>
 #include <limits>
 #include <stdexcept>
 #include <string>
 #include <utility>
 #include <stack>
+#include <map>
+#include <tuple>
 
 namespace graph {
 namespace algorithms {
 
 int lowestLengthFBfs(graph::DirectedGraph &g, const idT &startId, const idT &endId) {
-  std::unordered_map<idT, bool> visited;
-  std::unordered_map<idT, int> distance; // Stores the shortest distance from start to each node
-  std::queue<idT> q;
-
-  distance[startId] = 0;
-  visited[startId] = true;
-  q.push(startId);
-  while (!q.empty()) {
-    const idT currentVertexId = q.front();
-    q.pop();
-
-    for (const auto &[_, toId, __] : g.initOutboundEdgesIt(currentVertexId)) {
-      // If we have reached the end node, return the distance
-      if (toId == endId)
-        return distance[currentVertexId] + 1;
-
-      if (!visited[toId]) {
-        visited[toId] = true;
-        distance[toId] = distance[currentVertexId] + 1;
-        q.push(toId);
-      }
-    }
-  }
-
-  return 999; // inf
+  return bfsLength(core::adapt(g), startId, endId).value_or(999); // 999 = inf
 }
 
 int lowestLengthBBfs(graph::DirectedGraph &g, const idT &startId, const idT &endId) {
-  std::unordered_map<idT, bool> visited;
-  std::unordered_map<idT, int> distance; // Stores the shortest distance from start to each node
-  std::queue<idT> q;
-
-  distance[endId] = 0;
-  visited[endId] = true;
-  q.push(endId);
-  while (!q.empty()) {
-    const idT currentVertex = q.front();
-    q.pop();
-
-    for (const auto &[_, toId, __] : g.initInboundEdgesIt(currentVertex)) {
-      // If we have reached the end node, return the distance
-      if (toId == startId)
-        return distance[currentVertex] + 1;
-
-      if (!visited[toId]) {
-        visited[toId] = true;
-        distance[toId] = distance[currentVertex] + 1;
-        q.push(toId);
-      }
-    }
-  }
-
-  return 999; // inf
+  // forward search from the end on the reversed edges
+  const auto adapter = core::adapt(g);
+  return bfsLength(core::ReversedGraph(adapter), endId, startId).value_or(999); // 999 = inf
 }
 
 // 3.6
@@ -169,34 +133,463 @@ struct ActivitiesData {
 };
 
 std::vector<idT> getTopologicalOrder(const graph::DirectedGraph &g) {
-  // Kahn's algorithm
-  graph::DirectedGraph aux = g;
-  std::vector<idT> sortedVertices;
-  std::stack<idT> startingVertices;
-  for (const auto &[vertexId, _] : aux) {
-    if (aux.initInboundEdgesIt(vertexId).begin() == aux.initInboundEdgesIt(vertexId).end()) { // no inbound edges
-      startingVertices.push(vertexId);
+  return topologicalOrder(core::adapt(g)).value_or(std::vector<idT>{}); // empty on a cycle
+}
+
+// Delta-stepping (Meyer & Sanders): vertices are kept in buckets of width delta.
+// The smallest non empty bucket is emptied by repeatedly relaxing the light edges
+// (weight <= delta) of its vertices, after which the heavy edges of every vertex
+// removed from the bucket are relaxed once.
+// Each relaxation phase runs in two parallel steps: the frontier is split between the
+// threads which generate relaxation requests, then every thread applies the requests
+// for the vertices it owns (vertex % nrThreads), so no two threads write the same entry.
+ShortestPathTree deltaSteppingShortestPaths(const compact::CompactGraph &g, int sourceIndex, int delta, unsigned nrThreads) {
+  const int n = g.getNrOfVertices();
+  if (sourceIndex < 0 || sourceIndex >= n)
+    throw std::runtime_error("Vertex not in the graph");
+  if (g.getMinEdgeWeight() < 0)
+    throw std::runtime_error("Delta-stepping requires non-negative edge weights");
+
+  if (delta <= 0) {
+    // the average edge weight keeps the number of light re-relaxations low
+    long long totalWeight = 0;
+    for (int v = 0; v < n; ++v)
+      for (int weight : g.getOutWeights(v))
+        totalWeight += weight;
+    delta = g.getNrOfEdges() == 0 ? 1 : std::max<long long>(1, totalWeight / (long long)g.getNrOfEdges());
+  }
+  nrThreads = std::max(1u, nrThreads);
+
+  ShortestPathTree tree;
+  tree.source = sourceIndex;
+  tree.vertexIds.reserve(n);
+  for (int v = 0; v < n; ++v)
+    tree.vertexIds.push_back(g.getId(v));
+  tree.distance.assign(n, ShortestPathTree::UNREACHABLE);
+  tree.parent.assign(n, -1);
+  std::vector<int> &distance = tree.distance;
+  std::vector<int> &parent = tree.parent;
+
+  struct Request {
+    int vertex;
+    int distance;
+    int parent;
+  };
+  // outbox[t][o] holds the requests generated by thread t for the vertices owned by thread o
+  std::vector<std::vector<std::vector<Request>>> outbox(nrThreads, std::vector<std::vector<Request>>(nrThreads));
+  std::vector<std::vector<int>> improved(nrThreads);
+  std::map<int, std::vector<int>> buckets;
+
+  auto relax = [&](const std::vector<int> &frontier, bool lightEdges) {
+    // small frontiers are not worth the thread start up
+    // (parallelForRange never starts more threads than there are items, so neither do we)
+    const unsigned threads = frontier.size() < 256 ? 1 : std::min<std::size_t>(nrThreads, frontier.size());
+    utils::parallelForRange(frontier.size(), threads, [&](unsigned t, std::size_t begin, std::size_t end) {
+      for (auto &requests : outbox[t])
+        requests.clear();
+      for (std::size_t i = begin; i < end; ++i) {
+        const int fromIndex = frontier[i];
+        const auto neighbors = g.getOutNeighbors(fromIndex);
+        const auto weights = g.getOutWeights(fromIndex);
+        for (std::size_t e = 0; e < neighbors.size(); ++e) {
+          if ((weights[e] <= delta) != lightEdges)
+            continue;
+          const int newDistance = distance[fromIndex] + weights[e];
+          if (newDistance < distance[neighbors[e]])
+            outbox[t][neighbors[e] % threads].push_back({neighbors[e], newDistance, fromIndex});
+        }
+      }
+    });
+    utils::runParallel(threads, [&](unsigned owner) {
+      improved[owner].clear();
+      for (unsigned t = 0; t < threads; ++t) {
+        for (const auto &request : outbox[t][owner]) {
+          if (request.distance < distance[request.vertex]) {
+            distance[request.vertex] = request.distance;
+            parent[request.vertex] = request.parent;
+            improved[owner].push_back(request.vertex);
+          }
+        }
+      }
+    });
+    for (unsigned owner = 0; owner < threads; ++owner)
+      for (int vertex : improved[owner])
+        buckets[distance[vertex] / delta].push_back(vertex);
+  };
+
+  distance[sourceIndex] = 0;
+  buckets[0].push_back(sourceIndex);
+
+  std::vector<int> seenInPhase(n, -1); // removes the duplicates from a bucket
+  std::vector<char> removed(n, 0);     // marks the vertices removed from the current bucket
+  std::vector<int> frontier;
+  std::vector<int> removedVertices;
+  int phase = 0;
+  while (!buckets.empty()) {
+    const int currentBucket = buckets.begin()->first;
+    removedVertices.clear();
+
+    // light edges may put vertices back in the current bucket
+    while (!buckets.empty() && buckets.begin()->first == currentBucket) {
+      std::vector<int> bucket = std::move(buckets.begin()->second);
+      buckets.erase(buckets.begin());
+
+      frontier.clear();
+      for (int vertex : bucket) {
+        if (distance[vertex] / delta != currentBucket || seenInPhase[vertex] == phase)
+          continue; // stale entry, the vertex moved to a lower bucket
+        seenInPhase[vertex] = phase;
+        frontier.push_back(vertex);
+        if (!removed[vertex]) {
+          removed[vertex] = 1;
+          removedVertices.push_back(vertex);
+        }
+      }
+      ++phase;
+      relax(frontier, true);
     }
+
+    relax(removedVertices, false);
+    for (int vertex : removedVertices)
+      removed[vertex] = 0;
   }
 
-  if (startingVertices.empty())
-    return {}; // cycle or empty
+  return tree;
+}
 
-  while (!startingVertices.empty()) {
-    auto fromId = startingVertices.top(); startingVertices.pop();
-    sortedVertices.push_back(fromId);
-    for (const auto &toId : aux.getAllOutboundVertices(fromId)) {
-      aux.removeEdge(fromId, toId);
-      if (aux.initInboundEdgesIt(toId).begin() == aux.initInboundEdgesIt(toId).end()) { // no inbound edges
-        startingVertices.push(toId);
+ShortestPathTree deltaSteppingShortestPaths(const graph::DirectedGraph &g, const idT &sourceId, int delta, unsigned nrThreads) {
+  compact::CompactGraph compactGraph(g);
+  return deltaSteppingShortestPaths(compactGraph, compactGraph.getIndex(sourceId), delta, nrThreads);
+}
+
+// Tarjan's algorithm with an explicit call stack instead of recursion.
+// Every frame remembers the vertex and how many of its outbound edges were already explored.
+// Only the vertices accepted by inScope are visited, every finished component is passed to
+// onComponent as a span of its vertices (in reverse topological order).
+// discovery must be -1 for the vertices in scope, the other scratch arrays are restored.
+template <typename InScope, typename OnComponent>
+static void tarjan(const compact::CompactGraph &g, std::span<const int> roots, InScope &&inScope, OnComponent &&onComponent,
+                   std::vector<int> &discovery, std::vector<int> &lowLink, std::vector<char> &onStack) {
+  std::vector<int> tarjanStack;
+  std::vector<std::pair<int, std::size_t>> callStack;
+  int time = 0;
+
+  for (int root : roots) {
+    if (discovery[root] != -1)
+      continue;
+    callStack.push_back({root, 0});
+    while (!callStack.empty()) {
+      auto &[vertex, nextEdge] = callStack.back();
+      if (nextEdge == 0 && discovery[vertex] == -1) {
+        discovery[vertex] = lowLink[vertex] = time++;
+        tarjanStack.push_back(vertex);
+        onStack[vertex] = 1;
+      }
+
+      const auto neighbors = g.getOutNeighbors(vertex);
+      if (nextEdge < neighbors.size()) {
+        const int next = neighbors[nextEdge++];
+        if (!inScope(next))
+          continue;
+        if (discovery[next] == -1)
+          callStack.push_back({next, 0}); // "recursive call", invalidates vertex and nextEdge
+        else if (onStack[next])
+          lowLink[vertex] = std::min(lowLink[vertex], discovery[next]);
+        continue;
+      }
+
+      // all the edges are explored: "return" to the parent
+      const int finished = vertex;
+      callStack.pop_back();
+      if (!callStack.empty())
+        lowLink[callStack.back().first] = std::min(lowLink[callStack.back().first], lowLink[finished]);
+
+      if (lowLink[finished] == discovery[finished]) {
+        const std::size_t first = std::find(tarjanStack.rbegin(), tarjanStack.rend(), finished).base() - tarjanStack.begin() - 1;
+        for (std::size_t i = first; i < tarjanStack.size(); ++i)
+          onStack[tarjanStack[i]] = 0;
+        onComponent(std::span<const int>(tarjanStack.data() + first, tarjanStack.size() - first));
+        tarjanStack.resize(first);
       }
     }
   }
+}
 
-  if (aux.getNrOfEdges() != 0)
-    return {}; // cycle
 
-  return sortedVertices;
+StronglyConnectedComponents getStronglyConnectedComponents(const compact::CompactGraph &g) {
+  const int n = g.getNrOfVertices();
+  StronglyConnectedComponents result;
+  result.component.assign(n, -1);
+
+  std::vector<int> discovery(n, -1);
+  std::vector<int> lowLink(n, 0);
+  std::vector<char> onStack(n, 0);
+  std::vector<int> roots(n);
+  for (int v = 0; v < n; ++v)
+    roots[v] = v;
+  tarjan(g, roots, [](int) { return true; }, [&](std::span<const int> members) {
+    for (int v : members)
+      result.component[v] = result.nrOfComponents;
+    ++result.nrOfComponents;
+  }, discovery, lowLink, onStack);
+  return result;
+}
+
+
+// Renumbers arbitrary component ids (0..nrOfComponents-1) in reverse topological order of the condensation
+static void orderComponents(const compact::CompactGraph &g, StronglyConnectedComponents &scc) {
+  const int n = g.getNrOfVertices();
+  std::vector<std::vector<int>> dagOut(scc.nrOfComponents);
+  std::vector<int> inDegree(scc.nrOfComponents, 0);
+  for (int v = 0; v < n; ++v)
+    for (int next : g.getOutNeighbors(v))
+      if (scc.component[v] != scc.component[next]) {
+        dagOut[scc.component[v]].push_back(scc.component[next]);
+        ++inDegree[scc.component[next]];
+      }
+
+  // Kahn: the i'th component in topological order gets the id nrOfComponents - 1 - i
+  std::vector<int> newId(scc.nrOfComponents);
+  std::vector<int> ready;
+  for (int c = 0; c < scc.nrOfComponents; ++c)
+    if (inDegree[c] == 0)
+      ready.push_back(c);
+  int position = 0;
+  while (!ready.empty()) {
+    int c = ready.back();
+    ready.pop_back();
+    newId[c] = scc.nrOfComponents - 1 - position++;
+    for (int next : dagOut[c])
+      if (--inDegree[next] == 0)
+        ready.push_back(next);
+  }
+  for (int &c : scc.component)
+    c = newId[c];
+}
+
+
+/*
+* Forward-backward SCC with trimming (Fleischer, Hendrickson, Pinar; McLendon et al.).
+* Every subproblem is a set of vertices closed under the strongly connected relation. Vertices
+* without an in or out neighbor in the set are components on their own and are trimmed first,
+* then the vertices both reachable from and reaching a random pivot form its component and the
+* rest splits into three independent subproblems (only forward, only backward, neither).
+* The subproblems are handed out to the threads from a shared queue; the small ones are solved
+* directly with Tarjan, since splitting them further costs more than it parallelizes.
+*/
+StronglyConnectedComponents getStronglyConnectedComponentsParallel(const compact::CompactGraph &g, unsigned nrThreads) {
+  const int n = g.getNrOfVertices();
+  StronglyConnectedComponents result;
+  result.component.assign(n, -1);
+  if (n == 0)
+    return result;
+
+  // part[v] is the subproblem v belongs to, -1 once its component is known.
+  // Only the thread solving a subproblem writes its vertices, the others just compare part[v] to their own id.
+  std::vector<std::atomic<int>> part(n);
+  for (auto &p : part)
+    p.store(0, std::memory_order_relaxed);
+  std::vector<int> inDegree(n), outDegree(n);
+  std::vector<char> reached(n, 0); // bit 1: forward from the pivot, bit 2: backward
+  std::vector<int> discovery(n, -1), lowLink(n, 0);
+  std::vector<char> onStack(n, 0);
+  const std::size_t sequentialSize = nrThreads <= 1 ? n : std::max<std::size_t>(4096, n / (8 * nrThreads));
+  std::atomic<int> nextComponent{0};
+  std::atomic<int> nextPart{1};
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<std::pair<int, std::vector<int>>> tasks;
+  std::size_t outstanding = 1; // queued or running
+  std::vector<int> all(n);
+  for (int v = 0; v < n; ++v)
+    all[v] = v;
+  tasks.push_back({0, std::move(all)});
+
+  auto solve = [&](int id, std::vector<int> &members) {
+    auto inPart = [&](int v) { return part[v].load(std::memory_order_relaxed) == id; };
+    auto settle = [&](int v) {
+      part[v].store(-1, std::memory_order_relaxed);
+      result.component[v] = nextComponent.fetch_add(1);
+    };
+
+    // trimming
+    std::vector<int> trimmed;
+    for (int v : members) {
+      inDegree[v] = outDegree[v] = 0;
+      for (int prev : g.getInNeighbors(v))
+        inDegree[v] += prev != v && inPart(prev);
+      for (int next : g.getOutNeighbors(v))
+        outDegree[v] += next != v && inPart(next);
+    }
+    for (int v : members)
+      if (inDegree[v] == 0 || outDegree[v] == 0) {
+        settle(v);
+        trimmed.push_back(v);
+      }
+    while (!trimmed.empty()) {
+      int v = trimmed.back();
+      trimmed.pop_back();
+      for (int next : g.getOutNeighbors(v))
+        if (inPart(next) && --inDegree[next] == 0) {
+          settle(next);
+          trimmed.push_back(next);
+        }
+      for (int prev : g.getInNeighbors(v))
+        if (inPart(prev) && --outDegree[prev] == 0) {
+          settle(prev);
+          trimmed.push_back(prev);
+        }
+    }
+    std::erase_if(members, [&](int v) { return !inPart(v); });
+    if (members.empty())
+      return;
+    if (members.size() <= sequentialSize) {
+      tarjan(g, members, inPart, [&](std::span<const int> component) {
+        const int componentId = nextComponent.fetch_add(1);
+        for (int v : component) {
+          part[v].store(-1, std::memory_order_relaxed);
+          result.component[v] = componentId;
+        }
+      }, discovery, lowLink, onStack);
+      return;
+    }
+
+    // forward and backward search from the pivot
+    std::mt19937 rng(id);
+    const int pivot = members[rng() % members.size()];
+    for (int direction = 1; direction <= 2; ++direction) {
+      std::vector<int> stack{pivot};
+      reached[pivot] |= direction;
+      while (!stack.empty()) {
+        int v = stack.back();
+        stack.pop_back();
+        for (int next : direction == 1 ? g.getOutNeighbors(v) : g.getInNeighbors(v))
+          if (inPart(next) && !(reached[next] & direction)) {
+            reached[next] |= direction;
+            stack.push_back(next);
+          }
+      }
+    }
+
+    const int component = nextComponent.fetch_add(1);
+    std::vector<int> subsets[3]; // index reached - 1 for the forward and backward only vertices, 2 for neither
+    for (int v : members) {
+      if (reached[v] == 3) {
+        part[v].store(-1, std::memory_order_relaxed);
+        result.component[v] = component;
+      } else
+        subsets[reached[v] == 0 ? 2 : reached[v] - 1].push_back(v);
+      reached[v] = 0;
+    }
+    for (auto &subset : subsets) {
+      if (subset.empty())
+        continue;
+      const int subsetId = nextPart.fetch_add(1);
+      for (int v : subset)
+        part[v].store(subsetId, std::memory_order_relaxed);
+      std::lock_guard<std::mutex> lock(mutex);
+      ++outstanding;
+      tasks.push_back({subsetId, std::move(subset)});
+      cv.notify_one();
+    }
+  };
+
+  utils::runParallel(std::max(1u, nrThreads), [&](unsigned) {
+    while (true) {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [&]() { return !tasks.empty() || outstanding == 0; });
+      if (tasks.empty())
+        return;
+      auto [id, members] = std::move(tasks.back());
+      tasks.pop_back();
+      lock.unlock();
+
+      solve(id, members);
+
+      lock.lock();
+      if (--outstanding == 0)
+        cv.notify_all();
+    }
+  });
+
+  result.nrOfComponents = nextComponent.load();
+  orderComponents(g, result);
+  return result;
+}
+
+
+graph::DirectedGraph getCondensation(const compact::CompactGraph &g, const StronglyConnectedComponents &scc) {
+  std::vector<std::tuple<int, int, int>> edges; // from component, to component, weight
+  for (int v = 0; v < g.getNrOfVertices(); ++v) {
+    const auto neighbors = g.getOutNeighbors(v);
+    const auto weights = g.getOutWeights(v);
+    for (std::size_t e = 0; e < neighbors.size(); ++e)
+      if (scc.component[v] != scc.component[neighbors[e]])
+        edges.push_back({scc.component[v], scc.component[neighbors[e]], weights[e]});
+  }
+  std::sort(edges.begin(), edges.end());
+
+  graph::DirectedGraph condensation;
+  for (int c = 0; c < scc.nrOfComponents; ++c)
+    condensation.addVertex(std::make_shared<graph::StringVertex>(std::to_string(c)));
+  for (std::size_t i = 0; i < edges.size(); ++i) {
+    const auto &[from, to, weight] = edges[i];
+    if (i == 0 || std::get<0>(edges[i - 1]) != from || std::get<1>(edges[i - 1]) != to) // the lowest weight comes first
+      condensation.addEdge(std::to_string(from), std::to_string(to), weight);
+  }
+  return condensation;
+}
+
+
+std::vector<std::vector<idT>> findCycles(const graph::DirectedGraph &g, std::size_t maxNrOfCycles) {
+  const compact::CompactGraph compact(g);
+  const auto scc = getStronglyConnectedComponents(compact);
+  const int n = compact.getNrOfVertices();
+
+  std::vector<std::vector<idT>> cycles;
+  std::vector<char> done(scc.nrOfComponents, 0);
+  std::vector<int> parent(n, -1);
+  for (int start = 0; start < n && cycles.size() < maxNrOfCycles; ++start) {
+    const int c = scc.component[start];
+    if (done[c])
+      continue;
+    done[c] = 1;
+
+    // BFS inside the component until an edge leads back to start: the shortest cycle through start
+    std::vector<int> visited{start};
+    std::queue<int> queue;
+    queue.push(start);
+    parent[start] = start;
+    int last = -1;
+    while (!queue.empty() && last == -1) {
+      int v = queue.front();
+      queue.pop();
+      for (int next : compact.getOutNeighbors(v)) {
+        if (next == start) {
+          last = v;
+          break;
+        }
+        if (scc.component[next] == c && parent[next] == -1) {
+          parent[next] = v;
+          visited.push_back(next);
+          queue.push(next);
+        }
+      }
+    }
+
+    if (last != -1) { // a single vertex is only a cycle with a self loop
+      std::vector<idT> cycle;
+      for (int v = last; v != start; v = parent[v])
+        cycle.push_back(compact.getId(v));
+      cycle.push_back(compact.getId(start));
+      std::reverse(cycle.begin(), cycle.end());
+      cycles.push_back(std::move(cycle));
+    }
+    for (int v : visited)
+      parent[v] = -1;
+  }
+  return cycles;
 }
 
 } // namespace algorithms
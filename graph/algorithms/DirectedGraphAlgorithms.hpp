@@ -1,13 +1,56 @@
+#pragma once
 #include "../directed_graph/DirectedGraph.hpp"
+#include "../compact/CompactGraph.hpp"
+#include "../utils/Parallel.hpp"
+#include <limits>
 
 namespace graph {
 namespace algorithms {
 
+// Result of a single source shortest path computation.
+// distance[i] and parent[i] refer to the vertex vertexIds[i]; unreachable vertices
+// have distance UNREACHABLE and parent -1 (as has the source).
+struct ShortestPathTree {
+  static constexpr int UNREACHABLE = std::numeric_limits<int>::max() / 2;
+  int source = -1;
+  std::vector<idT> vertexIds;
+  std::vector<int> distance;
+  std::vector<int> parent;
+};
+
+// Strongly connected components of a compact graph.
+// The components are numbered in reverse topological order of the condensation:
+// every edge between two components goes from a higher to a lower component id.
+struct StronglyConnectedComponents {
+  std::vector<int> component; // component id of every vertex index
+  int nrOfComponents = 0;
+};
+
 int lowestLengthFBfs(graph::DirectedGraph &g, const idT &startId, const idT &endId); 
 
 int lowestLengthBBfs(graph::DirectedGraph &g, const idT &startId, const idT &endId);
 
 std::pair<std::vector<idT>, int> getLowestCostWalk(const graph::DirectedGraph &g, const idT &startId, const idT &endId);
 std::vector<idT> getTopologicalOrder(const graph::DirectedGraph &g);
+
+// Parallel delta-stepping single source shortest paths (non-negative weights only).
+// A delta <= 0 picks one from the edge weights.
+ShortestPathTree deltaSteppingShortestPaths(const compact::CompactGraph &g, int sourceIndex, int delta = 0,
+                                            unsigned nrThreads = utils::defaultThreadCount());
+ShortestPathTree deltaSteppingShortestPaths(const graph::DirectedGraph &g, const idT &sourceId, int delta = 0,
+                                            unsigned nrThreads = utils::defaultThreadCount());
+// Iterative Tarjan, safe on arbitrarily long dependency chains
+StronglyConnectedComponents getStronglyConnectedComponents(const compact::CompactGraph &g);
+// Forward-backward with trimming, the independent subproblems are solved in parallel.
+// Finds the same components as the sequential version, also numbered in reverse topological order, but
+// the numbers themselves may differ from it (and between runs with several threads).
+StronglyConnectedComponents getStronglyConnectedComponentsParallel(const compact::CompactGraph &g,
+                                                                   unsigned nrThreads = utils::defaultThreadCount());
+// The DAG of the components: vertex "c" is component c, the weight of an edge is the lowest weight
+// among the edges between the two components
+graph::DirectedGraph getCondensation(const compact::CompactGraph &g, const StronglyConnectedComponents &scc);
+// Up to maxNrOfCycles cycles (one per strongly connected component), every cycle is given by its
+// vertices in walk order, the edge from the last vertex back to the first closes it
+std::vector<std::vector<idT>> findCycles(const graph::DirectedGraph &g, std::size_t maxNrOfCycles = 1);
 }
 }
@@ -0,0 +1,218 @@
+#pragma once
+#include "../core/Concepts.hpp"
+#include "../core/VertexMap.hpp"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+namespace algorithms {
+
+// Header only versions of the algorithms, written against the concepts of graph/core.
+// They work on BasicGraph, the compact graph and (through core::adapt) the Graph hierarchy.
+
+// Number of edges on the shortest walk of at least one edge from startId to endId (when they are the same
+// vertex, the shortest cycle through it), nullopt if there is none
+template <core::IncidenceGraph G>
+std::optional<int> bfsLength(const G &g, const typename G::VertexId &startId, const typename G::VertexId &endId) {
+  core::VertexMap<G, int> distance(g, -1);
+  std::queue<typename G::VertexId> queue;
+  distance[startId] = 0;
+  queue.push(startId);
+  while (!queue.empty()) {
+    const auto current = queue.front();
+    queue.pop();
+    const int nextDistance = distance[current] + 1;
+    bool found = false;
+    g.forEachOutEdge(current, [&](const typename G::VertexId &next, const typename G::Weight &) {
+      // endId is checked before the visited mark, which startId already has
+      if (found || next == endId) {
+        found = true;
+        return;
+      }
+      if (distance[next] != -1)
+        return;
+      distance[next] = nextDistance;
+      queue.push(next);
+    });
+    if (found)
+      return nextDistance;
+  }
+  return std::nullopt;
+}
+
+
+template <core::IncidenceGraph G>
+struct ShortestPaths {
+  static constexpr typename G::Weight UNREACHABLE = std::numeric_limits<typename G::Weight>::max();
+  core::VertexMap<G, typename G::Weight> distance;
+  core::VertexMap<G, std::optional<typename G::VertexId>> parent;
+
+  explicit ShortestPaths(const G &g) : distance(g, UNREACHABLE), parent(g) {}
+
+  // The vertices of the shortest path to vertex, empty if it is not reachable
+  std::vector<typename G::VertexId> getPath(typename G::VertexId vertex) const {
+    if (distance[vertex] == UNREACHABLE)
+      return {};
+    std::vector<typename G::VertexId> path{vertex};
+    while (parent[vertex]) {
+      vertex = *parent[vertex];
+      path.push_back(vertex);
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+  }
+};
+
+// Dijkstra (non-negative weights). Stops as soon as target is settled, when one is given.
+template <core::IncidenceGraph G>
+ShortestPaths<G> dijkstra(const G &g, const typename G::VertexId &source,
+                          const std::optional<typename G::VertexId> &target = std::nullopt) {
+  using VertexId = typename G::VertexId;
+  using Weight = typename G::Weight;
+  ShortestPaths<G> result(g);
+  core::VertexMap<G, char> settled(g, 0);
+  std::priority_queue<std::pair<Weight, VertexId>, std::vector<std::pair<Weight, VertexId>>, std::greater<>> queue;
+  result.distance[source] = Weight{};
+  queue.push({Weight{}, source});
+  while (!queue.empty()) {
+    auto [distance, current] = queue.top();
+    queue.pop();
+    if (settled[current])
+      continue;
+    settled[current] = 1;
+    if (target && current == *target)
+      break;
+    g.forEachOutEdge(current, [&](const VertexId &next, const Weight &weight) {
+      if (weight < Weight{})
+        throw std::runtime_error("Dijkstra requires non-negative edge weights");
+      const Weight candidate = distance + weight;
+      if (!settled[next] && candidate < result.distance[next]) {
+        result.distance[next] = candidate;
+        result.parent[next] = current;
+        queue.push({candidate, next});
+      }
+    });
+  }
+  return result;
+}
+
+
+// Kahn's algorithm with predecessor counters, nullopt if the graph has a cycle
+template <core::IncidenceGraph G>
+std::optional<std::vector<typename G::VertexId>> topologicalOrder(const G &g) {
+  using VertexId = typename G::VertexId;
+  core::VertexMap<G, int> inDegree(g, 0);
+  g.forEachVertex([&](const VertexId &v) {
+    g.forEachOutEdge(v, [&](const VertexId &next, const typename G::Weight &) { ++inDegree[next]; });
+  });
+
+  std::vector<VertexId> order;
+  order.reserve(g.getNrOfVertices());
+  g.forEachVertex([&](const VertexId &v) {
+    if (inDegree[v] == 0)
+      order.push_back(v);
+  });
+  // order doubles as the queue: everything after position has not been expanded yet
+  for (std::size_t position = 0; position < order.size(); ++position)
+    g.forEachOutEdge(order[position], [&](const VertexId &next, const typename G::Weight &) {
+      if (--inDegree[next] == 0)
+        order.push_back(next);
+    });
+
+  if (order.size() != g.getNrOfVertices())
+    return std::nullopt;
+  return order;
+}
+
+
+// Connected components by iterative DFS, every component as its list of vertices
+template <core::UndirectedIncidenceGraph G>
+std::vector<std::vector<typename G::VertexId>> connectedComponents(const G &g) {
+  using VertexId = typename G::VertexId;
+  std::vector<std::vector<VertexId>> components;
+  core::VertexMap<G, char> visited(g, 0);
+  std::vector<VertexId> stack;
+  g.forEachVertex([&](const VertexId &root) {
+    if (visited[root])
+      return;
+    visited[root] = 1;
+    components.emplace_back();
+    stack.push_back(root);
+    while (!stack.empty()) {
+      const VertexId current = stack.back();
+      stack.pop_back();
+      components.back().push_back(current);
+      g.forEachOutEdge(current, [&](const VertexId &next, const typename G::Weight &) {
+        if (!visited[next]) {
+          visited[next] = 1;
+          stack.push_back(next);
+        }
+      });
+    }
+  });
+  return components;
+}
+
+
+// Exact minimum vertex cover by branching on an uncovered edge (one of its ends has to be in the cover).
+// Exponential in the size of the cover instead of the number of vertices.
+template <core::UndirectedIncidenceGraph G>
+std::vector<typename G::VertexId> minimumVertexCover(const G &g) {
+  using VertexId = typename G::VertexId;
+  std::vector<VertexId> vertices;
+  core::VertexMap<G, int> index(g, 0);
+  g.forEachVertex([&](const VertexId &v) {
+    index[v] = vertices.size();
+    vertices.push_back(v);
+  });
+  std::vector<std::pair<int, int>> edges;
+  for (std::size_t v = 0; v < vertices.size(); ++v)
+    g.forEachOutEdge(vertices[v], [&](const VertexId &next, const typename G::Weight &) {
+      if (index[next] >= (int)v) // every edge once, self loops included
+        edges.push_back({(int)v, index[next]});
+    });
+
+  std::vector<char> inCover(vertices.size(), 0);
+  std::vector<int> cover;
+  std::vector<int> bestCover(vertices.size());
+  for (std::size_t v = 0; v < vertices.size(); ++v)
+    bestCover[v] = v; // every vertex is a valid cover
+
+  // explicit stack of (first edge that may be uncovered, branch to try next: 0 from end, 1 to end, 2 done)
+  std::vector<std::pair<std::size_t, int>> stack{{0, 0}};
+  while (!stack.empty()) {
+    auto &[edge, branch] = stack.back();
+    while (edge < edges.size() && (inCover[edges[edge].first] || inCover[edges[edge].second]))
+      ++edge;
+    if (edge == edges.size() || branch == 2 || cover.size() + 1 >= bestCover.size()) {
+      if (edge == edges.size() && cover.size() < bestCover.size())
+        bestCover = cover;
+      stack.pop_back();
+      if (!stack.empty()) { // undo the choice of the parent
+        inCover[cover.back()] = 0;
+        cover.pop_back();
+      }
+      continue;
+    }
+    const int chosen = branch == 0 ? edges[edge].first : edges[edge].second;
+    branch = branch == 0 && edges[edge].first != edges[edge].second ? 1 : 2;
+    inCover[chosen] = 1;
+    cover.push_back(chosen);
+    const std::size_t nextEdge = edge;
+    stack.push_back({nextEdge, 0});
+  }
+
+  std::vector<VertexId> result;
+  for (int v : bestCover)
+    result.push_back(vertices[v]);
+  return result;
+}
+
+} // namespace algorithms
+} // namespace graph
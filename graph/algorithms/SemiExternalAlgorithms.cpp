@@ -0,0 +1,127 @@
+#include "SemiExternalAlgorithms.hpp"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace graph {
+namespace algorithms {
+
+ExternalBfsResult externalBfs(compact::GraphFileReader &file, int source, const ExternalProgressCallback &progress) {
+  const int n = file.getNrOfVertices();
+  if (source < 0 || source >= n)
+    throw std::runtime_error("Vertex not in the graph");
+  ExternalBfsResult result;
+  result.level.assign(n, -1);
+  const std::vector<std::uint64_t> offsets = file.readOutOffsets();
+
+  std::vector<int> frontier{source}, next;
+  result.level[source] = 0;
+  result.nrOfReached = 1;
+  std::uint64_t edgesRead = 0;
+  for (int depth = 0; !frontier.empty(); ++depth) {
+    std::sort(frontier.begin(), frontier.end()); // file order
+    for (std::size_t i = 0; i < frontier.size();) {
+      // the run of lists that are close enough to be read at once
+      std::size_t j = i + 1;
+      while (j < frontier.size() && offsets[frontier[j]] - offsets[frontier[j - 1] + 1] <= ExternalBfsResult::MAX_GAP)
+        ++j;
+      std::size_t list = i; // the frontier vertex whose list holds the edge
+      const std::uint64_t begin = offsets[frontier[i]], end = offsets[frontier[j - 1] + 1];
+      file.readOutTargets(begin, end, [&](std::uint64_t first, std::span<const std::int32_t> targets) {
+        for (std::uint64_t edge = first; edge < first + targets.size(); ++edge) {
+          while (edge >= offsets[frontier[list] + 1])
+            ++list;
+          if (edge < offsets[frontier[list]]) { // in a gap between two lists of the run
+            edge = std::min<std::uint64_t>(offsets[frontier[list]], first + targets.size()) - 1;
+            continue;
+          }
+          const int to = targets[edge - first];
+          if ((unsigned)to >= (unsigned)n)
+            throw std::runtime_error("The graph file is damaged");
+          if (result.level[to] == -1) {
+            result.level[to] = depth + 1;
+            next.push_back(to);
+          }
+        }
+      });
+      edgesRead += end - begin;
+      i = j;
+    }
+    result.nrOfLevels = depth + 1;
+    result.nrOfReached += next.size();
+    if (progress)
+      progress({depth, edgesRead, file.getNrOfEdges(), file.getIoStats()});
+    frontier.swap(next);
+    next.clear();
+  }
+  result.io = file.getIoStats();
+  return result;
+}
+
+
+ExternalComponentsResult externalConnectedComponents(compact::GraphFileReader &file,
+                                                     const ExternalProgressCallback &progress) {
+  const int n = file.getNrOfVertices();
+  std::vector<int> parent(n);
+  std::iota(parent.begin(), parent.end(), 0);
+  std::vector<std::uint8_t> rank(n, 0);
+  auto find = [&](int v) {
+    while (parent[v] != v) {
+      parent[v] = parent[parent[v]]; // path halving
+      v = parent[v];
+    }
+    return v;
+  };
+
+  const std::uint64_t nrOfEdges = file.getNrOfEdges();
+  const std::uint64_t reportEvery = std::max<std::uint64_t>(1, nrOfEdges / 100);
+  std::uint64_t edgesRead = 0, nextReport = reportEvery;
+  file.scanOutLists([&](int from, std::span<const std::int32_t> targets) {
+    for (const int to : targets) {
+      if ((unsigned)to >= (unsigned)n)
+        throw std::runtime_error("The graph file is damaged");
+      int a = find(from), b = find(to);
+      if (a == b)
+        continue;
+      if (rank[a] < rank[b])
+        std::swap(a, b);
+      parent[b] = a;
+      if (rank[a] == rank[b])
+        ++rank[a];
+    }
+    edgesRead += targets.size();
+    if (progress && edgesRead >= nextReport) {
+      progress({0, edgesRead, nrOfEdges, file.getIoStats()});
+      nextReport = edgesRead + reportEvery;
+    }
+  });
+
+  std::vector<std::uint8_t>().swap(rank);
+
+  // relabelled in place: every vertex first points at its root, then takes the label of its component, which
+  // the root keeps complemented (negative) in its own slot until the last pass
+  for (int v = 0; v < n; ++v)
+    parent[v] = find(v);
+  ExternalComponentsResult result;
+  for (int v = 0; v < n; ++v) {
+    const int root = parent[v];
+    if (root < 0)
+      continue; // a root labelled by a smaller vertex of its component
+    if (parent[root] == root)
+      parent[root] = ~result.nrOfComponents++;
+    if (root != v)
+      parent[v] = ~parent[root];
+  }
+  for (int &label : parent)
+    if (label < 0)
+      label = ~label;
+  result.component = std::move(parent);
+  std::vector<std::uint32_t> sizes(result.nrOfComponents, 0);
+  for (const int label : result.component)
+    result.largestComponent = std::max<std::size_t>(result.largestComponent, ++sizes[label]);
+  result.io = file.getIoStats();
+  return result;
+}
+
+} // namespace algorithms
+} // namespace graph
@@ -0,0 +1,52 @@
+#pragma once
+#include "../compact/GraphFileReader.hpp"
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace graph {
+namespace algorithms {
+
+// Semi-external algorithms on a mapped graph file (save_graph mapped) that does not fit in memory: they keep
+// a few bytes per vertex and read the edges from the file in large sequential blocks, never mapping it.
+
+// Where a semi-external algorithm is: step is the BFS level or the pass over the edges
+struct ExternalProgress {
+  int step;
+  std::uint64_t edgesRead;
+  std::uint64_t nrOfEdges;
+  compact::GraphFileReader::IoStats io;
+};
+
+using ExternalProgressCallback = std::function<void(const ExternalProgress &)>;
+
+// Hop distances from the source along the out edges, -1 for the vertices it does not reach.
+// Holds the levels and the out offsets of the file (12 bytes per vertex). Every level reads the lists of its
+// frontier in file order, merging the lists closer than MAX_GAP edges into one read: a small frontier costs
+// a few reads, a large one a sequential pass.
+struct ExternalBfsResult {
+  static constexpr std::uint64_t MAX_GAP = 64 * 1024;
+  std::vector<int> level;
+  int nrOfLevels = 0;
+  std::size_t nrOfReached = 0;
+  compact::GraphFileReader::IoStats io;
+};
+
+ExternalBfsResult externalBfs(compact::GraphFileReader &file, int source,
+                              const ExternalProgressCallback &progress = {});
+
+// Weakly connected components in one sequential pass over the edges, with a union-find over the vertices
+// (5 bytes per vertex; the labels are written over it, then 4 bytes per component count the sizes). The
+// components are numbered 0..k-1 in the order of their smallest vertex.
+struct ExternalComponentsResult {
+  std::vector<int> component;
+  int nrOfComponents = 0;
+  std::size_t largestComponent = 0;
+  compact::GraphFileReader::IoStats io;
+};
+
+ExternalComponentsResult externalConnectedComponents(compact::GraphFileReader &file,
+                                                     const ExternalProgressCallback &progress = {});
+
+} // namespace algorithms
+} // namespace graph
@@ -1,5 +1,8 @@
 #include "../undirected_graph/UndirectedGraph.hpp"
 #include "UndirectedGraphAlgorithms.hpp"
+#include "GenericAlgorithms.hpp"
+#include "../core/Adapters.hpp"
+#include "../core/Subgraphs.hpp"
 #include <vector>
 #include <stack>
 
@@ -10,72 +13,38 @@ namespace algorithms {
 // using a depth-first traversal of the graph.
 std::vector<graph::UndirectedGraph> getConnectedComponentsDFS(const graph::UndirectedGraph &g) {
   std::vector<graph::UndirectedGraph> components;
-
-  std::unordered_map<std::string, bool> visited;
-
-  for (const auto &[vertexId, vertex] : g) {
-    if (visited[vertexId])
-      continue;
-
-    std::stack<std::string> stk;
-    stk.push(vertexId);
+  for (const auto &vertexIds : connectedComponents(core::adapt(g))) {
     components.push_back(graph::UndirectedGraph());
-    components.back().addVertex(vertex);
-    visited[vertexId] = true;
-    while (!stk.empty()) {
-      std::string currentVertexId = stk.top();
-      stk.pop();
-      for (const auto &[_, adjId, __] : g.getAdjacentEdges(currentVertexId)) {
-        if (!visited[adjId]) {
-          stk.push(adjId);
-          visited[adjId] = true;
-          if (!components.back().isVertex(adjId))
-            components.back().addVertex(g.getVertex(adjId));
-          components.back().addEdge(currentVertexId, adjId);
-        }
-      }
-    }
+    auto &component = components.back();
+    for (const auto &vertexId : vertexIds)
+      component.addVertex(g.getVertex(vertexId));
+    for (const auto &vertexId : vertexIds)
+      for (const auto &[_, adjId, weight] : g.getAdjacentEdges(vertexId))
+        if (!component.isEdge(vertexId, adjId))
+          component.addEdge(vertexId, adjId, weight);
   }
   return components;
 }
 
 
-std::vector<idT> getMinimumVertexCover(const UndirectedGraph& graph) {
-  std::vector<idT> vertices;
-  for (const auto& [id, _] : graph) {
-    vertices.push_back(id);
-  }
-
-  int n = vertices.size();
-  std::vector<idT> bestCover;
-
-  // 2^n possible subsets
-  for (int mask = 0; mask < (1 << n); ++mask) {
-    // The masks binary digits represent which vertices are included
-    std::unordered_set<idT> cover;
-    for (int i = 0; i < n; ++i) {
-      if (mask & (1 << i)) { // check if the i'th vertex is included
-        cover.insert(vertices[i]);
-      }
-    }
+std::vector<std::vector<idT>> getConnectedComponentVertices(const UndirectedGraph &g) {
+  return connectedComponents(core::adapt(g));
+}
 
-    // Check if this subset covers all edges
-    bool allCovered = true;
-    for (const Edge& edge : graph.getEdges()) {
-      if (cover.count(edge.fromId) == 0 && cover.count(edge.toId) == 0) {
-        allCovered = false;
-        break;
-      }
-    }
 
-    if (allCovered) {
-      if (bestCover.empty() || cover.size() < bestCover.size()) {
-        bestCover = std::vector<idT>(cover.begin(), cover.end());
-      }
-    }
+// The union of the covers of the components, each searched on a view of its component: the search is
+// exponential in the size of the cover, so splitting it is exponentially cheaper than one search.
+std::vector<idT> getMinimumVertexCover(const UndirectedGraph& graph) {
+  const auto adapted = core::adapt(graph);
+  const core::ComponentLabels labels(adapted, connectedComponents(adapted));
+  std::vector<idT> cover;
+  for (std::size_t label = 0; label < labels.getNrOfComponents(); ++label) {
+    if (labels.getVertices(label).size() == 1 && !graph.isEdge(labels.getVertices(label)[0], labels.getVertices(label)[0]))
+      continue; // an isolated vertex without a self loop is never needed
+    const auto componentCover = minimumVertexCover(core::ComponentSubgraph(adapted, labels, label));
+    cover.insert(cover.end(), componentCover.begin(), componentCover.end());
   }
-
-  return bestCover;
+  return cover;
 }
 
 }//namespace algorightm
@@ -6,6 +6,8 @@ namespace algorithms {
 // 3. Write a program that finds the connected components of an undirected graph
 // using a depth-first traversal of the graph.
 std::vector<graph::UndirectedGraph> getConnectedComponentsDFS(const UndirectedGraph &g);
+// The same components as lists of vertex ids, without copying the graph
+std::vector<std::vector<idT>> getConnectedComponentVertices(const UndirectedGraph &g);
 
 std::vector<idT> getMinimumVertexCover(const UndirectedGraph& graph);
 }
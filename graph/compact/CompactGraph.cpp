@@ -0,0 +1,206 @@
+#include "CompactGraph.hpp"
+#include "../directed_graph/iterators/Iterators.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace graph {
+namespace compact {
+
+/* Numbers the vertices of the given graph and copies its adjacency into CSR arrays */
+CompactGraph::CompactGraph(const DirectedGraph &g) {
+  int n = g.getNrOfVertices();
+  ids.reserve(n);
+  index.reserve(n);
+  for (const auto &[vertexId, _] : g) {
+    index[vertexId] = ids.size();
+    ids.push_back(vertexId);
+  }
+
+  outOffsets.assign(n + 1, 0);
+  outTargets.reserve(g.getNrOfEdges());
+  outWeights.reserve(g.getNrOfEdges());
+  for (int v = 0; v < n; ++v) {
+    for (const auto &[_, toId, weight] : g.initOutboundEdgesIt(ids[v])) {
+      outTargets.push_back(index.at(toId));
+      outWeights.push_back(weight);
+    }
+    outOffsets[v + 1] = outTargets.size();
+  }
+  buildInbound();
+}
+
+
+/* Copies the graph under the new numbers, the out lists sorted by the new number of the neighbor */
+CompactGraph::CompactGraph(const CompactGraph &g, const std::vector<int> &order) {
+  const int n = g.getNrOfVertices();
+  if (order.size() != (std::size_t)n)
+    throw std::runtime_error("The vertex order is not a permutation of the vertices");
+  std::vector<int> renumbered(n, -1);
+  for (int v = 0; v < n; ++v) {
+    if (order[v] < 0 || order[v] >= n || renumbered[order[v]] != -1)
+      throw std::runtime_error("The vertex order is not a permutation of the vertices");
+    renumbered[order[v]] = v;
+  }
+  ids.reserve(n);
+  index.reserve(n);
+  for (int v = 0; v < n; ++v) {
+    ids.push_back(g.ids[order[v]]);
+    index[ids.back()] = v;
+  }
+
+  outOffsets.assign(n + 1, 0);
+  outTargets.reserve(g.getNrOfEdges());
+  outWeights.reserve(g.getNrOfEdges());
+  std::vector<std::pair<int, int>> edges;
+  for (int v = 0; v < n; ++v) {
+    edges.clear();
+    for (std::size_t e = g.outOffsets[order[v]]; e < g.outOffsets[order[v] + 1]; ++e)
+      edges.push_back({renumbered[g.outTargets[e]], g.outWeights[e]});
+    std::sort(edges.begin(), edges.end());
+    for (const auto &[target, weight] : edges) {
+      outTargets.push_back(target);
+      outWeights.push_back(weight);
+    }
+    outOffsets[v + 1] = outTargets.size();
+  }
+  buildInbound();
+}
+
+
+/* The inbound adjacency is the transpose of the outbound one, the lists in the order of the sources */
+void CompactGraph::buildInbound() {
+  const int n = ids.size();
+  inOffsets.assign(n + 1, 0);
+  for (int target : outTargets)
+    ++inOffsets[target + 1];
+  for (int v = 0; v < n; ++v)
+    inOffsets[v + 1] += inOffsets[v];
+  inSources.resize(outTargets.size());
+  inWeights.resize(outTargets.size());
+  std::vector<std::size_t> cursor(inOffsets.begin(), inOffsets.end() - 1);
+  for (int v = 0; v < n; ++v) {
+    for (std::size_t e = outOffsets[v]; e < outOffsets[v + 1]; ++e) {
+      std::size_t slot = cursor[outTargets[e]]++;
+      inSources[slot] = v;
+      inWeights[slot] = outWeights[e];
+    }
+  }
+}
+
+
+/* Returns the number of vertices */
+int CompactGraph::getNrOfVertices() const {
+  return ids.size();
+}
+
+
+/* Returns the number of edges */
+std::size_t CompactGraph::getNrOfEdges() const {
+  return outTargets.size();
+}
+
+
+/* Returns true if the vertex is in the graph, else false */
+bool CompactGraph::isVertex(const idT &id) const {
+  return index.find(id) != index.end();
+}
+
+
+/* Returns the index assigned to the given vertex */
+int CompactGraph::getIndex(const idT &id) const {
+  auto it = index.find(id);
+  if (it == index.end())
+    throw std::runtime_error("Vertex not in the graph");
+  return it->second;
+}
+
+
+/* Returns the original id of the vertex with the given index */
+const idT &CompactGraph::getId(int vertex) const {
+  return ids.at(vertex);
+}
+
+
+std::span<const int> CompactGraph::getOutNeighbors(int vertex) const {
+  return {outTargets.data() + outOffsets[vertex], outTargets.data() + outOffsets[vertex + 1]};
+}
+
+
+std::span<const int> CompactGraph::getOutWeights(int vertex) const {
+  return {outWeights.data() + outOffsets[vertex], outWeights.data() + outOffsets[vertex + 1]};
+}
+
+
+std::span<const int> CompactGraph::getInNeighbors(int vertex) const {
+  return {inSources.data() + inOffsets[vertex], inSources.data() + inOffsets[vertex + 1]};
+}
+
+
+std::span<const int> CompactGraph::getInWeights(int vertex) const {
+  return {inWeights.data() + inOffsets[vertex], inWeights.data() + inOffsets[vertex + 1]};
+}
+
+
+/* Returns the smallest edge weight (0 for a graph without edges) */
+int CompactGraph::getMinEdgeWeight() const {
+  if (outWeights.empty())
+    return 0;
+  return *std::min_element(outWeights.begin(), outWeights.end());
+}
+
+
+/* Returns the largest edge weight (0 for a graph without edges) */
+int CompactGraph::getMaxEdgeWeight() const {
+  if (outWeights.empty())
+    return 0;
+  return *std::max_element(outWeights.begin(), outWeights.end());
+}
+
+
+/* Returns a hash of the graph that does not depend on the numbering of the vertices */
+std::uint64_t CompactGraph::getFingerprint() const {
+  auto mix = [](std::uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+  };
+  std::vector<std::uint64_t> idHashes(ids.size());
+  std::uint64_t fingerprint = mix(ids.size()) + mix(outTargets.size() + 1);
+  for (std::size_t v = 0; v < ids.size(); ++v) {
+    idHashes[v] = mix(std::hash<idT>{}(ids[v]));
+    fingerprint += idHashes[v];
+  }
+  for (std::size_t v = 0; v < ids.size(); ++v)
+    for (std::size_t e = outOffsets[v]; e < outOffsets[v + 1]; ++e)
+      fingerprint += mix(idHashes[v] * 31 + mix(idHashes[outTargets[e]] + (std::uint32_t)outWeights[e]));
+  return fingerprint;
+}
+
+
+/* Returns the bytes of the id table, the id index and the CSR arrays */
+utils::MemoryReport CompactGraph::getMemoryUsage() const {
+  utils::MemoryReport report;
+  report.nrOfVertices = ids.size();
+  report.nrOfEdges = outTargets.size();
+  std::size_t idBytes = 0;
+  for (const auto &id : ids)
+    idBytes += utils::stringHeapBytes(id);
+  for (const auto &[id, _] : index)
+    idBytes += utils::stringHeapBytes(id);
+  report.add("id table", utils::vectorBytes(ids), ids.size());
+  report.add("id index", index.size() * utils::hashNodeChunkBytes<decltype(index)::value_type>(), index.size());
+  report.add("id strings", idBytes);
+  report.add("hash buckets", utils::bucketArrayBytes(index));
+  report.add("out CSR", utils::vectorBytes(outOffsets) + utils::vectorBytes(outTargets) + utils::vectorBytes(outWeights),
+             outTargets.size());
+  report.add("in CSR", utils::vectorBytes(inOffsets) + utils::vectorBytes(inSources) + utils::vectorBytes(inWeights),
+             inSources.size());
+  return report;
+}
+
+} // namespace compact
+} // namespace graph
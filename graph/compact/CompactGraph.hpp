@@ -0,0 +1,57 @@
+#pragma once
+#include "../directed_graph/DirectedGraph.hpp"
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace graph {
+namespace compact {
+
+// Immutable, index based (CSR) copy of a DirectedGraph.
+// Vertices are numbered 0..n-1 and both the outbound and the inbound
+// adjacency are stored as contiguous arrays, which is what the
+// parallel and index based algorithms work on.
+class CompactGraph {
+private:
+  std::vector<idT> ids;
+  std::unordered_map<idT, int> index;
+  std::vector<std::size_t> outOffsets;
+  std::vector<int> outTargets;
+  std::vector<int> outWeights;
+  std::vector<std::size_t> inOffsets;
+  std::vector<int> inSources;
+  std::vector<int> inWeights;
+
+  void buildInbound();
+
+public:
+  explicit CompactGraph(const DirectedGraph &g);
+  // The same graph with the vertices renumbered (see VertexOrder): vertex v of the copy is vertex order[v] of g.
+  // getId and getIndex map the new numbers to the original ids and back; the lists are sorted by neighbor.
+  CompactGraph(const CompactGraph &g, const std::vector<int> &order);
+
+  int getNrOfVertices() const;
+  std::size_t getNrOfEdges() const;
+
+  bool isVertex(const idT &id) const;
+  int getIndex(const idT &id) const;
+  const idT &getId(int vertex) const;
+
+  std::span<const int> getOutNeighbors(int vertex) const;
+  std::span<const int> getOutWeights(int vertex) const;
+  std::span<const int> getInNeighbors(int vertex) const;
+  std::span<const int> getInWeights(int vertex) const;
+
+  int getMinEdgeWeight() const;
+  int getMaxEdgeWeight() const;
+
+  // Order independent hash of the vertex ids and the weighted edges, used to check
+  // that an index saved to disk was built for the same graph
+  std::uint64_t getFingerprint() const;
+
+  utils::MemoryReport getMemoryUsage() const;
+};
+
+} // namespace compact
+} // namespace graph
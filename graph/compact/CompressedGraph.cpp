@@ -0,0 +1,150 @@
+#include "CompressedGraph.hpp"
+#include "../directed_graph/iterators/Iterators.hpp"
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace graph {
+namespace compact {
+
+static_assert(std::endian::native == std::endian::little, "The packed weights are read as little endian words");
+
+static void appendVarint(std::vector<std::uint8_t> &bytes, std::uint64_t value) {
+  while (value >= 0x80) {
+    bytes.push_back(std::uint8_t(value) | 0x80);
+    value >>= 7;
+  }
+  bytes.push_back(std::uint8_t(value));
+}
+
+
+static std::uint64_t zigzag(std::int64_t value) {
+  return (std::uint64_t(value) << 1) ^ std::uint64_t(value >> 63);
+}
+
+
+/* Appends the block of one adjacency list, edges holds (neighbor, weight) sorted by neighbor */
+static void appendList(std::vector<std::uint8_t> &bytes, int vertex, const std::vector<std::pair<int, int>> &edges) {
+  appendVarint(bytes, edges.size());
+  if (edges.empty())
+    return;
+  auto [minWeight, maxWeight] = std::minmax_element(edges.begin(), edges.end(),
+                                                    [](const auto &a, const auto &b) { return a.second < b.second; });
+  const int base = minWeight->second;
+  const int width = std::bit_width(std::uint32_t((std::int64_t)maxWeight->second - base));
+  appendVarint(bytes, zigzag(base));
+  bytes.push_back(width);
+
+  const std::size_t start = bytes.size();
+  bytes.resize(start + (edges.size() * width + 7) / 8, 0);
+  std::uint64_t bit = 0;
+  for (const auto &[_, weight] : edges)
+    for (int b = 0; b < width; ++b, ++bit)
+      if ((std::uint32_t((std::int64_t)weight - base) >> b) & 1)
+        bytes[start + bit / 8] |= std::uint8_t(1) << (bit % 8);
+
+  appendVarint(bytes, zigzag((std::int64_t)edges[0].first - vertex));
+  for (std::size_t e = 1; e < edges.size(); ++e)
+    appendVarint(bytes, edges[e].first - edges[e - 1].first - 1);
+}
+
+
+/* Numbers the vertices by id and encodes both adjacencies, a vertex at a time */
+CompressedGraph::CompressedGraph(const DirectedGraph &g) {
+  std::vector<const idT *> ids;
+  ids.reserve(g.getNrOfVertices());
+  for (const auto &[vertexId, _] : g)
+    ids.push_back(&vertexId);
+  std::sort(ids.begin(), ids.end(), [](const idT *a, const idT *b) { return *a < *b; });
+  std::unordered_map<std::string_view, int> index;
+  index.reserve(ids.size());
+  idOffsets.reserve(ids.size() + 1);
+  idOffsets.push_back(0);
+  for (const idT *id : ids) {
+    idBytes += *id;
+    idOffsets.push_back(idBytes.size());
+  }
+  for (std::size_t v = 0; v < ids.size(); ++v)
+    index.emplace(getId(v), v);
+
+  std::vector<std::pair<int, int>> edges;
+  auto encode = [&](std::vector<std::uint8_t> &lists, std::vector<std::uint64_t> &offsets, bool outbound) {
+    offsets.reserve(ids.size() + 1);
+    for (std::size_t v = 0; v < ids.size(); ++v) {
+      edges.clear();
+      if (outbound)
+        for (const auto &[_, toId, weight] : g.initOutboundEdgesIt(*ids[v]))
+          edges.push_back({index.at(toId), weight});
+      else
+        for (const auto &[fromId, _, weight] : g.initInboundEdgesIt(*ids[v]))
+          edges.push_back({index.at(fromId), weight});
+      std::sort(edges.begin(), edges.end());
+      for (const auto &[_, weight] : edges)
+        minEdgeWeight = std::min(minEdgeWeight, weight);
+      offsets.push_back(lists.size());
+      appendList(lists, v, edges);
+    }
+    offsets.push_back(lists.size());
+    lists.resize(lists.size() + sizeof(std::uint64_t), 0);
+    lists.shrink_to_fit();
+  };
+  encode(outLists, outOffsets, true);
+  encode(inLists, inOffsets, false);
+  nrOfEdges = g.getNrOfEdges();
+}
+
+
+/* Binary search over the ids, which are in the order of the vertex numbers: the first vertex not before id */
+int CompressedGraph::lowerBound(std::string_view id) const {
+  int low = 0, high = getNrOfVertices();
+  while (low < high) {
+    const int middle = low + (high - low) / 2;
+    if (getId(middle) < id)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  return low;
+}
+
+
+bool CompressedGraph::isVertex(const idT &id) const {
+  const int vertex = lowerBound(id);
+  return vertex < getNrOfVertices() && getId(vertex) == id;
+}
+
+
+int CompressedGraph::getIndex(const idT &id) const {
+  const int vertex = lowerBound(id);
+  if (vertex == getNrOfVertices() || getId(vertex) != id)
+    throw std::runtime_error("Vertex not in the graph");
+  return vertex;
+}
+
+
+int CompressedGraph::getOutDegree(int vertex) const {
+  const std::uint8_t *p = outLists.data() + outOffsets[vertex];
+  return readVarint(p);
+}
+
+
+int CompressedGraph::getInDegree(int vertex) const {
+  const std::uint8_t *p = inLists.data() + inOffsets[vertex];
+  return readVarint(p);
+}
+
+
+utils::MemoryReport CompressedGraph::getMemoryUsage() const {
+  utils::MemoryReport report;
+  report.nrOfVertices = getNrOfVertices();
+  report.nrOfEdges = nrOfEdges;
+  report.add("id strings", utils::stringHeapBytes(idBytes) + utils::vectorBytes(idOffsets), getNrOfVertices());
+  report.add("out lists", utils::vectorBytes(outLists) + utils::vectorBytes(outOffsets), nrOfEdges);
+  report.add("in lists", utils::vectorBytes(inLists) + utils::vectorBytes(inOffsets), nrOfEdges);
+  return report;
+}
+
+} // namespace compact
+} // namespace graph
@@ -0,0 +1,96 @@
+#pragma once
+#include "../directed_graph/DirectedGraph.hpp"
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace graph {
+namespace compact {
+
+// Read only, compressed copy of a DirectedGraph, for the graphs that are only queried.
+// Vertices are numbered 0..n-1 in the order of their ids, which are kept back to back in one buffer
+// (a lookup is a binary search). Every adjacency list is one block of bytes, found through its offset:
+//   degree                          varint
+//   minimum weight, bit width       zigzag varint, byte
+//   weights - minimum               bit-packed, width bits each, rounded up to bytes
+//   first neighbor - vertex         zigzag varint
+//   gaps to the next neighbors - 1  varints (the neighbors are sorted and distinct)
+// so a list is decoded front to back, with the weights next to their neighbors.
+class CompressedGraph {
+private:
+  std::string idBytes;
+  std::vector<std::uint64_t> idOffsets; // n + 1
+  std::vector<std::uint8_t> outLists;   // followed by 8 zero bytes, the weights are read 8 bytes at a time
+  std::vector<std::uint64_t> outOffsets;
+  std::vector<std::uint8_t> inLists;
+  std::vector<std::uint64_t> inOffsets;
+  std::size_t nrOfEdges = 0;
+  int minEdgeWeight = 0;
+
+  int lowerBound(std::string_view id) const;
+
+  static std::uint64_t readVarint(const std::uint8_t *&p) {
+    std::uint64_t value = *p & 0x7f;
+    for (int shift = 7; *p++ & 0x80; shift += 7)
+      value |= std::uint64_t(*p & 0x7f) << shift;
+    return value;
+  }
+
+  static std::int64_t unzigzag(std::uint64_t value) { return (std::int64_t)(value >> 1) ^ -(std::int64_t)(value & 1); }
+
+  template <typename Fn>
+  static void decodeList(const std::uint8_t *p, int vertex, Fn &&fn) {
+    const std::uint64_t degree = readVarint(p);
+    if (degree == 0)
+      return;
+    const int minWeight = unzigzag(readVarint(p));
+    const int width = *p++;
+    const std::uint8_t *weights = p;
+    p += (degree * width + 7) / 8;
+    const std::uint64_t mask = width == 0 ? 0 : ~std::uint64_t{0} >> (64 - width);
+    std::int64_t neighbor = vertex + unzigzag(readVarint(p));
+    for (std::uint64_t e = 0;;) {
+      std::uint64_t bits;
+      std::memcpy(&bits, weights + (e * width >> 3), sizeof(bits));
+      fn((int)neighbor, (int)(minWeight + (std::int64_t)((bits >> (e * width & 7)) & mask)));
+      if (++e == degree)
+        return;
+      neighbor += readVarint(p) + 1;
+    }
+  }
+
+public:
+  explicit CompressedGraph(const DirectedGraph &g);
+
+  int getNrOfVertices() const { return idOffsets.size() - 1; }
+  std::size_t getNrOfEdges() const { return nrOfEdges; }
+
+  bool isVertex(const idT &id) const;
+  int getIndex(const idT &id) const;
+  std::string_view getId(int vertex) const {
+    return std::string_view(idBytes).substr(idOffsets[vertex], idOffsets[vertex + 1] - idOffsets[vertex]);
+  }
+
+  int getMinEdgeWeight() const { return minEdgeWeight; }
+
+  int getOutDegree(int vertex) const;
+  int getInDegree(int vertex) const;
+
+  // fn(neighbor, weight) for the edges of the vertex, by increasing neighbor
+  template <typename Fn>
+  void forEachOutEdge(int vertex, Fn &&fn) const {
+    decodeList(outLists.data() + outOffsets[vertex], vertex, fn);
+  }
+
+  template <typename Fn>
+  void forEachInEdge(int vertex, Fn &&fn) const {
+    decodeList(inLists.data() + inOffsets[vertex], vertex, fn);
+  }
+
+  utils::MemoryReport getMemoryUsage() const;
+};
+
+} // namespace compact
+} // namespace graph
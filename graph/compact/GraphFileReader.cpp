@@ -0,0 +1,149 @@
+#include "GraphFileReader.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace graph {
+namespace compact {
+
+/* Opens the file for reading front to back: the kernel reads ahead aggressively */
+static int openSequential(const std::string &path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    throw std::runtime_error("Could not open file '" + path + "' for reading");
+  ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  return fd;
+}
+
+
+GraphFileReader::GraphFileReader(const std::string &path, std::size_t blockSize)
+    : fd(openSequential(path)), path(path), blockSize(std::max<std::size_t>(blockSize, 4096)),
+      header([&] {
+        try {
+          return readMappedFileHeader(fd, path);
+        } catch (...) {
+          ::close(fd);
+          throw;
+        }
+      }()),
+      layout(header.nrOfVertices, header.nrOfEdges, header.idBytes) {
+  stats.edgeBytes = header.nrOfEdges * sizeof(std::int32_t);
+}
+
+
+GraphFileReader::~GraphFileReader() {
+  ::close(fd);
+}
+
+
+void GraphFileReader::readAt(std::uint64_t position, void *into, std::size_t bytes) {
+  char *at = static_cast<char *>(into);
+  while (bytes > 0) {
+    const ssize_t count = ::pread(fd, at, bytes, position);
+    if (count < 0 && errno == EINTR)
+      continue;
+    if (count <= 0)
+      throw std::runtime_error("Could not read '" + path + "'");
+    ++stats.nrOfReads;
+    stats.bytesRead += count;
+    at += count;
+    position += count;
+    bytes -= count;
+  }
+}
+
+
+template <typename T, typename Fn>
+void GraphFileReader::readSection(std::size_t section, std::uint64_t begin, std::uint64_t end, Fn &&fn) {
+  std::vector<T> block(std::min<std::uint64_t>(blockSize / sizeof(T), end - begin));
+  for (std::uint64_t first = begin; first < end; first += block.size()) {
+    const std::size_t count = std::min<std::uint64_t>(block.size(), end - first);
+    readAt(section + first * sizeof(T), block.data(), count * sizeof(T));
+    fn(first, std::span<const T>(block.data(), count));
+  }
+}
+
+
+/* Binary search over the sorted ids, reading an offset pair and an id at every step */
+int GraphFileReader::findVertex(std::string_view id) {
+  int low = 0, high = getNrOfVertices();
+  std::string candidate;
+  while (low < high) {
+    const int middle = low + (high - low) / 2;
+    std::uint64_t offsets[2];
+    readAt(layout.idOffsets + middle * sizeof(std::uint64_t), offsets, sizeof(offsets));
+    candidate.resize(offsets[1] - offsets[0]);
+    readAt(layout.ids + offsets[0], candidate.data(), candidate.size());
+    if (candidate < id)
+      low = middle + 1;
+    else if (candidate == id)
+      return middle;
+    else
+      high = middle;
+  }
+  return -1;
+}
+
+
+std::vector<std::uint64_t> GraphFileReader::readOutOffsets() {
+  std::vector<std::uint64_t> offsets(header.nrOfVertices + 1);
+  readAt(layout.outOffsets, offsets.data(), offsets.size() * sizeof(std::uint64_t));
+  return offsets;
+}
+
+
+void GraphFileReader::readOutTargets(std::uint64_t begin, std::uint64_t end,
+                                     const std::function<void(std::uint64_t, std::span<const std::int32_t>)> &fn) {
+  readSection<std::int32_t>(layout.outTargets, begin, std::min(end, header.nrOfEdges), fn);
+}
+
+
+/* Reads the offsets and the targets side by side, a block of each at a time */
+void GraphFileReader::scanOutLists(const std::function<void(int, std::span<const std::int32_t>)> &fn) {
+  std::vector<std::uint64_t> offsets; // of the vertices [firstVertex, firstVertex + offsets.size() - 1)
+  int firstVertex = 0;
+  auto loadOffsets = [&](int vertex) {
+    const std::uint64_t count =
+        std::min<std::uint64_t>(blockSize / sizeof(std::uint64_t), header.nrOfVertices + 1 - vertex);
+    offsets.resize(count);
+    readAt(layout.outOffsets + vertex * sizeof(std::uint64_t), offsets.data(), count * sizeof(std::uint64_t));
+    firstVertex = vertex;
+  };
+  loadOffsets(0);
+  int vertex = 0;
+  readOutTargets(0, header.nrOfEdges, [&](std::uint64_t first, std::span<const std::int32_t> targets) {
+    const std::uint64_t last = first + targets.size();
+    for (std::uint64_t edge = first; edge < last;) {
+      while (offsets[vertex + 1 - firstVertex] <= edge) { // the lists that end before the edge
+        ++vertex;
+        if (vertex + 1 - firstVertex == (int)offsets.size())
+          loadOffsets(vertex);
+      }
+      const std::uint64_t end = std::min(offsets[vertex + 1 - firstVertex], last);
+      fn(vertex, targets.subspan(edge - first, end - edge));
+      edge = end;
+    }
+  });
+}
+
+
+/* Reads the id offsets and the id bytes side by side */
+void GraphFileReader::readIds(const std::function<void(int, std::string_view)> &fn) {
+  std::string bytes; // the ids of the current block of offsets
+  // The blocks of offsets overlap by one value, so every vertex sees both of its offsets
+  const std::uint64_t perBlock = std::max<std::uint64_t>(2, blockSize / sizeof(std::uint64_t));
+  std::vector<std::uint64_t> offsets;
+  for (std::uint64_t vertex = 0; vertex < header.nrOfVertices; vertex += perBlock - 1) {
+    offsets.resize(std::min<std::uint64_t>(perBlock, header.nrOfVertices + 1 - vertex));
+    readAt(layout.idOffsets + vertex * sizeof(std::uint64_t), offsets.data(), offsets.size() * sizeof(std::uint64_t));
+    bytes.resize(offsets.back() - offsets.front());
+    readAt(layout.ids + offsets.front(), bytes.data(), bytes.size());
+    for (std::size_t v = 0; v + 1 < offsets.size(); ++v)
+      fn(vertex + v, std::string_view(bytes).substr(offsets[v] - offsets.front(), offsets[v + 1] - offsets[v]));
+  }
+}
+
+} // namespace compact
+} // namespace graph
@@ -0,0 +1,67 @@
+#pragma once
+#include "MappedFileFormat.hpp"
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace graph {
+namespace compact {
+
+// Reads a mapped graph file (see MappedGraph) with plain reads of large blocks instead of mapping it, for
+// the semi-external algorithms: they keep their per-vertex state in memory and stream the edges, so the
+// memory holds that state and one block, however large the file is. Counts what it reads.
+class GraphFileReader {
+public:
+  static constexpr std::size_t DEFAULT_BLOCK_SIZE = 8 << 20;
+
+  struct IoStats {
+    std::uint64_t bytesRead = 0;
+    std::uint64_t nrOfReads = 0; // system calls
+    std::uint64_t edgeBytes = 0; // of the out targets, what one pass over the edges reads
+  };
+
+  explicit GraphFileReader(const std::string &path, std::size_t blockSize = DEFAULT_BLOCK_SIZE);
+  GraphFileReader(const GraphFileReader &) = delete;
+  GraphFileReader &operator=(const GraphFileReader &) = delete;
+  ~GraphFileReader();
+
+  int getNrOfVertices() const { return header.nrOfVertices; }
+  std::uint64_t getNrOfEdges() const { return header.nrOfEdges; }
+  const IoStats &getIoStats() const { return stats; }
+
+  // Binary search in the id sections, a few small reads; -1 when the id is not in the graph
+  int findVertex(std::string_view id);
+
+  // The first out edge of every vertex and the number of edges after the last one (n + 1 values)
+  std::vector<std::uint64_t> readOutOffsets();
+
+  // Streams the out targets of the edges [begin, end) in blocks: fn(first edge of the block, its targets)
+  void readOutTargets(std::uint64_t begin, std::uint64_t end,
+                      const std::function<void(std::uint64_t, std::span<const std::int32_t>)> &fn);
+
+  // One pass over the out lists in file order: fn(vertex, targets), without the empty lists; a list longer than
+  // a block comes in pieces
+  void scanOutLists(const std::function<void(int, std::span<const std::int32_t>)> &fn);
+
+  // The ids in vertex order: fn(vertex, id)
+  void readIds(const std::function<void(int, std::string_view)> &fn);
+
+private:
+  int fd = -1;
+  std::string path;
+  std::size_t blockSize;
+  MappedFileHeader header;
+  MappedFileLayout layout;
+  IoStats stats;
+
+  void readAt(std::uint64_t position, void *into, std::size_t bytes);
+  // Streams the values [begin, end) of the section of T starting at byte section, in blocks of blockSize bytes
+  template <typename T, typename Fn>
+  void readSection(std::size_t section, std::uint64_t begin, std::uint64_t end, Fn &&fn);
+};
+
+} // namespace compact
+} // namespace graph
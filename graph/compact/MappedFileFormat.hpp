@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace graph {
+namespace compact {
+
+// The layout of the files MappedGraph maps and GraphFileReader streams (see MappedGraph)
+
+constexpr std::uint64_t MAPPED_FILE_MAGIC = 0x5253434850415247; // "GRAPHCSR"
+constexpr std::uint32_t MAPPED_FILE_VERSION = 1;
+
+struct MappedFileHeader {
+  std::uint64_t magic;
+  std::uint32_t version;
+  std::int32_t minEdgeWeight; // 0 when no weight is negative
+  std::uint64_t nrOfVertices;
+  std::uint64_t nrOfEdges;
+  std::uint64_t idBytes;
+};
+
+// Where the sections start in the file, each one rounded up to 8 bytes
+struct MappedFileLayout {
+  std::size_t outOffsets, inOffsets, idOffsets, outTargets, outWeights, inSources, inWeights, ids, size;
+
+  MappedFileLayout(std::uint64_t n, std::uint64_t m, std::uint64_t idBytes) {
+    std::size_t at = sizeof(MappedFileHeader);
+    auto section = [&](std::size_t bytes) {
+      const std::size_t start = at;
+      at += (bytes + 7) / 8 * 8;
+      return start;
+    };
+    outOffsets = section((n + 1) * sizeof(std::uint64_t));
+    inOffsets = section((n + 1) * sizeof(std::uint64_t));
+    idOffsets = section((n + 1) * sizeof(std::uint64_t));
+    outTargets = section(m * sizeof(std::int32_t));
+    outWeights = section(m * sizeof(std::int32_t));
+    inSources = section(m * sizeof(std::int32_t));
+    inWeights = section(m * sizeof(std::int32_t));
+    ids = section(idBytes);
+    size = at;
+  }
+};
+
+// Reads the header of the open file and checks it against the size of the file
+inline MappedFileHeader readMappedFileHeader(int fd, const std::string &path) {
+  struct stat status;
+  MappedFileHeader header;
+  if (::fstat(fd, &status) != 0 || ::pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+      header.magic != MAPPED_FILE_MAGIC)
+    throw std::runtime_error("'" + path + "' is not a mapped graph");
+  if (header.version != MAPPED_FILE_VERSION)
+    throw std::runtime_error("'" + path + "' is a mapped graph of another format version");
+  const std::size_t size = status.st_size;
+  if (header.nrOfVertices > (std::uint64_t)INT32_MAX || header.nrOfEdges > size || header.idBytes > size)
+    throw std::runtime_error("'" + path + "' is damaged");
+  const MappedFileLayout layout(header.nrOfVertices, header.nrOfEdges, header.idBytes);
+  if (layout.size != size)
+    throw std::runtime_error("'" + path + "' is damaged (" + std::to_string(size) + " bytes instead of " +
+                             std::to_string(layout.size) + ")");
+  return header;
+}
+
+} // namespace compact
+} // namespace graph
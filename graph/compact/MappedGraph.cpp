@@ -0,0 +1,252 @@
+#include "MappedGraph.hpp"
+#include "MappedFileFormat.hpp"
+#include "../directed_graph/iterators/Iterators.hpp"
+#include "../utils/BinaryIO.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace graph {
+namespace compact {
+
+/* Numbers the vertices by id and writes the sections in file order */
+void MappedGraph::save(const DirectedGraph &g, const std::string &path) {
+  std::vector<const idT *> vertexIds;
+  vertexIds.reserve(g.getNrOfVertices());
+  for (const auto &[vertexId, _] : g)
+    vertexIds.push_back(&vertexId);
+  std::sort(vertexIds.begin(), vertexIds.end(), [](const idT *a, const idT *b) { return *a < *b; });
+  std::unordered_map<std::string_view, int> index;
+  index.reserve(vertexIds.size());
+  for (std::size_t v = 0; v < vertexIds.size(); ++v)
+    index.emplace(*vertexIds[v], v);
+
+  // one adjacency in CSR form, the lists sorted by neighbor
+  struct Lists {
+    std::vector<std::uint64_t> offsets{0};
+    std::vector<std::int32_t> neighbors, weights;
+  };
+  auto build = [&](bool outbound) {
+    Lists lists;
+    std::vector<std::pair<int, int>> edges;
+    for (const idT *vertexId : vertexIds) {
+      edges.clear();
+      if (outbound)
+        for (const auto &[_, toId, weight] : g.initOutboundEdgesIt(*vertexId))
+          edges.push_back({index.at(toId), weight});
+      else
+        for (const auto &[fromId, _, weight] : g.initInboundEdgesIt(*vertexId))
+          edges.push_back({index.at(fromId), weight});
+      std::sort(edges.begin(), edges.end());
+      for (const auto &[neighbor, weight] : edges) {
+        lists.neighbors.push_back(neighbor);
+        lists.weights.push_back(weight);
+      }
+      lists.offsets.push_back(lists.neighbors.size());
+    }
+    return lists;
+  };
+
+  std::vector<std::uint64_t> idOffsets{0};
+  for (const idT *vertexId : vertexIds)
+    idOffsets.push_back(idOffsets.back() + vertexId->size());
+
+  const std::string temporary = path + ".tmp";
+  std::ofstream fout(temporary, std::ios::binary);
+  if (!fout.is_open())
+    throw std::runtime_error("Could not open file '" + temporary + "' for writing");
+  auto writeSection = [&](const auto *values, std::size_t count) {
+    static const char padding[8] = {};
+    const std::size_t bytes = count * sizeof(*values);
+    fout.write(reinterpret_cast<const char *>(values), bytes);
+    fout.write(padding, (8 - bytes % 8) % 8);
+  };
+
+  const Lists out = build(true);
+  const Lists in = build(false);
+  const int minEdgeWeight = std::min(0, out.weights.empty() ? 0 : *std::min_element(out.weights.begin(), out.weights.end()));
+  const MappedFileHeader header{MAPPED_FILE_MAGIC, MAPPED_FILE_VERSION, minEdgeWeight,
+                                vertexIds.size(), out.neighbors.size(), idOffsets.back()};
+  utils::writePod(fout, header);
+  writeSection(out.offsets.data(), out.offsets.size());
+  writeSection(in.offsets.data(), in.offsets.size());
+  writeSection(idOffsets.data(), idOffsets.size());
+  writeSection(out.neighbors.data(), out.neighbors.size());
+  writeSection(out.weights.data(), out.weights.size());
+  writeSection(in.neighbors.data(), in.neighbors.size());
+  writeSection(in.weights.data(), in.weights.size());
+  std::string idBytes;
+  idBytes.reserve(idOffsets.back());
+  for (const idT *vertexId : vertexIds)
+    idBytes += *vertexId;
+  writeSection(idBytes.data(), idBytes.size());
+  fout.close();
+  if (!fout || std::rename(temporary.c_str(), path.c_str()) != 0) {
+    std::remove(temporary.c_str());
+    throw std::runtime_error("Could not write the mapped graph to '" + path + "'");
+  }
+}
+
+
+MappedGraph::MappedGraph(const std::string &path) : path(path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    throw std::runtime_error("Could not open file '" + path + "' for reading");
+  MappedFileHeader header;
+  try {
+    header = readMappedFileHeader(fd, path);
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+  const MappedFileLayout layout(header.nrOfVertices, header.nrOfEdges, header.idBytes);
+  size = layout.size;
+  data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd); // the mapping keeps the file open
+  if (data == MAP_FAILED) {
+    data = nullptr;
+    throw std::runtime_error("Could not map '" + path + "'");
+  }
+  const char *bytes = static_cast<const char *>(data);
+  nrOfVertices = header.nrOfVertices;
+  nrOfEdges = header.nrOfEdges;
+  minEdgeWeight = header.minEdgeWeight;
+  outOffsets = reinterpret_cast<const std::uint64_t *>(bytes + layout.outOffsets);
+  inOffsets = reinterpret_cast<const std::uint64_t *>(bytes + layout.inOffsets);
+  idOffsets = reinterpret_cast<const std::uint64_t *>(bytes + layout.idOffsets);
+  outTargets = reinterpret_cast<const std::int32_t *>(bytes + layout.outTargets);
+  outWeights = reinterpret_cast<const std::int32_t *>(bytes + layout.outWeights);
+  inSources = reinterpret_cast<const std::int32_t *>(bytes + layout.inSources);
+  inWeights = reinterpret_cast<const std::int32_t *>(bytes + layout.inWeights);
+  ids = bytes + layout.ids;
+
+  // like distributed::loadShard, in one sequential pass: the offsets grow from 0 to the size of their
+  // section, the neighbors are vertices
+  advise(Access::Sequential);
+  auto isOffsets = [&](const std::uint64_t *offsets, std::uint64_t last) {
+    return offsets[0] == 0 && offsets[nrOfVertices] == last && std::is_sorted(offsets, offsets + nrOfVertices + 1);
+  };
+  auto inGraph = [&](const std::int32_t *values) {
+    return std::all_of(values, values + nrOfEdges, [&](std::int32_t v) { return v >= 0 && v < nrOfVertices; });
+  };
+  const bool valid = isOffsets(outOffsets, nrOfEdges) && isOffsets(inOffsets, nrOfEdges) &&
+                     isOffsets(idOffsets, header.idBytes) && inGraph(outTargets) && inGraph(inSources);
+  if (!valid) {
+    ::munmap(data, size);
+    data = nullptr;
+    throw std::runtime_error("'" + path + "' is damaged");
+  }
+  // the lookups would waste most of what the kernel reads ahead
+  advise(Access::Random);
+}
+
+
+MappedGraph::~MappedGraph() {
+  if (data != nullptr)
+    ::munmap(data, size);
+}
+
+
+void MappedGraph::advise(Access access) const {
+  ::madvise(data, size, access == Access::Random ? MADV_RANDOM : MADV_SEQUENTIAL);
+}
+
+
+MappedGraph::SequentialScan::SequentialScan(const MappedGraph &g) : g(g) {
+  if (g.activeScans.fetch_add(1) == 0)
+    g.advise(Access::Sequential);
+}
+
+
+MappedGraph::SequentialScan::~SequentialScan() {
+  if (g.activeScans.fetch_sub(1) == 1)
+    g.advise(Access::Random);
+}
+
+
+/* Binary search over the ids, which are in the order of the vertex numbers: the first vertex not before id */
+int MappedGraph::lowerBound(std::string_view id) const {
+  int low = 0, high = nrOfVertices;
+  while (low < high) {
+    const int middle = low + (high - low) / 2;
+    if (getId(middle) < id)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  return low;
+}
+
+
+bool MappedGraph::isVertex(std::string_view id) const {
+  const int vertex = lowerBound(id);
+  return vertex < nrOfVertices && getId(vertex) == id;
+}
+
+
+int MappedGraph::getIndex(std::string_view id) const {
+  const int vertex = lowerBound(id);
+  if (vertex == nrOfVertices || getId(vertex) != id)
+    throw std::runtime_error("Vertex not in the graph");
+  return vertex;
+}
+
+
+bool MappedGraph::isEdge(int from, int to) const {
+  const auto neighbors = getOutNeighbors(from);
+  return std::binary_search(neighbors.begin(), neighbors.end(), to);
+}
+
+
+std::size_t MappedGraph::visitEdges(EdgeCursor &cursor, std::size_t limit, const EdgeVisitor &visit) const {
+  std::size_t passed = 0;
+  while (passed < limit && cursor.chunk < (std::size_t)nrOfVertices) {
+    const std::uint64_t begin = outOffsets[cursor.chunk] + cursor.offset, end = outOffsets[cursor.chunk + 1];
+    const std::uint64_t count = begin >= end ? 0 : std::min<std::uint64_t>(end - begin, limit - passed);
+    if (visit && count > 0) {
+      const idT fromId(getId(cursor.chunk));
+      for (std::uint64_t e = begin; e < begin + count; ++e)
+        visit(fromId, idT(getId(outTargets[e])), outWeights[e]);
+    }
+    passed += count;
+    if (begin + count >= end) {
+      ++cursor.chunk;
+      cursor.offset = 0;
+    } else
+      cursor.offset += count;
+  }
+  cursor.atEnd = cursor.chunk >= (std::size_t)nrOfVertices;
+  return passed;
+}
+
+
+std::size_t MappedGraph::getResidentBytes() const {
+  const std::size_t pageSize = ::sysconf(_SC_PAGESIZE);
+  std::vector<unsigned char> pages((size + pageSize - 1) / pageSize);
+  if (::mincore(data, size, pages.data()) != 0)
+    return 0;
+  std::size_t resident = 0;
+  for (unsigned char page : pages)
+    resident += page & 1;
+  return std::min(size, resident * pageSize);
+}
+
+
+utils::MemoryReport MappedGraph::getMemoryUsage() const {
+  utils::MemoryReport report;
+  report.nrOfVertices = nrOfVertices;
+  report.nrOfEdges = nrOfEdges;
+  report.add("mapped file, resident pages of " + utils::MemoryReport::formatBytes(size), getResidentBytes());
+  return report;
+}
+
+} // namespace compact
+} // namespace graph
@@ -0,0 +1,114 @@
+#pragma once
+#include "../directed_graph/DirectedGraph.hpp"
+#include <atomic>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace graph {
+namespace compact {
+
+// A directed graph kept in a binary CSR file and mapped read only: opening it checks the offsets and the
+// neighbors in one pass, the other pages are read by the kernel when the queries first touch them, and the
+// processes that map the same file share them in the page cache, so the graph may be larger than the memory.
+// Vertices are numbered 0..n-1 in the order of their ids (a lookup is a binary search in the mapping).
+// The file, in the native byte order (like utils::BinaryIO), every section 8 byte aligned:
+//   header                                magic, format version, minimum weight, n, m, bytes of the ids
+//   out offsets, in offsets, id offsets   uint64[n + 1] each
+//   out targets, out weights              int32[m] each, the lists sorted by target
+//   in sources, in weights                int32[m] each, the lists sorted by source
+//   ids                                   the bytes of the ids, back to back
+class MappedGraph {
+public:
+  // Maps the file and checks that every offset and neighbor points inside its section; the weights and the
+  // bytes of the ids are not read
+  explicit MappedGraph(const std::string &path);
+  MappedGraph(const MappedGraph &) = delete;
+  MappedGraph &operator=(const MappedGraph &) = delete;
+  ~MappedGraph();
+
+  // Writes the file next to path and renames it over path, so the processes mapping the old file keep it
+  static void save(const DirectedGraph &g, const std::string &path);
+
+  const std::string &getPath() const { return path; }
+  int getNrOfVertices() const { return nrOfVertices; }
+  std::size_t getNrOfEdges() const { return nrOfEdges; }
+
+  bool isVertex(std::string_view id) const;
+  int getIndex(std::string_view id) const;
+  std::string_view getId(int vertex) const {
+    return std::string_view(ids + idOffsets[vertex], idOffsets[vertex + 1] - idOffsets[vertex]);
+  }
+
+  bool isEdge(int from, int to) const;
+  int getMinEdgeWeight() const { return minEdgeWeight; }
+
+  std::span<const std::int32_t> getOutNeighbors(int vertex) const {
+    return {outTargets + outOffsets[vertex], outTargets + outOffsets[vertex + 1]};
+  }
+  std::span<const std::int32_t> getOutWeights(int vertex) const {
+    return {outWeights + outOffsets[vertex], outWeights + outOffsets[vertex + 1]};
+  }
+  std::span<const std::int32_t> getInNeighbors(int vertex) const {
+    return {inSources + inOffsets[vertex], inSources + inOffsets[vertex + 1]};
+  }
+  std::span<const std::int32_t> getInWeights(int vertex) const {
+    return {inWeights + inOffsets[vertex], inWeights + inOffsets[vertex + 1]};
+  }
+
+  // fn(neighbor, weight) for the edges of the vertex, by increasing neighbor
+  template <typename Fn>
+  void forEachOutEdge(int vertex, Fn &&fn) const {
+    for (std::uint64_t e = outOffsets[vertex]; e < outOffsets[vertex + 1]; ++e)
+      fn((int)outTargets[e], (int)outWeights[e]);
+  }
+
+  template <typename Fn>
+  void forEachInEdge(int vertex, Fn &&fn) const {
+    for (std::uint64_t e = inOffsets[vertex]; e < inOffsets[vertex + 1]; ++e)
+      fn((int)inSources[e], (int)inWeights[e]);
+  }
+
+  // The edges by source vertex, like Graph::visitEdges (cursor.chunk is the vertex, cursor.offset the edge in its list)
+  std::size_t visitEdges(EdgeCursor &cursor, std::size_t limit, const EdgeVisitor &visit) const;
+
+  // Reads ahead while it lives, for the scans over the whole graph. The advice belongs to the mapping, which
+  // all the readers share: it goes back to random access when the last scan ends.
+  class SequentialScan {
+  public:
+    explicit SequentialScan(const MappedGraph &g);
+    SequentialScan(const SequentialScan &) = delete;
+    SequentialScan &operator=(const SequentialScan &) = delete;
+    ~SequentialScan();
+
+  private:
+    const MappedGraph &g;
+  };
+
+  // The pages of the file that are in memory now (they belong to the page cache, not to the process)
+  std::size_t getResidentBytes() const;
+  std::size_t getFileSize() const { return size; }
+  utils::MemoryReport getMemoryUsage() const;
+
+private:
+  // How the next reads go: the lookups touch a few pages here and there, the scans read everything
+  enum class Access { Random, Sequential };
+
+  std::string path;
+  void *data = nullptr;
+  std::size_t size = 0;
+  int nrOfVertices = 0;
+  std::size_t nrOfEdges = 0;
+  int minEdgeWeight = 0;
+  const std::uint64_t *outOffsets = nullptr, *inOffsets = nullptr, *idOffsets = nullptr;
+  const std::int32_t *outTargets = nullptr, *outWeights = nullptr, *inSources = nullptr, *inWeights = nullptr;
+  const char *ids = nullptr;
+  mutable std::atomic<int> activeScans = 0;
+
+  int lowerBound(std::string_view id) const;
+  void advise(Access access) const;
+};
+
+} // namespace compact
+} // namespace graph
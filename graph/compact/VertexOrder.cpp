@@ -0,0 +1,242 @@
+#include "VertexOrder.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <numeric>
+#include <stdexcept>
+
+namespace graph {
+namespace compact {
+
+VertexOrder parseVertexOrder(const std::string &name) {
+  if (name == "insertion")
+    return VertexOrder::Insertion;
+  if (name == "degree")
+    return VertexOrder::Degree;
+  if (name == "rcm")
+    return VertexOrder::Rcm;
+  if (name == "gorder")
+    return VertexOrder::Gorder;
+  throw std::runtime_error("Unknown vertex order '" + name + "' (insertion, degree, rcm or gorder)");
+}
+
+
+const char *getVertexOrderName(VertexOrder order) {
+  switch (order) {
+  case VertexOrder::Insertion:
+    return "insertion";
+  case VertexOrder::Degree:
+    return "degree";
+  case VertexOrder::Rcm:
+    return "rcm";
+  case VertexOrder::Gorder:
+    return "gorder";
+  }
+  return "unknown";
+}
+
+
+static int getDegree(const CompactGraph &g, int v) {
+  return g.getOutNeighbors(v).size() + g.getInNeighbors(v).size();
+}
+
+
+static std::vector<int> orderByDegree(const CompactGraph &g) {
+  std::vector<int> order(g.getNrOfVertices());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return getDegree(g, a) > getDegree(g, b); });
+  return order;
+}
+
+
+/* Every component from its unvisited vertex of lowest degree; the neighbors of a vertex are queued by increasing
+   degree, like in Cuthill-McKee on a symmetric matrix */
+static std::vector<int> orderByRcm(const CompactGraph &g) {
+  const int n = g.getNrOfVertices();
+  std::vector<int> starts(n);
+  std::iota(starts.begin(), starts.end(), 0);
+  std::stable_sort(starts.begin(), starts.end(), [&](int a, int b) { return getDegree(g, a) < getDegree(g, b); });
+
+  std::vector<int> order;
+  order.reserve(n);
+  std::vector<char> visited(n, 0);
+  std::vector<int> neighbors;
+  for (const int start : starts) {
+    if (visited[start])
+      continue;
+    visited[start] = 1;
+    order.push_back(start);
+    for (std::size_t tail = order.size() - 1; tail < order.size(); ++tail) {
+      const int v = order[tail];
+      neighbors.clear();
+      for (const auto adjacent : {g.getOutNeighbors(v), g.getInNeighbors(v)})
+        for (const int u : adjacent)
+          if (!visited[u]) {
+            visited[u] = 1;
+            neighbors.push_back(u);
+          }
+      std::stable_sort(neighbors.begin(), neighbors.end(),
+                       [&](int a, int b) { return getDegree(g, a) < getDegree(g, b); });
+      order.insert(order.end(), neighbors.begin(), neighbors.end());
+    }
+  }
+  std::reverse(order.begin(), order.end());
+  return order;
+}
+
+
+// The unplaced vertices by score, for Gorder: a score only moves by one, so a list per score value and the
+// highest non-empty one give O(1) updates and an amortized O(1) extraction (the "unit heap" of Gorder)
+class UnitHeap {
+public:
+  explicit UnitHeap(int n) : score(n, 0), previous(n, -1), next(n, -1), heads(1, -1) {
+    for (int v = n - 1; v >= 0; --v)
+      link(v);
+  }
+
+  void increment(int v) {
+    if (placed(v))
+      return;
+    unlink(v);
+    if (++score[v] == (int)heads.size())
+      heads.push_back(-1);
+    link(v);
+    top = std::max(top, score[v]);
+  }
+
+  void decrement(int v) {
+    if (placed(v))
+      return;
+    unlink(v);
+    --score[v];
+    link(v);
+  }
+
+  void remove(int v) {
+    unlink(v);
+    score[v] = PLACED;
+  }
+
+  // -1 when every vertex is placed
+  int extractMax() {
+    while (top > 0 && heads[top] == -1)
+      --top;
+    const int v = heads[top];
+    if (v != -1)
+      remove(v);
+    return v;
+  }
+
+private:
+  static constexpr int PLACED = -1;
+  std::vector<int> score, previous, next;
+  std::vector<int> heads; // the first vertex of every score
+  int top = 0;
+
+  bool placed(int v) const { return score[v] == PLACED; }
+
+  void link(int v) {
+    previous[v] = -1;
+    next[v] = heads[score[v]];
+    if (next[v] != -1)
+      previous[next[v]] = v;
+    heads[score[v]] = v;
+  }
+
+  void unlink(int v) {
+    if (previous[v] != -1)
+      next[previous[v]] = next[v];
+    else
+      heads[score[v]] = next[v];
+    if (next[v] != -1)
+      previous[next[v]] = previous[v];
+  }
+};
+
+
+/* Gorder (Wei et al.): the score of u is the number of edges between u and the vertices of the window plus the
+   number of their common in-neighbors. The in-neighbors of more than sqrt(n) out edges are not counted as
+   common ones: they would cost quadratic time and say little about any pair. */
+static std::vector<int> orderByGorder(const CompactGraph &g) {
+  const int n = g.getNrOfVertices();
+  const std::size_t hubDegree = std::max<std::size_t>(1, std::sqrt((double)n));
+  UnitHeap heap(n);
+  auto update = [&](int v, bool entering) {
+    auto change = [&](int u) { entering ? heap.increment(u) : heap.decrement(u); };
+    for (const int u : g.getOutNeighbors(v))
+      change(u);
+    for (const int x : g.getInNeighbors(v)) {
+      change(x);
+      const auto siblings = g.getOutNeighbors(x);
+      if (siblings.size() <= hubDegree)
+        for (const int u : siblings)
+          if (u != v)
+            change(u);
+    }
+  };
+
+  std::vector<int> order;
+  order.reserve(n);
+  if (n == 0)
+    return order;
+  int first = 0;
+  for (int v = 1; v < n; ++v)
+    if (g.getInNeighbors(v).size() > g.getInNeighbors(first).size())
+      first = v;
+  heap.remove(first);
+  order.push_back(first);
+  while ((int)order.size() < n) {
+    update(order.back(), true);
+    if (order.size() > GORDER_WINDOW)
+      update(order[order.size() - 1 - GORDER_WINDOW], false);
+    order.push_back(heap.extractMax());
+  }
+  return order;
+}
+
+
+std::vector<int> computeVertexOrder(const CompactGraph &g, VertexOrder order) {
+  switch (order) {
+  case VertexOrder::Degree:
+    return orderByDegree(g);
+  case VertexOrder::Rcm:
+    return orderByRcm(g);
+  case VertexOrder::Gorder:
+    return orderByGorder(g);
+  case VertexOrder::Insertion:
+    break;
+  }
+  std::vector<int> identity(g.getNrOfVertices());
+  std::iota(identity.begin(), identity.end(), 0);
+  return identity;
+}
+
+
+LocalityMetrics measureLocality(const CompactGraph &g) {
+  LocalityMetrics metrics;
+  double edgeGaps = 0, logEdgeGaps = 0, neighborGaps = 0;
+  std::size_t nrOfNeighborGaps = 0;
+  std::vector<int> neighbors;
+  for (int v = 0; v < g.getNrOfVertices(); ++v) {
+    const auto out = g.getOutNeighbors(v);
+    neighbors.assign(out.begin(), out.end());
+    std::sort(neighbors.begin(), neighbors.end());
+    for (std::size_t i = 0; i < neighbors.size(); ++i) {
+      const double gap = std::abs(neighbors[i] - v);
+      edgeGaps += gap;
+      logEdgeGaps += std::log2(1 + gap);
+      if (i > 0) {
+        neighborGaps += neighbors[i] - neighbors[i - 1];
+        ++nrOfNeighborGaps;
+      }
+    }
+  }
+  const double nrOfEdges = std::max<std::size_t>(1, g.getNrOfEdges());
+  metrics.averageEdgeGap = edgeGaps / nrOfEdges;
+  metrics.averageLogEdgeGap = logEdgeGaps / nrOfEdges;
+  metrics.averageNeighborGap = neighborGaps / std::max<std::size_t>(1, nrOfNeighborGaps);
+  return metrics;
+}
+
+} // namespace compact
+} // namespace graph
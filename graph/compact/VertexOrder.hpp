@@ -0,0 +1,36 @@
+#pragma once
+#include "CompactGraph.hpp"
+#include <string>
+#include <vector>
+
+namespace graph {
+namespace compact {
+
+// Numberings of the vertices of a CompactGraph that put the vertices used together next to each other, so
+// that the traversals read fewer cache lines (see CompactGraph(const CompactGraph &, order)).
+enum class VertexOrder {
+  Insertion, // the iteration order of the DirectedGraph, which is the order of its hash table
+  Degree,    // by decreasing degree (in + out): the hubs, which most edges lead to, share the first lines
+  Rcm,       // reverse Cuthill-McKee: BFS over the undirected edges from a low degree vertex, reversed
+  Gorder     // greedy: next is the vertex with the most edges and common in-neighbors with the last GORDER_WINDOW
+};
+
+constexpr int GORDER_WINDOW = 5;
+
+VertexOrder parseVertexOrder(const std::string &name);
+const char *getVertexOrderName(VertexOrder order);
+
+// order[new number] = old number
+std::vector<int> computeVertexOrder(const CompactGraph &g, VertexOrder order);
+
+// How far apart the ends of the edges are in the numbering
+struct LocalityMetrics {
+  double averageEdgeGap = 0;     // |from - to| over the edges
+  double averageLogEdgeGap = 0;  // log2(1 + |from - to|), about the bits a gap encoding would need
+  double averageNeighborGap = 0; // between consecutive neighbors of the sorted out lists
+};
+
+LocalityMetrics measureLocality(const CompactGraph &g);
+
+} // namespace compact
+} // namespace graph
@@ -0,0 +1,266 @@
+#pragma once
+#include "Concepts.hpp"
+#include "../compact/CompactGraph.hpp"
+#include "../compact/CompressedGraph.hpp"
+#include "../compact/MappedGraph.hpp"
+#include "../directed_graph/DirectedGraph.hpp"
+#include "../directed_graph/iterators/Iterators.hpp"
+#include "../undirected_graph/UndirectedGraph.hpp"
+
+namespace graph {
+namespace core {
+
+// Non owning views that let the generic algorithms run on the Graph hierarchy used by the console.
+// core::adapt(g) picks the right one.
+
+class DirectedGraphAdapter {
+private:
+  const DirectedGraph &g;
+
+public:
+  using VertexId = idT;
+  using Weight = int;
+  static constexpr bool isDirected = true;
+
+  explicit DirectedGraphAdapter(const DirectedGraph &g) : g(g) {}
+
+  std::size_t getNrOfVertices() const { return g.getNrOfVertices(); }
+  bool isVertex(const idT &v) const { return g.isVertex(v); }
+
+  template <typename Fn>
+  void forEachVertex(Fn &&fn) const {
+    for (const auto &[vertexId, _] : g)
+      fn(vertexId);
+  }
+
+  template <typename Fn>
+  void forEachOutEdge(const idT &v, Fn &&fn) const {
+    for (const auto &[_, toId, weight] : g.initOutboundEdgesIt(v))
+      fn(toId, weight);
+  }
+
+  template <typename Fn>
+  void forEachInEdge(const idT &v, Fn &&fn) const {
+    for (const auto &[fromId, _, weight] : g.initInboundEdgesIt(v))
+      fn(fromId, weight);
+  }
+};
+
+class UndirectedGraphAdapter {
+private:
+  const UndirectedGraph &g;
+
+public:
+  using VertexId = idT;
+  using Weight = int;
+  static constexpr bool isDirected = false;
+
+  explicit UndirectedGraphAdapter(const UndirectedGraph &g) : g(g) {}
+
+  std::size_t getNrOfVertices() const { return g.getNrOfVertices(); }
+  bool isVertex(const idT &v) const { return g.isVertex(v); }
+
+  template <typename Fn>
+  void forEachVertex(Fn &&fn) const {
+    for (const auto &[vertexId, _] : g)
+      fn(vertexId);
+  }
+
+  template <typename Fn>
+  void forEachOutEdge(const idT &v, Fn &&fn) const {
+    for (const auto &[_, toId, weight] : g.getAdjacentEdges(v))
+      fn(toId, weight);
+  }
+
+  template <typename Fn>
+  void forEachInEdge(const idT &v, Fn &&fn) const {
+    forEachOutEdge(v, fn);
+  }
+};
+
+// Vertex i of the adapter is index i of the compact graph
+class CompactGraphAdapter {
+private:
+  const compact::CompactGraph &g;
+
+public:
+  using VertexId = int;
+  using Weight = int;
+  static constexpr bool isDirected = true;
+
+  explicit CompactGraphAdapter(const compact::CompactGraph &g) : g(g) {}
+
+  std::size_t getNrOfVertices() const { return g.getNrOfVertices(); }
+  bool isVertex(int v) const { return v >= 0 && v < g.getNrOfVertices(); }
+  std::size_t getIndex(int v) const { return v; }
+
+  template <typename Fn>
+  void forEachVertex(Fn &&fn) const {
+    for (int v = 0; v < g.getNrOfVertices(); ++v)
+      fn(v);
+  }
+
+  template <typename Fn>
+  void forEachOutEdge(int v, Fn &&fn) const {
+    const auto neighbors = g.getOutNeighbors(v);
+    const auto weights = g.getOutWeights(v);
+    for (std::size_t e = 0; e < neighbors.size(); ++e)
+      fn(neighbors[e], weights[e]);
+  }
+
+  template <typename Fn>
+  void forEachInEdge(int v, Fn &&fn) const {
+    const auto neighbors = g.getInNeighbors(v);
+    const auto weights = g.getInWeights(v);
+    for (std::size_t e = 0; e < neighbors.size(); ++e)
+      fn(neighbors[e], weights[e]);
+  }
+};
+
+// Vertex i of the adapter is vertex i of the compressed graph, the lists are decoded as they are visited
+class CompressedGraphAdapter {
+private:
+  const compact::CompressedGraph &g;
+
+public:
+  using VertexId = int;
+  using Weight = int;
+  static constexpr bool isDirected = true;
+
+  explicit CompressedGraphAdapter(const compact::CompressedGraph &g) : g(g) {}
+
+  std::size_t getNrOfVertices() const { return g.getNrOfVertices(); }
+  bool isVertex(int v) const { return v >= 0 && v < g.getNrOfVertices(); }
+  std::size_t getIndex(int v) const { return v; }
+
+  template <typename Fn>
+  void forEachVertex(Fn &&fn) const {
+    for (int v = 0; v < g.getNrOfVertices(); ++v)
+      fn(v);
+  }
+
+  template <typename Fn>
+  void forEachOutEdge(int v, Fn &&fn) const { g.forEachOutEdge(v, fn); }
+  template <typename Fn>
+  void forEachInEdge(int v, Fn &&fn) const { g.forEachInEdge(v, fn); }
+};
+
+
+// Vertex i of the adapter is vertex i of the mapped graph, the lists are read in place from the mapping
+class MappedGraphAdapter {
+private:
+  const compact::MappedGraph &g;
+
+public:
+  using VertexId = int;
+  using Weight = int;
+  static constexpr bool isDirected = true;
+
+  explicit MappedGraphAdapter(const compact::MappedGraph &g) : g(g) {}
+
+  std::size_t getNrOfVertices() const { return g.getNrOfVertices(); }
+  bool isVertex(int v) const { return v >= 0 && v < g.getNrOfVertices(); }
+  std::size_t getIndex(int v) const { return v; }
+
+  template <typename Fn>
+  void forEachVertex(Fn &&fn) const {
+    for (int v = 0; v < g.getNrOfVertices(); ++v)
+      fn(v);
+  }
+
+  template <typename Fn>
+  void forEachOutEdge(int v, Fn &&fn) const { g.forEachOutEdge(v, fn); }
+  template <typename Fn>
+  void forEachInEdge(int v, Fn &&fn) const { g.forEachInEdge(v, fn); }
+};
+
+// The same graph with every edge reversed
+template <BidirectionalGraph G>
+class ReversedGraph {
+private:
+  const G &g;
+
+public:
+  using VertexId = typename G::VertexId;
+  using Weight = typename G::Weight;
+  static constexpr bool isDirected = G::isDirected;
+
+  explicit ReversedGraph(const G &g) : g(g) {}
+
+  std::size_t getNrOfVertices() const { return g.getNrOfVertices(); }
+  bool isVertex(const VertexId &v) const { return g.isVertex(v); }
+  std::size_t getIndex(const VertexId &v) const
+    requires IndexedGraph<G>
+  {
+    return g.getIndex(v);
+  }
+
+  template <typename Fn>
+  void forEachVertex(Fn &&fn) const { g.forEachVertex(fn); }
+  template <typename Fn>
+  void forEachOutEdge(const VertexId &v, Fn &&fn) const { g.forEachInEdge(v, fn); }
+  template <typename Fn>
+  void forEachInEdge(const VertexId &v, Fn &&fn) const { g.forEachOutEdge(v, fn); }
+};
+
+// The same graph with the direction of the edges dropped (weak connectivity): the edges of a vertex are
+// its outbound then its inbound ones, an edge in both directions is visited twice
+template <BidirectionalGraph G>
+class UndirectedView {
+private:
+  const G &g;
+
+public:
+  using VertexId = typename G::VertexId;
+  using Weight = typename G::Weight;
+  static constexpr bool isDirected = false;
+
+  explicit UndirectedView(const G &g) : g(g) {}
+
+  std::size_t getNrOfVertices() const { return g.getNrOfVertices(); }
+  bool isVertex(const VertexId &v) const { return g.isVertex(v); }
+  std::size_t getIndex(const VertexId &v) const
+    requires IndexedGraph<G>
+  {
+    return g.getIndex(v);
+  }
+
+  template <typename Fn>
+  void forEachVertex(Fn &&fn) const { g.forEachVertex(fn); }
+  template <typename Fn>
+  void forEachOutEdge(const VertexId &v, Fn &&fn) const {
+    g.forEachOutEdge(v, fn);
+    g.forEachInEdge(v, fn);
+  }
+  template <typename Fn>
+  void forEachInEdge(const VertexId &v, Fn &&fn) const { forEachOutEdge(v, fn); }
+};
+
+inline DirectedGraphAdapter adapt(const DirectedGraph &g) {
+  return DirectedGraphAdapter(g);
+}
+
+inline UndirectedGraphAdapter adapt(const UndirectedGraph &g) {
+  return UndirectedGraphAdapter(g);
+}
+
+inline CompactGraphAdapter adapt(const compact::CompactGraph &g) {
+  return CompactGraphAdapter(g);
+}
+
+static_assert(BidirectionalGraph<DirectedGraphAdapter>);
+static_assert(BidirectionalGraph<UndirectedGraphAdapter>);
+inline CompressedGraphAdapter adapt(const compact::CompressedGraph &g) {
+  return CompressedGraphAdapter(g);
+}
+inline MappedGraphAdapter adapt(const compact::MappedGraph &g) {
+  return MappedGraphAdapter(g);
+}
+
+static_assert(BidirectionalGraph<CompactGraphAdapter> && IndexedGraph<CompactGraphAdapter>);
+static_assert(BidirectionalGraph<CompressedGraphAdapter> && IndexedGraph<CompressedGraphAdapter>);
+static_assert(UndirectedIncidenceGraph<UndirectedView<CompressedGraphAdapter>>);
+static_assert(BidirectionalGraph<MappedGraphAdapter> && IndexedGraph<MappedGraphAdapter>);
+
+} // namespace core
+} // namespace graph
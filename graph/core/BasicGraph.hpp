@@ -0,0 +1,250 @@
+#pragma once
+#include "Concepts.hpp"
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace graph {
+namespace core {
+
+struct Directed {
+  static constexpr bool isDirected = true;
+};
+
+struct Undirected {
+  static constexpr bool isDirected = false;
+};
+
+// Adjacency storages of BasicGraph. A storage keeps, for every vertex, the list of
+// (neighbor, weight) pairs of its outbound and of its inbound edges.
+
+// Any hashable vertex id
+template <typename VertexId, typename Weight>
+class HashStorage {
+public:
+  using EdgeList = std::vector<std::pair<VertexId, Weight>>;
+
+  bool addVertex(const VertexId &v) {
+    return adjacency.try_emplace(v).second;
+  }
+  bool removeVertex(const VertexId &v) {
+    return adjacency.erase(v) != 0;
+  }
+  bool isVertex(const VertexId &v) const {
+    return adjacency.contains(v);
+  }
+  std::size_t getNrOfVertices() const {
+    return adjacency.size();
+  }
+  template <typename Fn>
+  void forEachVertex(Fn &&fn) const {
+    for (const auto &[v, _] : adjacency)
+      fn(v);
+  }
+
+  EdgeList &out(const VertexId &v) { return adjacency.at(v).first; }
+  const EdgeList &out(const VertexId &v) const { return adjacency.at(v).first; }
+  EdgeList &in(const VertexId &v) { return adjacency.at(v).second; }
+  const EdgeList &in(const VertexId &v) const { return adjacency.at(v).second; }
+
+  void clear() {
+    adjacency.clear();
+  }
+
+private:
+  std::unordered_map<VertexId, std::pair<EdgeList, EdgeList>> adjacency;
+};
+
+// Integral vertex ids 0..n-1, adding a vertex adds all the smaller ones as well
+template <std::integral VertexId, typename Weight>
+class VectorStorage {
+public:
+  using EdgeList = std::vector<std::pair<VertexId, Weight>>;
+
+  bool addVertex(const VertexId &v) {
+    if (v < 0)
+      throw std::runtime_error("Vertex ids have to be non-negative");
+    if (isVertex(v))
+      return false;
+    outEdges.resize((std::size_t)v + 1);
+    inEdges.resize((std::size_t)v + 1);
+    return true;
+  }
+  bool isVertex(const VertexId &v) const {
+    return v >= 0 && (std::size_t)v < outEdges.size();
+  }
+  std::size_t getNrOfVertices() const {
+    return outEdges.size();
+  }
+  std::size_t getIndex(const VertexId &v) const {
+    return (std::size_t)v;
+  }
+  template <typename Fn>
+  void forEachVertex(Fn &&fn) const {
+    for (std::size_t v = 0; v < outEdges.size(); ++v)
+      fn((VertexId)v);
+  }
+
+  EdgeList &out(const VertexId &v) { return outEdges[v]; }
+  const EdgeList &out(const VertexId &v) const { return outEdges[v]; }
+  EdgeList &in(const VertexId &v) { return inEdges[v]; }
+  const EdgeList &in(const VertexId &v) const { return inEdges[v]; }
+
+  void clear() {
+    outEdges.clear();
+    inEdges.clear();
+  }
+
+private:
+  std::vector<EdgeList> outEdges;
+  std::vector<EdgeList> inEdges;
+};
+
+// Value type graph with vertex ids and weights of any type, statically dispatched.
+// Undirected edges are stored once at each end, in the outbound lists.
+template <typename VertexIdT, EdgeWeight WeightT = int, typename Directedness = Directed,
+          template <typename, typename> class Storage = HashStorage>
+class BasicGraph {
+public:
+  using VertexId = VertexIdT;
+  using Weight = WeightT;
+  static constexpr bool isDirected = Directedness::isDirected;
+
+  void addVertex(const VertexId &v) {
+    if (!storage.addVertex(v))
+      throw std::runtime_error("Vertex Already added");
+  }
+
+  void removeVertex(const VertexId &v)
+    requires requires(Storage<VertexId, Weight> s, const VertexId &id) { s.removeVertex(id); }
+  {
+    if (!isVertex(v))
+      throw std::runtime_error("Vertex not in the graph");
+    std::vector<VertexId> neighbors;
+    forEachOutEdge(v, [&](const VertexId &to, const Weight &) { neighbors.push_back(to); });
+    forEachInEdge(v, [&](const VertexId &from, const Weight &) { neighbors.push_back(from); });
+    for (const auto &neighbor : neighbors)
+      if (neighbor != v) {
+        eraseFrom(storage.out(neighbor), v);
+        eraseFrom(storage.in(neighbor), v);
+      }
+    nrOfEdges -= storage.out(v).size() + (isDirected ? storage.in(v).size() : 0);
+    if (isDirected && find(storage.out(v), v) != storage.out(v).end())
+      ++nrOfEdges; // a self loop was counted twice
+    storage.removeVertex(v);
+  }
+
+  bool isVertex(const VertexId &v) const {
+    return storage.isVertex(v);
+  }
+
+  std::size_t getNrOfVertices() const {
+    return storage.getNrOfVertices();
+  }
+
+  std::size_t getIndex(const VertexId &v) const
+    requires requires(const Storage<VertexId, Weight> s, const VertexId &id) { s.getIndex(id); }
+  {
+    return storage.getIndex(v);
+  }
+
+  void addEdge(const VertexId &from, const VertexId &to, const Weight &weight = Weight{1}) {
+    checkVertices(from, to);
+    if (isEdge(from, to))
+      throw std::runtime_error("The edge already exists");
+    storage.out(from).push_back({to, weight});
+    if constexpr (isDirected)
+      storage.in(to).push_back({from, weight});
+    else if (from != to)
+      storage.out(to).push_back({from, weight});
+    ++nrOfEdges;
+  }
+
+  void removeEdge(const VertexId &from, const VertexId &to) {
+    checkVertices(from, to);
+    if (!isEdge(from, to))
+      throw std::runtime_error("The edge is not in the graph");
+    eraseFrom(storage.out(from), to);
+    if constexpr (isDirected)
+      eraseFrom(storage.in(to), from);
+    else if (from != to)
+      eraseFrom(storage.out(to), from);
+    --nrOfEdges;
+  }
+
+  bool isEdge(const VertexId &from, const VertexId &to) const {
+    if (!isVertex(from) || !isVertex(to))
+      return false;
+    return find(storage.out(from), to) != storage.out(from).end();
+  }
+
+  const Weight &getEdgeWeight(const VertexId &from, const VertexId &to) const {
+    checkVertices(from, to);
+    auto it = find(storage.out(from), to);
+    if (it == storage.out(from).end())
+      throw std::runtime_error("The edge is not in the graph");
+    return it->second;
+  }
+
+  std::size_t getNrOfEdges() const {
+    return nrOfEdges;
+  }
+
+  template <typename Fn>
+  void forEachVertex(Fn &&fn) const {
+    storage.forEachVertex(fn);
+  }
+
+  template <typename Fn>
+  void forEachOutEdge(const VertexId &v, Fn &&fn) const {
+    for (const auto &[to, weight] : storage.out(v))
+      fn(to, weight);
+  }
+
+  template <typename Fn>
+  void forEachInEdge(const VertexId &v, Fn &&fn) const {
+    for (const auto &[from, weight] : isDirected ? storage.in(v) : storage.out(v))
+      fn(from, weight);
+  }
+
+  std::size_t getOutDegree(const VertexId &v) const {
+    return storage.out(v).size();
+  }
+
+  std::size_t getInDegree(const VertexId &v) const {
+    return isDirected ? storage.in(v).size() : storage.out(v).size();
+  }
+
+  void clear() {
+    storage.clear();
+    nrOfEdges = 0;
+  }
+
+private:
+  using EdgeList = typename Storage<VertexId, Weight>::EdgeList;
+
+  Storage<VertexId, Weight> storage;
+  std::size_t nrOfEdges = 0;
+
+  void checkVertices(const VertexId &from, const VertexId &to) const {
+    if (!isVertex(from))
+      throw std::runtime_error("from is not in the graph");
+    if (!isVertex(to))
+      throw std::runtime_error("to is not in the graph");
+  }
+
+  static typename EdgeList::const_iterator find(const EdgeList &edges, const VertexId &v) {
+    return std::find_if(edges.begin(), edges.end(), [&](const auto &edge) { return edge.first == v; });
+  }
+
+  static void eraseFrom(EdgeList &edges, const VertexId &v) {
+    std::erase_if(edges, [&](const auto &edge) { return edge.first == v; });
+  }
+};
+
+} // namespace core
+} // namespace graph
@@ -0,0 +1,53 @@
+#pragma once
+#include <concepts>
+#include <cstddef>
+
+namespace graph {
+namespace core {
+
+// What the generic algorithms need from a graph representation. They are satisfied by
+// BasicGraph and by the adapters of the Graph hierarchy (Adapters.hpp); the algorithms
+// are templates over them, so every edge visit is a direct (inlinable) call.
+
+// Weights only have to be ordered and closed under addition: int, int64_t, double...
+template <typename W>
+concept EdgeWeight = std::regular<W> && std::totally_ordered<W> && requires(W a, W b) {
+  { a + b } -> std::convertible_to<W>;
+};
+
+// Vertices can be counted and visited: forEachVertex(fn(vertexId))
+template <typename G>
+concept VertexListGraph = requires(const G &g) {
+  typename G::VertexId;
+  typename G::Weight;
+  { G::isDirected } -> std::convertible_to<bool>;
+  { g.getNrOfVertices() } -> std::convertible_to<std::size_t>;
+  g.forEachVertex([](const typename G::VertexId &) {});
+};
+
+// The outbound edges of a vertex can be visited: forEachOutEdge(vertexId, fn(toId, weight)).
+// For undirected graphs these are all the edges of the vertex.
+template <typename G>
+concept IncidenceGraph = VertexListGraph<G> && EdgeWeight<typename G::Weight> &&
+                         requires(const G &g, const typename G::VertexId &v) {
+  { g.isVertex(v) } -> std::convertible_to<bool>;
+  g.forEachOutEdge(v, [](const typename G::VertexId &, const typename G::Weight &) {});
+};
+
+// The inbound edges can be visited as well: forEachInEdge(vertexId, fn(fromId, weight))
+template <typename G>
+concept BidirectionalGraph = IncidenceGraph<G> && requires(const G &g, const typename G::VertexId &v) {
+  g.forEachInEdge(v, [](const typename G::VertexId &, const typename G::Weight &) {});
+};
+
+// The vertices are numbered 0..n-1 by getIndex, so per vertex data can live in a vector
+template <typename G>
+concept IndexedGraph = VertexListGraph<G> && requires(const G &g, const typename G::VertexId &v) {
+  { g.getIndex(v) } -> std::convertible_to<std::size_t>;
+};
+
+template <typename G>
+concept UndirectedIncidenceGraph = IncidenceGraph<G> && !G::isDirected;
+
+} // namespace core
+} // namespace graph
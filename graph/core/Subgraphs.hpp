@@ -0,0 +1,180 @@
+#pragma once
+#include "Concepts.hpp"
+#include "VertexMap.hpp"
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace graph {
+namespace core {
+
+// Subgraphs that are never materialized: they keep a reference to the graph they restrict and
+// filter its vertices or edges while the algorithms visit them, so the graph must outlive them.
+// Like ReversedGraph they satisfy the concepts of the graph they wrap (except IndexedGraph when
+// the vertex set shrinks: the indexes of the wrapped graph are not dense any more).
+
+// The subgraph induced by a set of vertices: those vertices and the edges between them
+template <IncidenceGraph G>
+class InducedSubgraph {
+private:
+  const G &g;
+  std::vector<typename G::VertexId> vertices;
+  VertexMap<G, char> member; // a vector over the indexes of g when it has them
+
+public:
+  using VertexId = typename G::VertexId;
+  using Weight = typename G::Weight;
+  static constexpr bool isDirected = G::isDirected;
+
+  // The vertices that are not in g are ignored, and so are the repeated ones
+  InducedSubgraph(const G &g, const std::vector<VertexId> &vertexIds) : g(g), member(g, 0) {
+    for (const auto &v : vertexIds)
+      if (g.isVertex(v) && !member[v]) {
+        member[v] = 1;
+        vertices.push_back(v);
+      }
+  }
+
+  // The vertices whose bit is set, by index of g
+  InducedSubgraph(const G &g, const std::vector<bool> &bitmap)
+    requires IndexedGraph<G>
+      : g(g), member(g, 0) {
+    g.forEachVertex([&](const VertexId &v) {
+      if (g.getIndex(v) < bitmap.size() && bitmap[g.getIndex(v)]) {
+        member[v] = 1;
+        vertices.push_back(v);
+      }
+    });
+  }
+
+  std::size_t getNrOfVertices() const { return vertices.size(); }
+  bool isVertex(const VertexId &v) const { return g.isVertex(v) && member[v]; }
+
+  template <typename Fn>
+  void forEachVertex(Fn &&fn) const {
+    for (const auto &v : vertices)
+      fn(v);
+  }
+
+  template <typename Fn>
+  void forEachOutEdge(const VertexId &v, Fn &&fn) const {
+    g.forEachOutEdge(v, [&](const VertexId &to, const Weight &weight) {
+      if (member[to])
+        fn(to, weight);
+    });
+  }
+
+  template <typename Fn>
+  void forEachInEdge(const VertexId &v, Fn &&fn) const
+    requires BidirectionalGraph<G>
+  {
+    g.forEachInEdge(v, [&](const VertexId &from, const Weight &weight) {
+      if (member[from])
+        fn(from, weight);
+    });
+  }
+};
+
+
+// All the vertices, and the edges keep(from, to, weight) accepts. On undirected graphs every edge is
+// visited from both ends, so keep has to give the same answer for (u, v) and (v, u).
+template <IncidenceGraph G, typename EdgePredicate>
+class EdgeFilteredGraph {
+private:
+  const G &g;
+  EdgePredicate keep;
+
+public:
+  using VertexId = typename G::VertexId;
+  using Weight = typename G::Weight;
+  static constexpr bool isDirected = G::isDirected;
+
+  EdgeFilteredGraph(const G &g, EdgePredicate keep) : g(g), keep(std::move(keep)) {}
+
+  std::size_t getNrOfVertices() const { return g.getNrOfVertices(); }
+  bool isVertex(const VertexId &v) const { return g.isVertex(v); }
+  std::size_t getIndex(const VertexId &v) const
+    requires IndexedGraph<G>
+  {
+    return g.getIndex(v);
+  }
+
+  template <typename Fn>
+  void forEachVertex(Fn &&fn) const { g.forEachVertex(fn); }
+
+  template <typename Fn>
+  void forEachOutEdge(const VertexId &v, Fn &&fn) const {
+    g.forEachOutEdge(v, [&](const VertexId &to, const Weight &weight) {
+      if (keep(v, to, weight))
+        fn(to, weight);
+    });
+  }
+
+  template <typename Fn>
+  void forEachInEdge(const VertexId &v, Fn &&fn) const
+    requires BidirectionalGraph<G>
+  {
+    g.forEachInEdge(v, [&](const VertexId &from, const Weight &weight) {
+      if (keep(from, v, weight))
+        fn(from, weight);
+    });
+  }
+};
+
+
+// The connected components of an undirected graph, labelled 0..k-1 in the order they are given
+// (algorithms::connectedComponents). Computed once, shared by the ComponentSubgraph views.
+template <UndirectedIncidenceGraph G>
+class ComponentLabels {
+private:
+  std::vector<std::vector<typename G::VertexId>> components;
+  VertexMap<G, int> labels;
+
+public:
+  using VertexId = typename G::VertexId;
+
+  ComponentLabels(const G &g, std::vector<std::vector<VertexId>> components)
+      : components(std::move(components)), labels(g, -1) {
+    for (std::size_t label = 0; label < this->components.size(); ++label)
+      for (const auto &v : this->components[label])
+        labels[v] = label;
+  }
+
+  std::size_t getNrOfComponents() const { return components.size(); }
+  const std::vector<VertexId> &getVertices(std::size_t label) const { return components[label]; }
+  int getLabel(const VertexId &v) const { return labels[v]; }
+};
+
+
+// One connected component. No edge leaves a component, so the edges of its vertices go through unfiltered.
+template <UndirectedIncidenceGraph G>
+class ComponentSubgraph {
+private:
+  const G &g;
+  const ComponentLabels<G> &labels;
+  int label;
+
+public:
+  using VertexId = typename G::VertexId;
+  using Weight = typename G::Weight;
+  static constexpr bool isDirected = false;
+
+  ComponentSubgraph(const G &g, const ComponentLabels<G> &labels, int label) : g(g), labels(labels), label(label) {}
+
+  std::size_t getNrOfVertices() const { return labels.getVertices(label).size(); }
+  bool isVertex(const VertexId &v) const { return g.isVertex(v) && labels.getLabel(v) == label; }
+
+  template <typename Fn>
+  void forEachVertex(Fn &&fn) const {
+    for (const auto &v : labels.getVertices(label))
+      fn(v);
+  }
+
+  template <typename Fn>
+  void forEachOutEdge(const VertexId &v, Fn &&fn) const { g.forEachOutEdge(v, fn); }
+  template <typename Fn>
+  void forEachInEdge(const VertexId &v, Fn &&fn) const { g.forEachOutEdge(v, fn); }
+};
+
+} // namespace core
+} // namespace graph
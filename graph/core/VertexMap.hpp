@@ -0,0 +1,53 @@
+#pragma once
+#include "Concepts.hpp"
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace graph {
+namespace core {
+
+// Per vertex data of a generic algorithm. Every vertex starts with the default value.
+// Graphs with dense indexes get a plain vector, the others a hash map.
+template <VertexListGraph G, typename T>
+class VertexMap {
+private:
+  std::unordered_map<typename G::VertexId, T> values;
+  T defaultValue;
+
+public:
+  explicit VertexMap(const G &g, T defaultValue = T{}) : defaultValue(std::move(defaultValue)) {
+    values.reserve(g.getNrOfVertices());
+  }
+
+  T &operator[](const typename G::VertexId &v) {
+    return values.try_emplace(v, defaultValue).first->second;
+  }
+
+  const T &operator[](const typename G::VertexId &v) const {
+    auto it = values.find(v);
+    return it == values.end() ? defaultValue : it->second;
+  }
+};
+
+template <VertexListGraph G, typename T>
+  requires IndexedGraph<G>
+class VertexMap<G, T> {
+private:
+  const G *g;
+  std::vector<T> values;
+
+public:
+  explicit VertexMap(const G &g, T defaultValue = T{}) : g(&g), values(g.getNrOfVertices(), std::move(defaultValue)) {}
+
+  T &operator[](const typename G::VertexId &v) {
+    return values[g->getIndex(v)];
+  }
+
+  const T &operator[](const typename G::VertexId &v) const {
+    return values[g->getIndex(v)];
+  }
+};
+
+} // namespace core
+} // namespace graph
@@ -1,5 +1,6 @@
 #include "DirectedGraph.hpp"
 #include "iterators/Iterators.hpp"
+#include <algorithm>
 #include <format>
 
 namespace graph {
@@ -9,11 +10,29 @@ GraphType DirectedGraph::getGraphType() const {
   return GraphType::Directed;
 }
 
+
+/* Returns a copy that shares the vertices and the adjacency with this graph until one of them changes */
+std::unique_ptr<Graph> DirectedGraph::clone() const {
+  return std::make_unique<DirectedGraph>(*this);
+}
+
+
+void DirectedGraph::replaceVertices(const std::function<VertexSharedPtr(const VertexSharedPtr &)> &copy) {
+  std::vector<idT> ids;
+  ids.reserve(vertices.size());
+  for (const auto &[id, _] : vertices)
+    ids.push_back(id);
+  for (const auto &id : ids) {
+    auto &vertex = vertices.getMutable(id);
+    vertex = copy(vertex);
+  }
+}
+
 // Methods on vertices
 
 /* Returns true if the vertex is in the graph, else false */
 bool DirectedGraph::isVertex(const idT &id) const {
-  return vertices.find(id) != vertices.end();
+  return vertices.contains(id);
 }
 
 
@@ -22,21 +41,29 @@ void DirectedGraph::addVertex(const VertexSharedPtr &v) {
   if (isVertex(v->getId()))
     throw std::runtime_error("Vertex Already added");
 
-  outAdjacency[v->getId()] = std::unordered_set<idT>();
-  inAdjacency[v->getId()] = std::unordered_set<idT>();
+  outAdjacency.insert({v->getId(), {}});
+  inAdjacency.insert({v->getId(), {}});
   vertices.insert({v->getId(), v});
 }
 
 
-/* Removes the vertex from the graph */
+/* Removes the vertex from the graph, with its edges in both directions */
 void DirectedGraph::removeVertex(const idT &id) {
   if (!isVertex(id))
     throw std::runtime_error("Vertex not in the graph");
 
-  for (const auto &ver : outAdjacency[id]) {
-    inAdjacency[ver].erase(id);
+  for (const auto &toId : *outAdjacency.at(id)) {
+    if (toId != id)
+      inAdjacency.getMutable(toId).mutate().erase(id);
+    weights.erase({id, toId});
+  }
+  for (const auto &fromId : *inAdjacency.at(id)) {
+    if (fromId != id)
+      outAdjacency.getMutable(fromId).mutate().erase(id);
+    weights.erase({fromId, id});
   }
   outAdjacency.erase(id);
+  inAdjacency.erase(id);
   vertices.erase(id);
 }
 
@@ -59,7 +86,7 @@ std::unordered_set<idT> DirectedGraph::getAllOutboundVertices(const idT &id) con
   if (!isVertex(id))
     throw std::runtime_error("v is not in the graph");
 
-  return outAdjacency.at(id);
+  return *outAdjacency.at(id);
 }
 
 
@@ -67,7 +94,7 @@ std::unordered_set<idT> DirectedGraph::getAllInboundVertices(const idT &id) cons
   if (!isVertex(id))
     throw std::runtime_error("v is not in the graph");
 
-  return inAdjacency.at(id);
+  return *inAdjacency.at(id);
 }
 
 
@@ -76,7 +103,7 @@ std::unordered_set<idT> DirectedGraph::getAllInboundVertices(const idT &id) cons
 /* Returns true if the edge is in the graph, else false */
 bool DirectedGraph::isEdge(const idT &fromId, const idT &toId) const {
   return isVertex(fromId) && isVertex(toId) &&
-         outAdjacency.at(fromId).find(toId) != outAdjacency.at(fromId).end();
+         outAdjacency.at(fromId)->contains(toId);
 }
 
 
@@ -89,8 +116,8 @@ void DirectedGraph::addEdge(const idT &fromId, const idT &toId, int weight) {
   if (isEdge(fromId, toId))
     throw std::runtime_error(std::format("The edge({} -> {}) already exists", fromId, toId));
 
-  outAdjacency[fromId].insert(toId);
-  inAdjacency[toId].insert(fromId);
+  outAdjacency.getMutable(fromId).mutate().insert(toId);
+  inAdjacency.getMutable(toId).mutate().insert(fromId);
   weights.insert({fromId, toId, weight});
 }
 
@@ -104,8 +131,8 @@ void DirectedGraph::removeEdge(const idT &fromId, const idT &toId) {
   if (!isEdge(fromId, toId))
     throw std::runtime_error("The edge does not exist");
 
-  outAdjacency[fromId].erase(toId);
-  inAdjacency[toId].erase(fromId);
+  outAdjacency.getMutable(fromId).mutate().erase(toId);
+  inAdjacency.getMutable(toId).mutate().erase(fromId);
   weights.erase({fromId, toId});
 }
 
@@ -137,16 +164,45 @@ std::vector<Edge> DirectedGraph::getEdges() const {
 }
 
 
+/* Walks the chunks of the weight set: a page resumes in the chunk it stopped in, whole chunks are skipped */
+std::size_t DirectedGraph::visitEdges(EdgeCursor &cursor, std::size_t limit, const EdgeVisitor &visit) const {
+  std::size_t passed = 0;
+  for (; !cursor.atEnd && passed < limit; ++cursor.chunk, cursor.offset = 0) {
+    if (cursor.chunk >= std::min(weights.getNrOfChunks(), cursor.endChunk)) {
+      cursor.atEnd = true;
+      break;
+    }
+    const auto &chunk = weights.getChunk(cursor.chunk);
+    if (!visit && chunk.size() - cursor.offset <= limit - passed) {
+      passed += chunk.size() - cursor.offset;
+      continue;
+    }
+    auto it = std::next(chunk.begin(), cursor.offset);
+    for (; it != chunk.end() && passed < limit; ++it, ++cursor.offset, ++passed)
+      if (visit)
+        visit(it->fromId, it->toId, it->weight);
+    if (it != chunk.end())
+      return passed;
+  }
+  return passed;
+}
+
+
+std::size_t DirectedGraph::getNrOfEdgeChunks() const {
+  return weights.getNrOfChunks();
+}
+
+
 // Iterators 
 
 /* Returns a constant iterator to the begining of the vertices (the order is not guaranteed) */
-std::unordered_map<idT, VertexSharedPtr>::const_iterator DirectedGraph::begin() const {
+VertexMap::const_iterator DirectedGraph::begin() const {
   return vertices.begin();
 }
 
 
 /* Returns a constant iterator to the end of the vertices */
-std::unordered_map<idT, VertexSharedPtr>::const_iterator DirectedGraph::end() const {
+VertexMap::const_iterator DirectedGraph::end() const {
   return vertices.end();
 }
 
@@ -172,10 +228,10 @@ AdjacentEdgesView DirectedGraph::getAdjacentEdges(const idT &id) const {
 
   AdjacentEdgesView view;
 
-  for (const auto &toId : outAdjacency.at(id)) {
+  for (const auto &toId : *outAdjacency.at(id)) {
     view.addEdge(Edge{id, toId, getEdgeWeight(id, toId)});
   }
-  for (const auto &fromId : inAdjacency.at(id)) {
+  for (const auto &fromId : *inAdjacency.at(id)) {
     view.addEdge(Edge{fromId, id, getEdgeWeight(fromId, id)});
   }
 
@@ -198,7 +254,7 @@ void DirectedGraph::clear() {
 int DirectedGraph::getInDegree(const idT &id) const {
   if (!isVertex(id))
     throw std::runtime_error("Vertex is not in the graph");
-  return inAdjacency.at(id).size();
+  return inAdjacency.at(id)->size();
 }
 
 
@@ -206,7 +262,57 @@ int DirectedGraph::getInDegree(const idT &id) const {
 int DirectedGraph::getOutDegree(const idT &id) const {
   if (!isVertex(id))
     throw std::runtime_error("Vertex is not in the graph");
-  return outAdjacency.at(id).size();
+  return outAdjacency.at(id)->size();
+}
+
+
+/* Returns the bytes held by the vertices, the adjacency sets and the weights */
+utils::MemoryReport DirectedGraph::getMemoryUsage() const {
+  utils::MemoryReport report;
+  report.nrOfVertices = vertices.size();
+  report.nrOfEdges = weights.size();
+  std::size_t idBytes = 0;
+  for (const auto &[id, vertex] : vertices) {
+    vertex->addMemoryUsage(report);
+    idBytes += utils::stringHeapBytes(id);
+  }
+  report.add("vertex map", vertices.size() * utils::hashNodeChunkBytes<VertexMap::value_type>(), vertices.size());
+  report.add("cow chunks", vertices.getChunkBytes());
+  report.add("id strings", idBytes);
+  report.add("hash buckets", utils::bucketArrayBytes(vertices));
+  utils::addAdjacencyUsage(report, "out adjacency", outAdjacency);
+  utils::addAdjacencyUsage(report, "in adjacency", inAdjacency);
+
+  idBytes = 0;
+  for (const auto &edge : weights)
+    idBytes += utils::stringHeapBytes(edge.fromId) + utils::stringHeapBytes(edge.toId);
+  report.add("weight set", weights.size() * utils::hashNodeChunkBytes<Edge>(), weights.size());
+  report.add("cow chunks", weights.getChunkBytes());
+  report.add("id strings", idBytes);
+  report.add("hash buckets", utils::bucketArrayBytes(weights));
+  return report;
+}
+
+
+/* Returns the bytes a graph with the given sizes will hold, laid out as in getMemoryUsage */
+utils::MemoryReport DirectedGraph::projectMemoryUsage(std::size_t nrOfVertices, std::size_t nrOfEdges,
+                                                      std::size_t averageIdLength, std::size_t vertexObjectBytes) {
+  utils::MemoryReport report;
+  report.nrOfVertices = nrOfVertices;
+  report.nrOfEdges = nrOfEdges;
+  const std::size_t idHeapBytes = utils::stringHeapBytes(averageIdLength);
+  report.add("vertex objects", nrOfVertices * vertexObjectBytes, nrOfVertices);
+  report.add("vertex map", nrOfVertices * utils::hashNodeChunkBytes<VertexMap::value_type>(), nrOfVertices);
+  report.add("cow chunks", VertexMap::projectChunkBytes(nrOfVertices));
+  report.add("id strings", 2 * nrOfVertices * idHeapBytes); // the id of the vertex and the key of the map
+  report.add("hash buckets", utils::bucketArrayBytes(utils::projectedBucketCount(nrOfVertices)));
+  utils::projectAdjacencyUsage<AdjacencyMap>(report, "out adjacency", nrOfVertices, nrOfEdges, idHeapBytes);
+  utils::projectAdjacencyUsage<AdjacencyMap>(report, "in adjacency", nrOfVertices, nrOfEdges, idHeapBytes);
+  report.add("weight set", nrOfEdges * utils::hashNodeChunkBytes<Edge>(), nrOfEdges);
+  report.add("cow chunks", EdgeSet::projectChunkBytes(nrOfEdges));
+  report.add("id strings", 2 * nrOfEdges * idHeapBytes);
+  report.add("hash buckets", utils::bucketArrayBytes(utils::projectedBucketCount(nrOfEdges)));
+  return report;
 }
 
 
@@ -1,5 +1,6 @@
 #pragma once
 #include "../abstract/Graph.hpp"
+#include "../vertices/StringVertex.hpp"
 #include <unordered_map>
 #include <unordered_set>
 
@@ -11,10 +12,10 @@ class OutboundEdgesIterator;
 
 class DirectedGraph : public Graph {
 private:
-  std::unordered_set<Edge, EdgeHash> weights;
-  std::unordered_map<idT, VertexSharedPtr> vertices;
-  std::unordered_map<idT, std::unordered_set<idT>> outAdjacency;
-  std::unordered_map<idT, std::unordered_set<idT>> inAdjacency;
+  EdgeSet weights;
+  VertexMap vertices;
+  AdjacencyMap outAdjacency;
+  AdjacencyMap inAdjacency;
   friend class InboundEdgesIterator;
   friend class OutboundEdgesIterator;
 
@@ -22,6 +23,7 @@ public:
   DirectedGraph() : inAdjacency(), outAdjacency(), weights(), vertices() {}
 
   GraphType getGraphType() const override;
+  std::unique_ptr<Graph> clone() const override;
   // Methods on vertices
   bool isVertex(const idT &id) const override;
   void addVertex(const VertexSharedPtr &v) override;
@@ -39,12 +41,14 @@ public:
   int getEdgeWeight(const idT &fromId, const idT &toId) const override;
 
   std::vector<Edge> getEdges() const override;
+  std::size_t visitEdges(EdgeCursor &cursor, std::size_t limit, const EdgeVisitor &visit) const override;
+  std::size_t getNrOfEdgeChunks() const override;
 
 
 
   // Iterators
-  std::unordered_map<idT, VertexSharedPtr>::const_iterator begin() const override;
-  std::unordered_map<idT, VertexSharedPtr>::const_iterator end() const override;
+  VertexMap::const_iterator begin() const override;
+  VertexMap::const_iterator end() const override;
 
   OutboundEdgesIterator initOutboundEdgesIt(const idT &id) const;
   InboundEdgesIterator initInboundEdgesIt(const idT &id) const;
@@ -57,5 +61,15 @@ public:
   int getInDegree(const idT &id) const;
 
   int getOutDegree(const idT &id) const;
+
+  utils::MemoryReport getMemoryUsage() const override;
+  // What a graph with these sizes will take, before it is built
+  static utils::MemoryReport projectMemoryUsage(std::size_t nrOfVertices, std::size_t nrOfEdges,
+                                                std::size_t averageIdLength,
+                                                std::size_t vertexObjectBytes = utils::sharedObjectBytes<StringVertex>());
+
+protected:
+  // Replaces every vertex object by copy(vertex), for the subclasses whose vertices hold state of their own
+  void replaceVertices(const std::function<VertexSharedPtr(const VertexSharedPtr &)> &copy);
 };
 }// namespace graph
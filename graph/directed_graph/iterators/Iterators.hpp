@@ -41,11 +41,11 @@ public:
     : graph(graph), vertexId(vertexId) {}
 
   Iterator begin() const {
-    return Iterator(graph.outAdjacency.at(vertexId).begin(), vertexId, graph);
+    return Iterator(graph.outAdjacency.at(vertexId)->begin(), vertexId, graph);
   }
 
   Iterator end() const {
-    return Iterator(graph.outAdjacency.at(vertexId).end(), vertexId, graph);
+    return Iterator(graph.outAdjacency.at(vertexId)->end(), vertexId, graph);
   }
 };
 
@@ -86,11 +86,11 @@ public:
     : graph(graph), vertexId(vertexId) {}
 
   Iterator begin() const {
-    return Iterator(graph.inAdjacency.at(vertexId).begin(), vertexId, graph);
+    return Iterator(graph.inAdjacency.at(vertexId)->begin(), vertexId, graph);
   }
 
   Iterator end() const {
-    return Iterator(graph.inAdjacency.at(vertexId).end(), vertexId, graph);
+    return Iterator(graph.inAdjacency.at(vertexId)->end(), vertexId, graph);
   }
 };
 
@@ -0,0 +1,542 @@
+#include "BspEngine.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace graph {
+namespace distributed {
+
+// The protocol between the coordinator and a worker, in the native byte order (both are this program):
+//   worker       Hello, once it loaded its shard
+//   coordinator  Start + the source id     worker  uint64 1 if it owns the source, else 0
+//   coordinator  Step                      worker  StepReport, after the superstep
+//   coordinator  Collect                   worker  its vertices and their values (and ids) as vectors
+// A worker exits when the coordinator closes its socket.
+enum class Command : std::uint32_t { Start = 1, Step, Collect };
+
+struct CommandHeader {
+  Command command;
+  std::int32_t argument; // the algorithm for Start, 1 to collect the ids for Collect
+  std::uint64_t payloadBytes;
+};
+
+struct Hello {
+  std::uint32_t shard;
+  std::uint32_t nrOfShards;
+  std::uint64_t nrOfVertices, nrOfEdges, cutEdges;
+};
+
+struct StepReport {
+  std::uint64_t activeVertices, edgesRelaxed, messages, bytes;
+  std::uint64_t changed; // the vertices active in the next superstep
+};
+
+// A message between workers: the global number of a vertex and a value for it
+constexpr std::size_t MESSAGE_BYTES = sizeof(std::int32_t) + sizeof(std::int64_t);
+
+
+/* Blocking send of the whole buffer; a closed peer is an error, not a SIGPIPE */
+static void sendAll(int fd, const void *data, std::size_t bytes) {
+  const char *at = static_cast<const char *>(data);
+  while (bytes > 0) {
+    const ssize_t count = ::send(fd, at, bytes, MSG_NOSIGNAL);
+    if (count < 0 && errno == EINTR)
+      continue;
+    if (count < 0)
+      throw std::runtime_error(std::string("Could not send to a shard worker: ") + std::strerror(errno));
+    at += count;
+    bytes -= count;
+  }
+}
+
+
+/* Blocking receive of the whole buffer; false when the peer closed the socket before the first byte */
+static bool receiveAll(int fd, void *data, std::size_t bytes) {
+  char *at = static_cast<char *>(data);
+  const std::size_t total = bytes;
+  while (bytes > 0) {
+    const ssize_t count = ::recv(fd, at, bytes, 0);
+    if (count < 0 && errno == EINTR)
+      continue;
+    if (count == 0 && bytes == total)
+      return false;
+    if (count <= 0)
+      throw std::runtime_error("The connection to a shard worker broke");
+    at += count;
+    bytes -= count;
+  }
+  return true;
+}
+
+
+template <typename T>
+static void sendPod(int fd, const T &value) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  sendAll(fd, &value, sizeof(T));
+}
+
+template <typename T>
+static T receivePod(int fd) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  T value;
+  if (!receiveAll(fd, &value, sizeof(T)))
+    throw std::runtime_error("A shard worker closed the connection");
+  return value;
+}
+
+template <typename T>
+static void sendVector(int fd, const std::vector<T> &values) {
+  sendPod<std::uint64_t>(fd, values.size());
+  sendAll(fd, values.data(), values.size() * sizeof(T));
+}
+
+template <typename T>
+static std::vector<T> receiveVector(int fd) {
+  std::vector<T> values(receivePod<std::uint64_t>(fd));
+  if (!values.empty() && !receiveAll(fd, values.data(), values.size() * sizeof(T)))
+    throw std::runtime_error("A shard worker closed the connection");
+  return values;
+}
+
+
+// The state of one worker: the values of its vertices, the active ones and the batches for the peers
+class ShardWorker {
+public:
+  ShardWorker(Shard loaded, const std::vector<int> &peerFds) : shard(std::move(loaded)), peers(peerFds) {
+    if (peers.size() != (std::size_t)shard.nrOfShards)
+      throw std::runtime_error("Expected the sockets of " + std::to_string(shard.nrOfShards) + " shards");
+    for (int s = 0; s < shard.nrOfShards; ++s) {
+      if (s != shard.shard && ::fcntl(peers[s], F_SETFL, ::fcntl(peers[s], F_GETFL) | O_NONBLOCK) != 0)
+        throw std::runtime_error("Bad socket for shard " + std::to_string(s));
+    }
+    local.assign(shard.nrOfVertices, -1);
+    for (std::size_t v = 0; v < shard.vertices.size(); ++v)
+      local[shard.vertices[v]] = v;
+  }
+
+  const Shard &getShard() const { return shard; }
+  const std::vector<std::int64_t> &getValues() const { return value; }
+
+  // Resets the values; returns whether the source is one of the local vertices
+  bool start(BspAlgorithm startAlgorithm, std::string_view source) {
+    algorithm = startAlgorithm;
+    const std::size_t n = shard.vertices.size();
+    value.assign(n, PartitionedResult::UNREACHED);
+    inNext.assign(n, 0);
+    active.clear();
+    next.clear();
+    sentBound.assign(shard.nrOfVertices, PartitionedResult::UNREACHED);
+    queued.assign(shard.nrOfVertices, 0);
+    outbox.assign(shard.nrOfShards, {});
+    if (algorithm == BspAlgorithm::Components) {
+      for (std::size_t v = 0; v < n; ++v) {
+        value[v] = shard.vertices[v];
+        active.push_back(v);
+      }
+      return false;
+    }
+    // the local ids are sorted, like the global numbers
+    int low = 0, high = n;
+    while (low < high) {
+      const int middle = low + (high - low) / 2;
+      if (shard.getId(middle) < source)
+        low = middle + 1;
+      else
+        high = middle;
+    }
+    if (low == (int)n || shard.getId(low) != source)
+      return false;
+    value[low] = 0;
+    active.push_back(low);
+    return true;
+  }
+
+  StepReport step() {
+    StepReport report{};
+    report.activeVertices = active.size();
+    for (const int v : active) {
+      const std::int64_t d = value[v];
+      const std::uint64_t outBegin = shard.outOffsets[v], outEnd = shard.outOffsets[v + 1];
+      switch (algorithm) {
+      case BspAlgorithm::Bfs:
+        for (std::uint64_t e = outBegin; e < outEnd; ++e)
+          relax(shard.outTargets[e], d + 1);
+        break;
+      case BspAlgorithm::ShortestPaths:
+        for (std::uint64_t e = outBegin; e < outEnd; ++e)
+          relax(shard.outTargets[e], d + shard.outWeights[e]);
+        break;
+      case BspAlgorithm::Components:
+        for (std::uint64_t e = outBegin; e < outEnd; ++e)
+          relax(shard.outTargets[e], d);
+        for (std::uint64_t e = shard.inOffsets[v]; e < shard.inOffsets[v + 1]; ++e)
+          relax(shard.inSources[e], d);
+        report.edgesRelaxed += shard.inOffsets[v + 1] - shard.inOffsets[v];
+        break;
+      }
+      report.edgesRelaxed += outEnd - outBegin;
+    }
+    exchange(report);
+    report.changed = next.size();
+    active.swap(next);
+    next.clear();
+    for (const int v : active)
+      inNext[v] = 0;
+    return report;
+  }
+
+private:
+  // The batch to and from one peer: an uint64 byte count, then the messages
+  struct Batch {
+    std::vector<char> out, in;
+    std::size_t sent = 0, received = 0;
+    std::uint64_t inBytes = 0;
+    char header[sizeof(std::uint64_t)];
+    bool headerDone = false;
+    bool receiving() const { return !headerDone || received < inBytes; }
+  };
+
+  Shard shard;
+  std::vector<int> peers;
+  std::vector<int> local; // global number -> local vertex, -1 for the vertices of the other shards
+  BspAlgorithm algorithm = BspAlgorithm::Bfs;
+  std::vector<std::int64_t> value;
+  std::vector<int> active, next;
+  std::vector<std::uint8_t> inNext;
+  // The smallest value sent so far to every vertex of the other shards: its owner already has it, so
+  // the larger ones are not sent. Together with queued it also combines the messages of a superstep.
+  std::vector<std::int64_t> sentBound;
+  std::vector<std::uint8_t> queued;
+  std::vector<std::vector<int>> outbox; // per shard, the vertices to send a value to
+
+  void update(int v, std::int64_t candidate) {
+    if (candidate < value[v]) {
+      value[v] = candidate;
+      if (!inNext[v]) {
+        inNext[v] = 1;
+        next.push_back(v);
+      }
+    }
+  }
+
+  void relax(int target, std::int64_t candidate) {
+    if (local[target] != -1) {
+      update(local[target], candidate);
+    } else if (candidate < sentBound[target]) {
+      sentBound[target] = candidate;
+      if (!queued[target]) {
+        queued[target] = 1;
+        outbox[shard.owner[target]].push_back(target);
+      }
+    }
+  }
+
+  /* Sends a batch to every peer and receives one from every peer at the same time, so that no two workers
+     wait on each other with full socket buffers; then applies the received messages */
+  void exchange(StepReport &report) {
+    std::vector<Batch> batches(shard.nrOfShards);
+    for (int s = 0; s < shard.nrOfShards; ++s) {
+      if (s == shard.shard)
+        continue;
+      std::vector<char> &out = batches[s].out;
+      const std::uint64_t bytes = outbox[s].size() * MESSAGE_BYTES;
+      out.resize(sizeof(bytes) + bytes);
+      std::memcpy(out.data(), &bytes, sizeof(bytes));
+      char *at = out.data() + sizeof(bytes);
+      for (const std::int32_t target : outbox[s]) {
+        std::memcpy(at, &target, sizeof(target));
+        std::memcpy(at + sizeof(target), &sentBound[target], sizeof(std::int64_t));
+        at += MESSAGE_BYTES;
+        queued[target] = 0;
+      }
+      report.messages += outbox[s].size();
+      report.bytes += out.size();
+      outbox[s].clear();
+    }
+
+    std::vector<pollfd> polled;
+    std::vector<int> shards;
+    for (;;) {
+      polled.clear();
+      shards.clear();
+      for (int s = 0; s < shard.nrOfShards; ++s) {
+        const Batch &batch = batches[s];
+        if (s == shard.shard || (batch.sent == batch.out.size() && !batch.receiving()))
+          continue;
+        polled.push_back({peers[s], (short)((batch.sent < batch.out.size() ? POLLOUT : 0) |
+                                            (batch.receiving() ? POLLIN : 0)), 0});
+        shards.push_back(s);
+      }
+      if (polled.empty())
+        break;
+      if (::poll(polled.data(), polled.size(), -1) < 0) {
+        if (errno == EINTR)
+          continue;
+        throw std::runtime_error(std::string("Could not wait for the other shards: ") + std::strerror(errno));
+      }
+      for (std::size_t i = 0; i < polled.size(); ++i) {
+        Batch &batch = batches[shards[i]];
+        if ((polled[i].revents & POLLOUT) && batch.sent < batch.out.size()) {
+          const ssize_t count =
+              ::send(polled[i].fd, batch.out.data() + batch.sent, batch.out.size() - batch.sent, MSG_NOSIGNAL);
+          if (count < 0 && errno != EAGAIN && errno != EINTR)
+            throw std::runtime_error("Could not send to shard " + std::to_string(shards[i]));
+          batch.sent += std::max<ssize_t>(count, 0);
+        }
+        if ((polled[i].revents & (POLLIN | POLLHUP | POLLERR)) && batch.receiving()) {
+          char *into = batch.headerDone ? batch.in.data() + batch.received : batch.header + batch.received;
+          const std::size_t wanted =
+              batch.headerDone ? batch.inBytes - batch.received : sizeof(batch.header) - batch.received;
+          const ssize_t count = ::recv(polled[i].fd, into, wanted, 0);
+          if (count == 0)
+            throw std::runtime_error("Shard " + std::to_string(shards[i]) + " closed the connection");
+          if (count < 0 && errno != EAGAIN && errno != EINTR)
+            throw std::runtime_error("Could not receive from shard " + std::to_string(shards[i]));
+          batch.received += std::max<ssize_t>(count, 0);
+          if (!batch.headerDone && batch.received == sizeof(batch.header)) {
+            std::memcpy(&batch.inBytes, batch.header, sizeof(batch.inBytes));
+            if (batch.inBytes % MESSAGE_BYTES != 0)
+              throw std::runtime_error("Bad batch from shard " + std::to_string(shards[i]));
+            batch.headerDone = true;
+            batch.received = 0;
+            batch.in.resize(batch.inBytes);
+          }
+        }
+      }
+    }
+
+    for (const Batch &batch : batches) {
+      for (std::size_t at = 0; at < batch.in.size(); at += MESSAGE_BYTES) {
+        std::int32_t target;
+        std::int64_t candidate;
+        std::memcpy(&target, batch.in.data() + at, sizeof(target));
+        std::memcpy(&candidate, batch.in.data() + at + sizeof(target), sizeof(candidate));
+        if (target < 0 || (std::uint64_t)target >= shard.nrOfVertices || local[target] == -1)
+          throw std::runtime_error("Message for a vertex of another shard");
+        update(local[target], candidate);
+      }
+    }
+  }
+};
+
+
+int runShardWorker(const std::string &shardPath, int controlFd, const std::vector<int> &peerFds) {
+  int shardNumber = -1;
+  try {
+    ShardWorker worker(loadShard(shardPath), peerFds);
+    const Shard &shard = worker.getShard();
+    shardNumber = shard.shard;
+    sendPod(controlFd, Hello{(std::uint32_t)shard.shard, (std::uint32_t)shard.nrOfShards, shard.nrOfVertices,
+                             shard.nrOfEdges, shard.cutEdges});
+    CommandHeader header;
+    while (receiveAll(controlFd, &header, sizeof(header))) {
+      std::string payload(header.payloadBytes, '\0');
+      if (!payload.empty() && !receiveAll(controlFd, payload.data(), payload.size()))
+        throw std::runtime_error("The coordinator closed the connection");
+      switch (header.command) {
+      case Command::Start:
+        sendPod<std::uint64_t>(controlFd, worker.start((BspAlgorithm)header.argument, payload));
+        break;
+      case Command::Step:
+        sendPod(controlFd, worker.step());
+        break;
+      case Command::Collect:
+        sendVector(controlFd, shard.vertices);
+        sendVector(controlFd, worker.getValues());
+        if (header.argument) {
+          sendVector(controlFd, shard.idOffsets);
+          sendVector(controlFd, shard.idBytes);
+        }
+        break;
+      default:
+        throw std::runtime_error("Unknown command");
+      }
+    }
+    return 0;
+  } catch (const std::exception &e) {
+    std::cerr << "Shard worker " << shardNumber << " (" << shardPath << "): " << e.what() << '\n';
+    return 1;
+  }
+}
+
+
+// The worker processes of one run, connected to each other and to the coordinator. The destructor closes the
+// control sockets, which makes the workers exit, and waits for them.
+class WorkerProcesses {
+public:
+  WorkerProcesses(const std::string &prefix, int nrOfShards) {
+    // every socket is created close-on-exec; a worker clears the flag on its own ones before the exec
+    std::vector<std::vector<int>> peerFds(nrOfShards, std::vector<int>(nrOfShards, -1));
+    std::vector<int> workerControls;
+    auto createPair = [&](int &a, int &b) {
+      int pair[2];
+      if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) != 0) {
+        closeAll(peerFds, workerControls);
+        stop();
+        throw std::runtime_error(std::string("Could not create the sockets of the shards: ") + std::strerror(errno));
+      }
+      a = pair[0];
+      b = pair[1];
+    };
+    for (int a = 0; a < nrOfShards; ++a)
+      for (int b = a + 1; b < nrOfShards; ++b)
+        createPair(peerFds[a][b], peerFds[b][a]);
+    controls.assign(nrOfShards, -1);
+    workerControls.assign(nrOfShards, -1);
+    for (int s = 0; s < nrOfShards; ++s)
+      createPair(controls[s], workerControls[s]);
+
+    for (int s = 0; s < nrOfShards; ++s) {
+      // everything the child needs is prepared before the fork: it only calls fcntl and exec
+      std::string peerList;
+      for (int t = 0; t < nrOfShards; ++t)
+        peerList += (t == 0 ? "" : ",") + std::to_string(peerFds[s][t]);
+      std::vector<std::string> arguments{"graph_app", "--shard-worker", getShardPath(prefix, s),
+                                         std::to_string(workerControls[s]), peerList};
+      std::vector<char *> argv;
+      for (auto &argument : arguments)
+        argv.push_back(argument.data());
+      argv.push_back(nullptr);
+      std::vector<int> inherited(peerFds[s]);
+      inherited.push_back(workerControls[s]);
+
+      const pid_t pid = ::fork();
+      if (pid == 0) {
+        for (const int fd : inherited)
+          if (fd != -1)
+            ::fcntl(fd, F_SETFD, 0);
+        ::execv("/proc/self/exe", argv.data());
+        ::_exit(127);
+      }
+      if (pid < 0) {
+        closeAll(peerFds, workerControls); // the workers already started see their control socket close and exit
+        stop();
+        throw std::runtime_error(std::string("Could not start a shard worker: ") + std::strerror(errno));
+      }
+      pids.push_back(pid);
+    }
+    closeAll(peerFds, workerControls);
+  }
+
+  WorkerProcesses(const WorkerProcesses &) = delete;
+  WorkerProcesses &operator=(const WorkerProcesses &) = delete;
+
+  ~WorkerProcesses() { stop(); }
+
+  int getControl(int shard) const { return controls[shard]; }
+
+private:
+  std::vector<pid_t> pids;
+  std::vector<int> controls;
+
+  // Closes the control sockets, which makes the workers exit, and waits for them
+  void stop() {
+    for (const int fd : controls)
+      if (fd != -1)
+        ::close(fd);
+    controls.clear();
+    for (const pid_t pid : pids)
+      while (::waitpid(pid, nullptr, 0) < 0 && errno == EINTR) {
+      }
+    pids.clear();
+  }
+
+  static void closeAll(const std::vector<std::vector<int>> &peerFds, const std::vector<int> &workerControls) {
+    for (const auto &row : peerFds)
+      for (const int fd : row)
+        if (fd != -1)
+          ::close(fd);
+    for (const int fd : workerControls)
+      if (fd != -1)
+        ::close(fd);
+  }
+};
+
+
+PartitionedResult runPartitioned(const std::string &prefix, BspAlgorithm algorithm, const std::string &source,
+                                 bool withIds) {
+  const int nrOfShards = getNrOfShards(prefix);
+  WorkerProcesses workers(prefix, nrOfShards);
+  PartitionedResult result;
+  result.nrOfShards = nrOfShards;
+  for (int s = 0; s < nrOfShards; ++s) {
+    Hello hello;
+    if (!receiveAll(workers.getControl(s), &hello, sizeof(hello)))
+      throw std::runtime_error("Shard worker " + std::to_string(s) + " did not start");
+    if (s == 0) {
+      result.value.assign(hello.nrOfVertices, PartitionedResult::UNREACHED);
+      result.nrOfEdges = hello.nrOfEdges;
+      result.cutEdges = hello.cutEdges;
+    }
+    if (hello.shard != (std::uint32_t)s || hello.nrOfShards != (std::uint32_t)nrOfShards ||
+        hello.nrOfVertices != result.value.size() || hello.nrOfEdges != result.nrOfEdges)
+      throw std::runtime_error("The shard files at '" + prefix + "' are not of the same partition");
+  }
+
+  auto sendCommand = [&](int s, Command command, std::int32_t argument, const std::string &payload = "") {
+    sendPod(workers.getControl(s), CommandHeader{command, argument, payload.size()});
+    sendAll(workers.getControl(s), payload.data(), payload.size());
+  };
+  std::uint64_t owners = 0;
+  for (int s = 0; s < nrOfShards; ++s)
+    sendCommand(s, Command::Start, (std::int32_t)algorithm, source);
+  for (int s = 0; s < nrOfShards; ++s)
+    owners += receivePod<std::uint64_t>(workers.getControl(s));
+  if (algorithm != BspAlgorithm::Components && owners == 0)
+    throw std::runtime_error("Vertex " + source + " is not in the graph");
+
+  for (;;) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int s = 0; s < nrOfShards; ++s)
+      sendCommand(s, Command::Step, 0);
+    SuperstepStats stats;
+    std::uint64_t changed = 0;
+    for (int s = 0; s < nrOfShards; ++s) {
+      const auto report = receivePod<StepReport>(workers.getControl(s));
+      stats.activeVertices += report.activeVertices;
+      stats.edgesRelaxed += report.edgesRelaxed;
+      stats.messages += report.messages;
+      stats.bytes += report.bytes;
+      changed += report.changed;
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.supersteps.push_back(stats);
+    if (changed == 0)
+      break;
+    // without a negative cycle, no distance changes after n - 1 supersteps
+    if (result.supersteps.size() > result.value.size())
+      throw std::runtime_error("The graph has a negative cycle reachable from " + source);
+  }
+
+  if (withIds)
+    result.ids.resize(result.value.size());
+  for (int s = 0; s < nrOfShards; ++s) {
+    const int control = workers.getControl(s);
+    sendCommand(s, Command::Collect, withIds);
+    const auto vertices = receiveVector<std::int32_t>(control);
+    const auto values = receiveVector<std::int64_t>(control);
+    if (values.size() != vertices.size())
+      throw std::runtime_error("Bad result from shard worker " + std::to_string(s));
+    for (std::size_t v = 0; v < vertices.size(); ++v)
+      result.value.at(vertices[v]) = values[v];
+    if (withIds) {
+      const auto idOffsets = receiveVector<std::uint64_t>(control);
+      const auto idBytes = receiveVector<char>(control);
+      for (std::size_t v = 0; v < vertices.size(); ++v)
+        result.ids[vertices[v]].assign(idBytes.data() + idOffsets[v], idOffsets[v + 1] - idOffsets[v]);
+    }
+  }
+  return result;
+}
+
+} // namespace distributed
+} // namespace graph
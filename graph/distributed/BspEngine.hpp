@@ -0,0 +1,51 @@
+#pragma once
+#include "Partitioner.hpp"
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace graph {
+namespace distributed {
+
+// Bulk synchronous execution over the shard files of a partition: the coordinator starts one worker process
+// per shard (this program again, with --shard-worker) and drives them in supersteps. In a superstep every
+// worker relaxes the edges of its active vertices, sends the values for the vertices of other shards to their
+// owners in one batch per peer (the smallest value per vertex), and applies the batches it receives; the run
+// ends when no vertex changed. The workers are connected to each other by Unix socket pairs, and to the
+// coordinator by one more, which only carries the commands, the superstep reports and the results.
+//
+// The three algorithms propagate the smallest value along the edges:
+//   Bfs            hops from the source along the out edges
+//   Components     the smallest global number of the weakly connected component, along the out and in edges
+//   ShortestPaths  distances from the source along the out edges (Bellman-Ford, a negative cycle is an error)
+enum class BspAlgorithm { Bfs, Components, ShortestPaths };
+
+struct SuperstepStats {
+  std::uint64_t activeVertices = 0; // whose edges the superstep relaxed
+  std::uint64_t edgesRelaxed = 0;
+  std::uint64_t messages = 0; // (vertex, value) pairs sent between the workers
+  std::uint64_t bytes = 0;    // sent between the workers, the batch headers included
+  double seconds = 0;
+};
+
+struct PartitionedResult {
+  static constexpr std::int64_t UNREACHED = std::numeric_limits<std::int64_t>::max();
+  int nrOfShards = 0;
+  std::uint64_t nrOfEdges = 0, cutEdges = 0;
+  std::vector<std::int64_t> value; // by global number: the hops, the component label or the distance
+  std::vector<std::string> ids;    // by global number, when they were asked for
+  std::vector<SuperstepStats> supersteps;
+};
+
+// Runs the algorithm on the shards written at the prefix; source is the id of the source vertex (not used by
+// Components). The worker processes exit when it returns or throws.
+PartitionedResult runPartitioned(const std::string &prefix, BspAlgorithm algorithm, const std::string &source,
+                                 bool withIds = false);
+
+// The main function of a worker process: serves the coordinator on controlFd until it closes it.
+// peerFds[s] is the socket to the worker of shard s (-1 for its own shard). Returns the exit status.
+int runShardWorker(const std::string &shardPath, int controlFd, const std::vector<int> &peerFds);
+
+} // namespace distributed
+} // namespace graph
@@ -0,0 +1,257 @@
+#include "Partitioner.hpp"
+#include "../utils/BinaryIO.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+
+namespace graph {
+namespace distributed {
+
+// A shard file, in the native byte order: the header, then the vectors of Shard written with utils::writeVector
+constexpr std::uint64_t SHARD_FILE_MAGIC = 0x4448535048415247; // "GRAPHSHD"
+constexpr std::uint32_t SHARD_FILE_VERSION = 1;
+
+struct ShardFileHeader {
+  std::uint64_t magic;
+  std::uint32_t version;
+  std::uint32_t shard;
+  std::uint32_t nrOfShards;
+  std::uint32_t reserved;
+  std::uint64_t nrOfVertices;
+  std::uint64_t nrOfEdges;
+  std::uint64_t cutEdges;
+};
+
+constexpr std::uint16_t UNASSIGNED = MAX_SHARDS;
+
+
+/* The vertices of the compact graph by id: order[global number] = compact vertex */
+static std::vector<int> sortById(const compact::CompactGraph &g) {
+  std::vector<int> order(g.getNrOfVertices());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](int a, int b) { return g.getId(a) < g.getId(b); });
+  return order;
+}
+
+
+/* FNV-1a, so that a vertex lands in the same shard whatever else is in the graph */
+static std::uint64_t hashId(const idT &id) {
+  std::uint64_t hash = 0xcbf29ce484222325ULL;
+  for (const unsigned char c : id)
+    hash = (hash ^ c) * 0x100000001b3ULL;
+  return hash;
+}
+
+
+Partition partitionGraph(const compact::CompactGraph &g, int nrOfShards, PartitionStrategy strategy) {
+  if (nrOfShards < 1 || nrOfShards > MAX_SHARDS)
+    throw std::runtime_error("The number of shards must be between 1 and " + std::to_string(MAX_SHARDS));
+  const int n = g.getNrOfVertices();
+  const std::vector<int> order = sortById(g);
+  std::vector<int> global(n);
+  for (int i = 0; i < n; ++i)
+    global[order[i]] = i;
+
+  Partition partition;
+  partition.nrOfShards = nrOfShards;
+  partition.owner.assign(n, UNASSIGNED);
+  partition.shardVertices.assign(nrOfShards, 0);
+  partition.shardEdges.assign(nrOfShards, 0);
+  if (strategy == PartitionStrategy::Hash) {
+    for (int i = 0; i < n; ++i)
+      partition.owner[i] = hashId(g.getId(order[i])) % nrOfShards;
+  } else {
+    // score of a shard: its neighbors of the vertex, less the fuller it is; the full shards are skipped
+    const double capacity = std::max(1.0, std::ceil((double)n / nrOfShards * (1 + GREEDY_SLACK)));
+    std::vector<int> neighbors(nrOfShards);
+    for (int i = 0; i < n; ++i) {
+      std::fill(neighbors.begin(), neighbors.end(), 0);
+      auto count = [&](std::span<const int> adjacent) {
+        for (const int u : adjacent)
+          if (partition.owner[global[u]] != UNASSIGNED)
+            ++neighbors[partition.owner[global[u]]];
+      };
+      count(g.getOutNeighbors(order[i]));
+      count(g.getInNeighbors(order[i]));
+      int best = -1;
+      double bestScore = 0;
+      for (int s = 0; s < nrOfShards; ++s) {
+        const std::size_t size = partition.shardVertices[s];
+        if (size >= capacity)
+          continue;
+        const double score = neighbors[s] * (1 - size / capacity);
+        if (best == -1 || score > bestScore || (score == bestScore && size < partition.shardVertices[best])) {
+          best = s;
+          bestScore = score;
+        }
+      }
+      partition.owner[i] = best;
+      ++partition.shardVertices[best];
+    }
+    std::fill(partition.shardVertices.begin(), partition.shardVertices.end(), 0);
+  }
+
+  for (int i = 0; i < n; ++i) {
+    const int shard = partition.owner[i];
+    ++partition.shardVertices[shard];
+    for (const int u : g.getOutNeighbors(order[i])) {
+      ++partition.shardEdges[shard];
+      if (partition.owner[global[u]] != shard)
+        ++partition.cutEdges;
+    }
+  }
+  partition.nrOfEdges = g.getNrOfEdges();
+  return partition;
+}
+
+
+std::string getShardPath(const std::string &prefix, int shard) {
+  return prefix + "." + std::to_string(shard);
+}
+
+
+std::vector<std::string> saveShards(const compact::CompactGraph &g, const Partition &partition,
+                                    const std::string &prefix) {
+  const int n = g.getNrOfVertices();
+  if (partition.owner.size() != (std::size_t)n)
+    throw std::runtime_error("The partition is not of this graph");
+  const std::vector<int> order = sortById(g);
+  std::vector<int> global(n);
+  for (int i = 0; i < n; ++i)
+    global[order[i]] = i;
+
+  std::vector<std::string> paths;
+  for (int s = 0; s < partition.nrOfShards; ++s) {
+    Shard shard;
+    shard.outOffsets.push_back(0);
+    shard.inOffsets.push_back(0);
+    shard.idOffsets.push_back(0);
+    for (int i = 0; i < n; ++i) {
+      if (partition.owner[i] != s)
+        continue;
+      const int v = order[i];
+      shard.vertices.push_back(i);
+      for (const int u : g.getOutNeighbors(v))
+        shard.outTargets.push_back(global[u]);
+      const auto outWeights = g.getOutWeights(v);
+      shard.outWeights.insert(shard.outWeights.end(), outWeights.begin(), outWeights.end());
+      shard.outOffsets.push_back(shard.outTargets.size());
+      for (const int u : g.getInNeighbors(v))
+        shard.inSources.push_back(global[u]);
+      const auto inWeights = g.getInWeights(v);
+      shard.inWeights.insert(shard.inWeights.end(), inWeights.begin(), inWeights.end());
+      shard.inOffsets.push_back(shard.inSources.size());
+      const idT &id = g.getId(v);
+      shard.idBytes.insert(shard.idBytes.end(), id.begin(), id.end());
+      shard.idOffsets.push_back(shard.idBytes.size());
+    }
+
+    const std::string path = getShardPath(prefix, s), temporary = path + ".tmp";
+    std::ofstream fout(temporary, std::ios::binary);
+    if (!fout.is_open())
+      throw std::runtime_error("Could not open file '" + temporary + "' for writing");
+    utils::writePod(fout, ShardFileHeader{SHARD_FILE_MAGIC, SHARD_FILE_VERSION, (std::uint32_t)s,
+                                          (std::uint32_t)partition.nrOfShards, 0, (std::uint64_t)n,
+                                          partition.nrOfEdges, partition.cutEdges});
+    utils::writeVector(fout, partition.owner);
+    utils::writeVector(fout, shard.vertices);
+    utils::writeVector(fout, shard.outOffsets);
+    utils::writeVector(fout, shard.outTargets);
+    utils::writeVector(fout, shard.outWeights);
+    utils::writeVector(fout, shard.inOffsets);
+    utils::writeVector(fout, shard.inSources);
+    utils::writeVector(fout, shard.inWeights);
+    utils::writeVector(fout, shard.idOffsets);
+    utils::writeVector(fout, shard.idBytes);
+    fout.close();
+    if (!fout || std::rename(temporary.c_str(), path.c_str()) != 0) {
+      std::remove(temporary.c_str());
+      throw std::runtime_error("Could not write the shard to '" + path + "'");
+    }
+    paths.push_back(path);
+  }
+  return paths;
+}
+
+
+static ShardFileHeader readShardHeader(std::istream &in, const std::string &path) {
+  ShardFileHeader header;
+  try {
+    header = utils::readPod<ShardFileHeader>(in);
+  } catch (const std::runtime_error &) {
+    throw std::runtime_error("'" + path + "' is not a shard file");
+  }
+  if (header.magic != SHARD_FILE_MAGIC)
+    throw std::runtime_error("'" + path + "' is not a shard file");
+  if (header.version != SHARD_FILE_VERSION)
+    throw std::runtime_error("'" + path + "' is a shard file of another format version");
+  if (header.nrOfShards < 1 || header.nrOfShards > MAX_SHARDS || header.shard >= header.nrOfShards ||
+      header.nrOfVertices > (std::uint64_t)INT32_MAX)
+    throw std::runtime_error("'" + path + "' is damaged");
+  return header;
+}
+
+
+/* Reads the file and checks that every number in it points inside the shard or the graph */
+Shard loadShard(const std::string &path) {
+  std::ifstream fin(path, std::ios::binary);
+  if (!fin.is_open())
+    throw std::runtime_error("Could not open file '" + path + "' for reading");
+  const ShardFileHeader header = readShardHeader(fin, path);
+  Shard shard;
+  shard.shard = header.shard;
+  shard.nrOfShards = header.nrOfShards;
+  shard.nrOfVertices = header.nrOfVertices;
+  shard.nrOfEdges = header.nrOfEdges;
+  shard.cutEdges = header.cutEdges;
+  try {
+    shard.owner = utils::readVector<std::uint16_t>(fin);
+    shard.vertices = utils::readVector<std::int32_t>(fin);
+    shard.outOffsets = utils::readVector<std::uint64_t>(fin);
+    shard.outTargets = utils::readVector<std::int32_t>(fin);
+    shard.outWeights = utils::readVector<std::int32_t>(fin);
+    shard.inOffsets = utils::readVector<std::uint64_t>(fin);
+    shard.inSources = utils::readVector<std::int32_t>(fin);
+    shard.inWeights = utils::readVector<std::int32_t>(fin);
+    shard.idOffsets = utils::readVector<std::uint64_t>(fin);
+    shard.idBytes = utils::readVector<char>(fin);
+  } catch (const std::runtime_error &) {
+    throw std::runtime_error("'" + path + "' is damaged");
+  }
+
+  const std::size_t n = header.nrOfVertices, local = shard.vertices.size();
+  auto inGraph = [&](const std::vector<std::int32_t> &values) {
+    return std::all_of(values.begin(), values.end(), [&](std::int32_t v) { return v >= 0 && (std::size_t)v < n; });
+  };
+  const bool valid =
+      shard.owner.size() == n &&
+      std::all_of(shard.owner.begin(), shard.owner.end(), [&](std::uint16_t s) { return s < header.nrOfShards; }) &&
+      inGraph(shard.vertices) &&
+      std::all_of(shard.vertices.begin(), shard.vertices.end(), [&](int v) { return shard.owner[v] == shard.shard; }) &&
+      shard.outOffsets.size() == local + 1 && shard.outOffsets.back() == shard.outTargets.size() &&
+      shard.outWeights.size() == shard.outTargets.size() && inGraph(shard.outTargets) &&
+      shard.inOffsets.size() == local + 1 && shard.inOffsets.back() == shard.inSources.size() &&
+      shard.inWeights.size() == shard.inSources.size() && inGraph(shard.inSources) &&
+      shard.idOffsets.size() == local + 1 && shard.idOffsets.back() == shard.idBytes.size() &&
+      std::is_sorted(shard.outOffsets.begin(), shard.outOffsets.end()) &&
+      std::is_sorted(shard.inOffsets.begin(), shard.inOffsets.end()) &&
+      std::is_sorted(shard.idOffsets.begin(), shard.idOffsets.end());
+  if (!valid)
+    throw std::runtime_error("'" + path + "' is damaged");
+  return shard;
+}
+
+
+int getNrOfShards(const std::string &prefix) {
+  const std::string path = getShardPath(prefix, 0);
+  std::ifstream fin(path, std::ios::binary);
+  if (!fin.is_open())
+    throw std::runtime_error("Could not open file '" + path + "' for reading");
+  return readShardHeader(fin, path).nrOfShards;
+}
+
+} // namespace distributed
+} // namespace graph
@@ -0,0 +1,66 @@
+#pragma once
+#include "../compact/CompactGraph.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace graph {
+namespace distributed {
+
+// Splits a directed graph into shards for the partitioned execution (see BspEngine): every shard owns a set of
+// vertices with their out and in edges, and the edges between two shards (the edge cut) are what the workers
+// exchange messages over.
+// Across the shards the vertices are numbered 0..n-1 in the order of their ids, like in a mapped graph file.
+
+constexpr int MAX_SHARDS = 64;
+
+enum class PartitionStrategy {
+  Hash,  // by a hash of the id: no state, the cut is (k - 1) / k of the edges
+  Greedy // linear deterministic greedy: streams the vertices, each to the shard holding most of its neighbors
+};
+
+struct Partition {
+  int nrOfShards = 0;
+  std::vector<std::uint16_t> owner; // the shard of every vertex, by global number
+  std::vector<std::size_t> shardVertices, shardEdges; // per shard, its vertices and their out edges
+  std::size_t nrOfEdges = 0;
+  std::size_t cutEdges = 0; // the edges whose ends are in different shards
+};
+
+// The greedy strategy keeps every shard under (1 + GREEDY_SLACK) times its share of the vertices
+constexpr double GREEDY_SLACK = 0.05;
+
+Partition partitionGraph(const compact::CompactGraph &g, int nrOfShards, PartitionStrategy strategy);
+
+// Writes shard i to "<prefix>.<i>" (next to it first, then renamed); returns the paths
+std::vector<std::string> saveShards(const compact::CompactGraph &g, const Partition &partition,
+                                    const std::string &prefix);
+
+std::string getShardPath(const std::string &prefix, int shard);
+
+// What a worker loads: the part of the graph one shard owns, and where every other vertex is.
+// The adjacency is in CSR form over the local vertices, the neighbors are global numbers.
+struct Shard {
+  int shard = 0;
+  int nrOfShards = 0;
+  std::uint64_t nrOfVertices = 0, nrOfEdges = 0, cutEdges = 0; // of the whole graph
+  std::vector<std::uint16_t> owner;
+  std::vector<std::int32_t> vertices; // the global numbers of the local vertices, ascending
+  std::vector<std::uint64_t> outOffsets, inOffsets;
+  std::vector<std::int32_t> outTargets, outWeights, inSources, inWeights;
+  std::vector<std::uint64_t> idOffsets;
+  std::vector<char> idBytes;
+
+  std::string_view getId(int local) const {
+    return std::string_view(idBytes.data() + idOffsets[local], idOffsets[local + 1] - idOffsets[local]);
+  }
+};
+
+Shard loadShard(const std::string &path);
+
+// The number of shards the files at the prefix were written for, from the header of the first one
+int getNrOfShards(const std::string &prefix);
+
+} // namespace distributed
+} // namespace graph
@@ -0,0 +1,387 @@
+#include "Generators.hpp"
+#include "../vertices/ActivityVertex.hpp"
+#include "../vertices/StringVertex.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+namespace graph {
+namespace generators {
+
+namespace {
+
+// Independent random streams, so that e.g. the weights do not correlate with the endpoints
+enum Stream : std::uint64_t { Endpoints = 1, Weights, Permutation, Durations };
+
+std::uint64_t mix(std::uint64_t x) {
+  // splitmix64 finalizer
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+std::uint64_t hash(std::uint64_t seed, Stream stream, std::uint64_t index) {
+  return mix(seed ^ mix(stream * 0x632be59bd9b4e019ULL + mix(index)));
+}
+
+// Uniform in [0, bound) (Lemire's multiply shift)
+std::uint64_t uniform(std::uint64_t h, std::uint64_t bound) {
+  return (std::uint64_t)(((unsigned __int128)h * bound) >> 64);
+}
+
+// Uniform in [0, 1)
+double unit(std::uint64_t h) {
+  return (h >> 11) * 0x1.0p-53;
+}
+
+int edgeWeight(const GeneratorOptions &options, std::uint64_t edge) {
+  if (options.maxWeight <= options.minWeight)
+    return options.minWeight;
+  return options.minWeight + (int)uniform(hash(options.seed, Weights, edge), (std::uint64_t)options.maxWeight - options.minWeight + 1);
+}
+
+void checkOptions(const GeneratorOptions &options) {
+  if (options.minWeight > options.maxWeight)
+    throw std::runtime_error("The minimum weight is larger than the maximum weight");
+}
+
+// Fills edges[0..m) with make(e) on all the threads
+template <typename Make>
+void generateEdges(GeneratedGraph &g, std::size_t m, unsigned nrThreads, Make &&make) {
+  g.edges.resize(m);
+  utils::parallelForRange(m, nrThreads, [&](unsigned, std::size_t begin, std::size_t end) {
+    for (std::size_t e = begin; e < end; ++e)
+      g.edges[e] = make(e);
+  });
+}
+
+} // namespace
+
+
+GeneratedGraph rmat(int scale, int edgeFactor, const GeneratorOptions &options, double a, double b, double c) {
+  checkOptions(options);
+  if (scale < 1 || scale > 30)
+    throw std::runtime_error("The R-MAT scale has to be between 1 and 30");
+  if (edgeFactor < 1)
+    throw std::runtime_error("The edge factor has to be positive");
+  if (a < 0 || b < 0 || c < 0 || a + b + c > 1)
+    throw std::runtime_error("Invalid R-MAT probabilities");
+
+  GeneratedGraph g;
+  g.nrOfVertices = 1 << scale;
+  g.directed = options.directed;
+  const std::uint64_t mask = (std::uint64_t)g.nrOfVertices - 1;
+  // a bijection of [0, 2^scale) (odd multipliers and xor shifts), so the high degree vertices are not 0, 1, 2...
+  const std::uint64_t multiplier1 = hash(options.seed, Permutation, 0) | 1;
+  const std::uint64_t multiplier2 = hash(options.seed, Permutation, 1) | 1;
+  auto permute = [&](std::uint64_t v) {
+    v = (v * multiplier1) & mask;
+    v ^= v >> (scale / 2 + 1);
+    v = (v * multiplier2) & mask;
+    return (int)v;
+  };
+
+  generateEdges(g, (std::size_t)edgeFactor * g.nrOfVertices, options.nrThreads, [&](std::size_t e) {
+    std::uint64_t from = 0, to = 0;
+    for (int level = 0; level < scale; ++level) {
+      const double r = unit(hash(options.seed, Endpoints, (std::uint64_t)e * 32 + level));
+      // quadrants: a = (0, 0), b = (0, 1), c = (1, 0), d = (1, 1)
+      const int fromBit = r >= a + b;
+      const int toBit = (r >= a && r < a + b) || r >= a + b + c;
+      from = (from << 1) | fromBit;
+      to = (to << 1) | toBit;
+    }
+    return GeneratedEdge{permute(from), permute(to), edgeWeight(options, e)};
+  });
+  return g;
+}
+
+
+GeneratedGraph erdosRenyi(int n, std::size_t m, const GeneratorOptions &options) {
+  checkOptions(options);
+  if (n < 1)
+    throw std::runtime_error("The graph needs at least one vertex");
+  GeneratedGraph g;
+  g.nrOfVertices = n;
+  g.directed = options.directed;
+  generateEdges(g, m, options.nrThreads, [&](std::size_t e) {
+    return GeneratedEdge{(int)uniform(hash(options.seed, Endpoints, 2 * e), n),
+                         (int)uniform(hash(options.seed, Endpoints, 2 * e + 1), n), edgeWeight(options, e)};
+  });
+  return g;
+}
+
+
+GeneratedGraph barabasiAlbert(int n, int k, const GeneratorOptions &options) {
+  checkOptions(options);
+  if (n < 2 || k < 1)
+    throw std::runtime_error("Barabasi-Albert needs at least two vertices and one edge per vertex");
+  GeneratedGraph g;
+  g.nrOfVertices = n;
+  g.directed = options.directed;
+  // Edge e belongs to vertex e / k + 1 and its 2e and 2e + 1 ends form the sequence the copies pick from.
+  // The first k edges attach vertex 1 to vertex 0.
+  const std::uint64_t K = k;
+  auto source = [&](std::uint64_t e) { return (int)(e / K + 1); };
+  generateEdges(g, (std::size_t)(n - 1) * k, options.nrThreads, [&](std::size_t e) {
+    std::uint64_t current = e;
+    int target = 0;
+    while (current >= K) {
+      const std::uint64_t end = uniform(hash(options.seed, Endpoints, current), 2 * current);
+      if (end % 2 == 0) {
+        target = source(end / 2);
+        break;
+      }
+      current = end / 2; // the target of an earlier edge: follow its copy
+      target = 0;
+    }
+    return GeneratedEdge{source(e), target, edgeWeight(options, e)};
+  });
+  return g;
+}
+
+
+GeneratedGraph grid(int rows, int cols, const GeneratorOptions &options) {
+  checkOptions(options);
+  if (rows < 1 || cols < 1)
+    throw std::runtime_error("The grid needs at least one row and one column");
+  GeneratedGraph g;
+  g.nrOfVertices = rows * cols;
+  g.directed = options.directed;
+  const std::size_t copies = options.directed ? 2 : 1;
+  const std::size_t perRow = (std::size_t)(cols - 1) + cols; // right and down
+  const std::size_t m = ((std::size_t)rows * (cols - 1) + (std::size_t)(rows - 1) * cols) * copies;
+  g.edges.resize(m);
+  utils::parallelForRange(rows, options.nrThreads, [&](unsigned, std::size_t begin, std::size_t end) {
+    for (std::size_t r = begin; r < end; ++r) {
+      std::size_t e = r * perRow * copies;
+      auto add = [&](int from, int to) {
+        // both directions of a street get the same length
+        const int weight = edgeWeight(options, (std::uint64_t)std::min(from, to) * 2 + (to - from == 1 || from - to == 1));
+        g.edges[e++] = {from, to, weight};
+        if (copies == 2)
+          g.edges[e++] = {to, from, weight};
+      };
+      for (int c = 0; c < cols; ++c) {
+        const int v = r * cols + c;
+        if (c + 1 < cols)
+          add(v, v + 1);
+        if ((int)r + 1 < rows)
+          add(v, v + cols);
+      }
+    }
+  });
+  return g;
+}
+
+
+GeneratedGraph layeredDag(int layers, int width, int degree, const GeneratorOptions &options, int maxDuration) {
+  checkOptions(options);
+  if (layers < 1 || width < 1 || degree < 1 || maxDuration < 1)
+    throw std::runtime_error("Invalid layered DAG parameters");
+  GeneratedGraph g;
+  g.nrOfVertices = layers * width;
+  g.directed = true;
+  generateEdges(g, (std::size_t)(layers - 1) * width * degree, options.nrThreads, [&](std::size_t e) {
+    const int to = width + (int)(e / degree);
+    const int layerStart = (to / width - 1) * width;
+    const int from = layerStart + (int)uniform(hash(options.seed, Endpoints, e), width);
+    return GeneratedEdge{from, to, edgeWeight(options, e)};
+  });
+  g.durations.resize(g.nrOfVertices);
+  utils::parallelForRange(g.nrOfVertices, options.nrThreads, [&](unsigned, std::size_t begin, std::size_t end) {
+    for (std::size_t v = begin; v < end; ++v)
+      g.durations[v] = 1 + (int)uniform(hash(options.seed, Durations, v), maxDuration);
+  });
+  return g;
+}
+
+
+GeneratedGraph generate(const std::string &model, const std::vector<long long> &parameters, const GeneratorOptions &options) {
+  auto expect = [&](std::size_t count, const std::string &usage) {
+    if (parameters.size() != count)
+      throw std::runtime_error("Usage: " + model + " " + usage);
+    for (long long parameter : parameters)
+      if (parameter < 0 || parameter > std::numeric_limits<int>::max())
+        throw std::runtime_error("The parameters of " + model + " have to be non-negative integers");
+  };
+  if (model == "rmat") {
+    expect(2, "<scale> <edge_factor>");
+    return rmat(parameters[0], parameters[1], options);
+  }
+  if (model == "erdos_renyi") {
+    expect(2, "<nr_of_vertices> <nr_of_edges>");
+    return erdosRenyi(parameters[0], parameters[1], options);
+  }
+  if (model == "barabasi_albert") {
+    expect(2, "<nr_of_vertices> <edges_per_vertex>");
+    return barabasiAlbert(parameters[0], parameters[1], options);
+  }
+  if (model == "grid") {
+    expect(2, "<rows> <cols>");
+    if (parameters[0] * parameters[1] > std::numeric_limits<int>::max())
+      throw std::runtime_error("The grid is too large");
+    return grid(parameters[0], parameters[1], options);
+  }
+  if (model == "layered_dag") {
+    expect(3, "<layers> <width> <degree>");
+    if (parameters[0] * parameters[1] > std::numeric_limits<int>::max())
+      throw std::runtime_error("The DAG is too large");
+    return layeredDag(parameters[0], parameters[1], parameters[2], options);
+  }
+  throw std::runtime_error("'" + model + "' is not a valid graph model");
+}
+
+
+/* Buckets the edges by their source, then every thread sorts and deduplicates a range of buckets */
+void simplify(GeneratedGraph &g, unsigned nrThreads) {
+  if (!g.directed)
+    for (auto &edge : g.edges)
+      if (edge.from > edge.to)
+        std::swap(edge.from, edge.to);
+  std::erase_if(g.edges, [](const GeneratedEdge &edge) { return edge.from == edge.to; });
+
+  std::vector<std::size_t> offsets(g.nrOfVertices + 1, 0);
+  for (const auto &edge : g.edges)
+    ++offsets[edge.from + 1];
+  for (int v = 0; v < g.nrOfVertices; ++v)
+    offsets[v + 1] += offsets[v];
+  std::vector<GeneratedEdge> bucketed(g.edges.size());
+  std::vector<std::size_t> cursor(offsets.begin(), offsets.end() - 1);
+  for (const auto &edge : g.edges)
+    bucketed[cursor[edge.from]++] = edge;
+
+  // sizes[v] = number of distinct edges of v, kept at the start of its bucket
+  std::vector<std::size_t> sizes(g.nrOfVertices);
+  utils::parallelForRange(g.nrOfVertices, nrThreads, [&](unsigned, std::size_t begin, std::size_t end) {
+    for (std::size_t v = begin; v < end; ++v) {
+      auto first = bucketed.begin() + offsets[v], last = bucketed.begin() + offsets[v + 1];
+      std::sort(first, last, [](const GeneratedEdge &x, const GeneratedEdge &y) { return x.to < y.to; });
+      sizes[v] = std::unique(first, last, [](const GeneratedEdge &x, const GeneratedEdge &y) { return x.to == y.to; }) - first;
+    }
+  });
+
+  g.edges.clear();
+  for (int v = 0; v < g.nrOfVertices; ++v)
+    g.edges.insert(g.edges.end(), bucketed.begin() + offsets[v], bucketed.begin() + offsets[v] + sizes[v]);
+  g.edges.shrink_to_fit();
+}
+
+
+template <typename G>
+static void fillAny(const GeneratedGraph &generated, G &g, bool activity) {
+  for (int v = 0; v < generated.nrOfVertices; ++v) {
+    if (activity) {
+      const int duration = generated.durations.empty() ? 1 : generated.durations[v];
+      g.addVertex(std::make_shared<special::Activity>(std::to_string(v), "", duration));
+    } else
+      g.addVertex(std::make_shared<StringVertex>(std::to_string(v)));
+  }
+  for (const auto &[from, to, weight] : generated.edges) {
+    const std::string fromId = std::to_string(from), toId = std::to_string(to);
+    if (!g.isEdge(fromId, toId))
+      g.addEdge(fromId, toId, weight);
+  }
+}
+
+void fillGraph(const GeneratedGraph &generated, DirectedGraph &g) {
+  fillAny(generated, g, false);
+}
+
+void fillGraph(const GeneratedGraph &generated, UndirectedGraph &g) {
+  fillAny(generated, g, false);
+}
+
+void fillGraph(const GeneratedGraph &generated, special::ActivityGraph &g) {
+  fillAny(generated, g, true);
+}
+
+
+/*
+* The lines are formatted in parallel with to_chars: every round each thread formats
+* one chunk into its own buffer, then the buffers are written out in order.
+*/
+void writeGraph(const GeneratedGraph &generated, const std::string &path, bool activityFormat, unsigned nrThreads) {
+  FILE *fout = std::fopen(path.c_str(), "w");
+  if (fout == nullptr)
+    throw std::runtime_error("Could not open file '" + path + "' for writing");
+  nrThreads = std::max(1u, nrThreads);
+
+  auto appendNumber = [](std::string &buffer, long long value) {
+    char digits[24];
+    auto [end, _] = std::to_chars(digits, digits + sizeof(digits), value);
+    buffer.append(digits, end);
+  };
+
+  // the predecessors of every vertex, for the activity format
+  std::vector<std::size_t> inOffsets;
+  std::vector<int> inSources;
+  if (activityFormat) {
+    inOffsets.assign(generated.nrOfVertices + 1, 0);
+    for (const auto &edge : generated.edges)
+      ++inOffsets[edge.to + 1];
+    for (int v = 0; v < generated.nrOfVertices; ++v)
+      inOffsets[v + 1] += inOffsets[v];
+    inSources.resize(generated.edges.size());
+    std::vector<std::size_t> cursor(inOffsets.begin(), inOffsets.end() - 1);
+    for (const auto &edge : generated.edges)
+      inSources[cursor[edge.to]++] = edge.from;
+  } else {
+    std::string header;
+    appendNumber(header, generated.nrOfVertices);
+    header += ' ';
+    appendNumber(header, generated.edges.size());
+    header += '\n';
+    std::fwrite(header.data(), 1, header.size(), fout);
+  }
+
+  // an item is an edge line, or a vertex line in the activity format
+  const std::size_t nrOfItems = activityFormat ? generated.nrOfVertices : generated.edges.size();
+  const std::size_t chunk = 1 << 18;
+  std::vector<std::string> buffers(nrThreads);
+  for (std::size_t roundStart = 0; roundStart < nrOfItems; roundStart += chunk * nrThreads) {
+    utils::runParallel(nrThreads, [&](unsigned t) {
+      std::string &buffer = buffers[t];
+      buffer.clear();
+      const std::size_t begin = std::min(nrOfItems, roundStart + t * chunk);
+      const std::size_t end = std::min(nrOfItems, begin + chunk);
+      for (std::size_t i = begin; i < end; ++i) {
+        if (activityFormat) {
+          appendNumber(buffer, i);
+          buffer += " | ";
+          appendNumber(buffer, generated.durations.empty() ? 1 : generated.durations[i]);
+          buffer += " | ";
+          if (inOffsets[i] == inOffsets[i + 1])
+            buffer += '-';
+          for (std::size_t e = inOffsets[i]; e < inOffsets[i + 1]; ++e) {
+            if (e != inOffsets[i])
+              buffer += ',';
+            appendNumber(buffer, inSources[e]);
+          }
+        } else {
+          const auto &edge = generated.edges[i];
+          appendNumber(buffer, edge.from);
+          buffer += ' ';
+          appendNumber(buffer, edge.to);
+          buffer += ' ';
+          appendNumber(buffer, edge.weight);
+        }
+        buffer += '\n';
+      }
+    });
+    for (const auto &buffer : buffers)
+      if (std::fwrite(buffer.data(), 1, buffer.size(), fout) != buffer.size()) {
+        std::fclose(fout);
+        throw std::runtime_error("Could not write to '" + path + "'");
+      }
+  }
+  if (std::fclose(fout) != 0)
+    throw std::runtime_error("Could not write to '" + path + "'");
+}
+
+} // namespace generators
+} // namespace graph
@@ -0,0 +1,80 @@
+#pragma once
+#include "../directed_graph/DirectedGraph.hpp"
+#include "../special/ActivityGraph.hpp"
+#include "../undirected_graph/UndirectedGraph.hpp"
+#include "../utils/Parallel.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace graph {
+namespace generators {
+
+// Synthetic graphs for benchmarks and capacity planning.
+// Every random choice is a hash of (seed, what is being chosen), so the generated graph
+// only depends on the seed and the parameters, never on the number of threads.
+// The vertices are numbered 0..n-1 and become the ids "0".."n-1" in the graph classes.
+
+struct GeneratedEdge {
+  int from;
+  int to;
+  int weight;
+};
+
+struct GeneratedGraph {
+  int nrOfVertices = 0;
+  bool directed = true;
+  std::vector<GeneratedEdge> edges;
+  std::vector<int> durations; // per vertex, only filled for the activity networks
+};
+
+struct GeneratorOptions {
+  std::uint64_t seed = 42;
+  bool directed = true;
+  int minWeight = 1; // the edge weights are uniform in [minWeight, maxWeight]
+  int maxWeight = 1;
+  unsigned nrThreads = utils::defaultThreadCount();
+};
+
+// R-MAT (recursive matrix, the Graph500 Kronecker generator): 2^scale vertices and
+// edgeFactor * 2^scale edges, every edge picks one of the four quadrants with probabilities
+// a, b, c, 1 - a - b - c at each of the scale levels. The vertex ids are shuffled afterwards.
+GeneratedGraph rmat(int scale, int edgeFactor, const GeneratorOptions &options,
+                    double a = 0.57, double b = 0.19, double c = 0.19);
+
+// Erdos-Renyi G(n, m): m edges with uniformly random endpoints
+GeneratedGraph erdosRenyi(int n, std::size_t m, const GeneratorOptions &options);
+
+// Barabasi-Albert preferential attachment: every new vertex attaches to k earlier ones.
+// A new edge copies the endpoint of a uniformly random earlier edge end (Batagelj-Brandes);
+// that choice only depends on the edge index, so the edges are generated in parallel
+// by following the copies back (Sanders-Schulz). Directed edges go from the newer vertex.
+GeneratedGraph barabasiAlbert(int n, int k, const GeneratorOptions &options);
+
+// Road like rows x cols grid: every vertex is connected to its 4 neighbors
+// (in both directions for a directed graph)
+GeneratedGraph grid(int rows, int cols, const GeneratorOptions &options);
+
+// Random layered DAG / activity network: layers of width vertices, every vertex after the first
+// layer depends on degree random vertices of the previous layer. Durations are in [1, maxDuration].
+GeneratedGraph layeredDag(int layers, int width, int degree, const GeneratorOptions &options, int maxDuration = 10);
+
+// Runs the named model ("rmat", "erdos_renyi", "barabasi_albert", "grid" or "layered_dag")
+// with its parameters in the order of the functions above
+GeneratedGraph generate(const std::string &model, const std::vector<long long> &parameters, const GeneratorOptions &options);
+
+// Removes self loops and duplicate edges (for undirected graphs {a, b} and {b, a} are the same edge)
+void simplify(GeneratedGraph &g, unsigned nrThreads = utils::defaultThreadCount());
+
+// Adds the generated vertices and edges to an (empty) graph; the duplicate edges are skipped
+void fillGraph(const GeneratedGraph &generated, DirectedGraph &g);
+void fillGraph(const GeneratedGraph &generated, UndirectedGraph &g);
+void fillGraph(const GeneratedGraph &generated, special::ActivityGraph &g);
+
+// Writes the graph in the format load_graph reads: "n m" followed by "from to cost" lines,
+// or for activity networks "id | duration | predecessors" lines
+void writeGraph(const GeneratedGraph &generated, const std::string &path, bool activityFormat = false,
+                unsigned nrThreads = utils::defaultThreadCount());
+
+} // namespace generators
+} // namespace graph
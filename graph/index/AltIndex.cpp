@@ -0,0 +1,338 @@
+#include "AltIndex.hpp"
+#include "../utils/BinaryIO.hpp"
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <random>
+#include <stdexcept>
+
+namespace graph {
+namespace index {
+
+namespace {
+
+constexpr std::uint32_t ALT_FILE_MAGIC = 0x31544c41; // "ALT1"
+
+using QueueEntry = std::pair<int, int>; // (key, vertex)
+using MinQueue = std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>>;
+
+// Plain Dijkstra over the outbound (or, if reverse, the inbound) edges.
+// settleOrder and parent are filled only when given.
+std::vector<int> shortestDistances(const compact::CompactGraph &g, int source, bool reverse,
+                                   std::vector<int> *settleOrder = nullptr, std::vector<int> *parent = nullptr) {
+  std::vector<int> distance(g.getNrOfVertices(), AltIndex::INF);
+  if (parent != nullptr)
+    parent->assign(g.getNrOfVertices(), -1);
+  MinQueue queue;
+  distance[source] = 0;
+  queue.push({0, source});
+  while (!queue.empty()) {
+    auto [currentDistance, vertex] = queue.top();
+    queue.pop();
+    if (currentDistance > distance[vertex])
+      continue;
+    if (settleOrder != nullptr)
+      settleOrder->push_back(vertex);
+    auto neighbors = reverse ? g.getInNeighbors(vertex) : g.getOutNeighbors(vertex);
+    auto weights = reverse ? g.getInWeights(vertex) : g.getOutWeights(vertex);
+    for (std::size_t e = 0; e < neighbors.size(); ++e) {
+      int newDistance = currentDistance + weights[e];
+      if (newDistance < distance[neighbors[e]]) {
+        distance[neighbors[e]] = newDistance;
+        if (parent != nullptr)
+          (*parent)[neighbors[e]] = vertex;
+        queue.push({newDistance, neighbors[e]});
+      }
+    }
+  }
+  return distance;
+}
+
+// The vertex maximizing the distance to the closest landmark (unreachable counts as farthest)
+int pickFarthest(const std::vector<std::vector<int>> &distances, const std::vector<char> &isLandmark) {
+  int best = -1;
+  long long bestDistance = -1;
+  for (std::size_t v = 0; v < isLandmark.size(); ++v) {
+    if (isLandmark[v])
+      continue;
+    long long closest = std::numeric_limits<long long>::max();
+    for (const auto &column : distances)
+      closest = std::min<long long>(closest, column[v]);
+    if (closest > bestDistance) {
+      bestDistance = closest;
+      best = v;
+    }
+  }
+  return best;
+}
+
+// Avoid heuristic: grows a shortest path tree from a random root, weights every vertex by how
+// badly the current landmarks bound its distance to the root and descends into the heaviest
+// subtree that contains no landmark. The leaf reached is the new landmark (-1 if none qualifies).
+int pickAvoid(const compact::CompactGraph &g, const std::vector<std::vector<int>> &distances,
+              const std::vector<char> &isLandmark, std::mt19937 &rng) {
+  const int n = g.getNrOfVertices();
+  const int root = rng() % n;
+  std::vector<int> settleOrder;
+  std::vector<int> parent;
+  std::vector<int> rootDistance = shortestDistances(g, root, false, &settleOrder, &parent);
+
+  std::vector<long long> size(n, 0);
+  std::vector<char> coversLandmark(n, 0);
+  for (auto it = settleOrder.rbegin(); it != settleOrder.rend(); ++it) {
+    int v = *it;
+    int bound = 0;
+    for (const auto &column : distances)
+      if (column[root] < AltIndex::INF && column[v] < AltIndex::INF)
+        bound = std::max(bound, column[v] - column[root]);
+    size[v] += rootDistance[v] - bound;
+    if (isLandmark[v])
+      coversLandmark[v] = 1;
+    if (coversLandmark[v])
+      size[v] = 0;
+    if (parent[v] != -1) {
+      size[parent[v]] += size[v];
+      coversLandmark[parent[v]] |= coversLandmark[v];
+    }
+  }
+  if (size[root] == 0)
+    return -1;
+
+  std::vector<std::vector<int>> children(n);
+  for (int v : settleOrder)
+    if (parent[v] != -1)
+      children[parent[v]].push_back(v);
+
+  int current = root;
+  while (true) {
+    int next = -1;
+    for (int child : children[current])
+      if (size[child] > 0 && (next == -1 || size[child] > size[next]))
+        next = child;
+    if (next == -1)
+      break;
+    current = next;
+  }
+  return isLandmark[current] ? -1 : current;
+}
+
+// Per thread scratch space of the A* search, reset in O(1) between queries
+struct SearchSpace {
+  std::vector<int> distance;
+  std::vector<int> parent;
+  std::vector<unsigned> reached;
+  std::vector<unsigned> settled;
+  unsigned stamp = 0;
+
+  void reset(int n) {
+    if ((int)reached.size() != n || ++stamp == 0) {
+      distance.assign(n, 0);
+      parent.assign(n, -1);
+      reached.assign(n, 0);
+      settled.assign(n, 0);
+      stamp = 1;
+    }
+  }
+};
+
+} // namespace
+
+
+AltIndex::AltIndex(std::shared_ptr<const compact::CompactGraph> graph, int nrLandmarks, LandmarkSelection selection, unsigned nrThreads)
+    : graph(std::move(graph)) {
+  const compact::CompactGraph &g = *this->graph;
+  const int n = g.getNrOfVertices();
+  if (n == 0)
+    throw std::runtime_error("Cannot build an ALT index for an empty graph");
+  if (nrLandmarks <= 0)
+    throw std::runtime_error("The number of landmarks must be positive");
+  if (g.getMinEdgeWeight() < 0)
+    throw std::runtime_error("ALT requires non-negative edge weights");
+  nrLandmarks = std::min(nrLandmarks, n);
+
+  // Landmarks are chosen one after the other, each choice depends on the distances from the previous ones
+  std::mt19937 rng(n);
+  std::vector<char> isLandmark(n, 0);
+  std::vector<std::vector<int>> forward;
+  while ((int)landmarks.size() < nrLandmarks) {
+    int landmark = -1;
+    if (landmarks.empty()) {
+      // the first landmark is the vertex farthest from a random one
+      landmark = pickFarthest({shortestDistances(g, rng() % n, false)}, isLandmark);
+    } else {
+      if (selection == LandmarkSelection::Avoid)
+        landmark = pickAvoid(g, forward, isLandmark, rng);
+      if (landmark == -1)
+        landmark = pickFarthest(forward, isLandmark);
+    }
+    landmarks.push_back(landmark);
+    isLandmark[landmark] = 1;
+    forward.push_back(shortestDistances(g, landmark, false));
+  }
+
+  // The distances to the landmarks are independent of each other
+  std::vector<std::vector<int>> backward(landmarks.size());
+  utils::parallelForRange(landmarks.size(), nrThreads, [&](unsigned, std::size_t begin, std::size_t end) {
+    for (std::size_t l = begin; l < end; ++l)
+      backward[l] = shortestDistances(g, landmarks[l], true);
+  });
+
+  // Stored vertex major so that the bounds of one vertex are contiguous
+  const std::size_t k = landmarks.size();
+  fromLandmark.resize(n * k);
+  toLandmark.resize(n * k);
+  for (int v = 0; v < n; ++v) {
+    for (std::size_t l = 0; l < k; ++l) {
+      fromLandmark[v * k + l] = forward[l][v];
+      toLandmark[v * k + l] = backward[l][v];
+    }
+  }
+}
+
+
+AltIndex::AltIndex(std::shared_ptr<const compact::CompactGraph> graph, const std::string &path)
+    : graph(std::move(graph)) {
+  std::ifstream fin(path, std::ios::binary);
+  if (!fin.is_open())
+    throw std::runtime_error("Could not open file '" + path + "' for reading");
+  if (utils::readPod<std::uint32_t>(fin) != ALT_FILE_MAGIC)
+    throw std::runtime_error("'" + path + "' is not an ALT index");
+  if (utils::readPod<std::uint64_t>(fin) != this->graph->getFingerprint())
+    throw std::runtime_error("The ALT index in '" + path + "' was built for a different graph");
+
+  // The vertex numbering is not stable between runs, so the rows are mapped back through the ids
+  const std::uint32_t n = utils::readPod<std::uint32_t>(fin);
+  if ((int)n != this->graph->getNrOfVertices())
+    throw std::runtime_error("The ALT index in '" + path + "' was built for a different graph");
+  std::vector<int> currentIndex(n);
+  for (std::uint32_t v = 0; v < n; ++v)
+    currentIndex[v] = this->graph->getIndex(utils::readString(fin));
+
+  landmarks = utils::readVector<int>(fin);
+  for (int &landmark : landmarks)
+    landmark = currentIndex.at(landmark);
+  std::vector<int> storedFrom = utils::readVector<int>(fin);
+  std::vector<int> storedTo = utils::readVector<int>(fin);
+  const std::size_t k = landmarks.size();
+  if (storedFrom.size() != n * k || storedTo.size() != n * k)
+    throw std::runtime_error("The ALT index in '" + path + "' is corrupted");
+
+  fromLandmark.resize(n * k);
+  toLandmark.resize(n * k);
+  for (std::uint32_t v = 0; v < n; ++v) {
+    std::copy_n(storedFrom.begin() + v * k, k, fromLandmark.begin() + currentIndex[v] * k);
+    std::copy_n(storedTo.begin() + v * k, k, toLandmark.begin() + currentIndex[v] * k);
+  }
+}
+
+
+// A* search with the landmark lower bounds as potential function
+PathQueryResult AltIndex::findShortestPath(const idT &startId, const idT &endId) const {
+  const compact::CompactGraph &g = *graph;
+  const int start = g.getIndex(startId);
+  const int target = g.getIndex(endId);
+  const std::size_t k = landmarks.size();
+  const int *targetFrom = fromLandmark.data() + target * k;
+  const int *targetTo = toLandmark.data() + target * k;
+
+  // max over the landmarks of d(L, t) - d(L, v) and d(v, L) - d(t, L); INF if v provably cannot reach t
+  auto lowerBound = [&](int vertex) {
+    const int *vertexFrom = fromLandmark.data() + vertex * k;
+    const int *vertexTo = toLandmark.data() + vertex * k;
+    int bound = 0;
+    for (std::size_t l = 0; l < k; ++l) {
+      if (targetFrom[l] < INF) {
+        if (vertexFrom[l] < INF)
+          bound = std::max(bound, targetFrom[l] - vertexFrom[l]);
+      } else if (vertexFrom[l] < INF) {
+        return INF; // L reaches v but not t
+      }
+      if (targetTo[l] < INF) {
+        if (vertexTo[l] >= INF)
+          return INF; // t reaches L but v does not
+        bound = std::max(bound, vertexTo[l] - targetTo[l]);
+      }
+    }
+    return bound;
+  };
+
+  thread_local SearchSpace space;
+  space.reset(g.getNrOfVertices());
+  PathQueryResult result;
+  if (lowerBound(start) >= INF)
+    return result;
+
+  MinQueue queue;
+  space.distance[start] = 0;
+  space.parent[start] = -1;
+  space.reached[start] = space.stamp;
+  queue.push({lowerBound(start), start});
+  while (!queue.empty()) {
+    int vertex = queue.top().second;
+    queue.pop();
+    if (space.settled[vertex] == space.stamp)
+      continue;
+    space.settled[vertex] = space.stamp;
+    ++result.settledVertices;
+
+    if (vertex == target) {
+      result.cost = space.distance[target];
+      for (int v = target; v != -1; v = space.parent[v])
+        result.path.push_back(g.getId(v));
+      std::reverse(result.path.begin(), result.path.end());
+      return result;
+    }
+
+    auto neighbors = g.getOutNeighbors(vertex);
+    auto weights = g.getOutWeights(vertex);
+    for (std::size_t e = 0; e < neighbors.size(); ++e) {
+      const int next = neighbors[e];
+      const int newDistance = space.distance[vertex] + weights[e];
+      if (space.reached[next] == space.stamp && newDistance >= space.distance[next])
+        continue;
+      const int bound = lowerBound(next);
+      if (bound >= INF)
+        continue;
+      space.reached[next] = space.stamp;
+      space.distance[next] = newDistance;
+      space.parent[next] = vertex;
+      queue.push({newDistance + bound, next});
+    }
+  }
+  return result;
+}
+
+
+void AltIndex::save(const std::string &path) const {
+  std::ofstream fout(path, std::ios::binary);
+  if (!fout.is_open())
+    throw std::runtime_error("Could not open file '" + path + "' for writing");
+
+  utils::writePod(fout, ALT_FILE_MAGIC);
+  utils::writePod<std::uint64_t>(fout, graph->getFingerprint());
+  utils::writePod<std::uint32_t>(fout, graph->getNrOfVertices());
+  for (int v = 0; v < graph->getNrOfVertices(); ++v)
+    utils::writeString(fout, graph->getId(v));
+  utils::writeVector(fout, landmarks);
+  utils::writeVector(fout, fromLandmark);
+  utils::writeVector(fout, toLandmark);
+  if (!fout)
+    throw std::runtime_error("Could not write the ALT index to '" + path + "'");
+}
+
+
+std::vector<idT> AltIndex::getLandmarks() const {
+  std::vector<idT> ids;
+  for (int landmark : landmarks)
+    ids.push_back(graph->getId(landmark));
+  return ids;
+}
+
+
+std::size_t AltIndex::getMemoryUsage() const {
+  return utils::vectorBytes(landmarks) + utils::vectorBytes(fromLandmark) + utils::vectorBytes(toLandmark);
+}
+
+} // namespace index
+} // namespace graph
@@ -0,0 +1,51 @@
+#pragma once
+#include "../compact/CompactGraph.hpp"
+#include "../utils/Parallel.hpp"
+#include "PathQueryResult.hpp"
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace graph {
+namespace index {
+
+enum class LandmarkSelection {
+  Farthest, // every new landmark is the vertex farthest from the ones already chosen
+  Avoid     // Goldberg & Werneck: the leaf of the shortest path tree region the landmarks cover worst
+};
+
+// ALT (A*, Landmarks, Triangle inequality) point to point shortest path index.
+// For every landmark L it stores d(L, v) and d(v, L) for all the vertices, the
+// differences of which are lower bounds on d(v, t) that guide an A* search.
+// The index is immutable: it has to be rebuilt whenever the graph changes.
+class AltIndex {
+private:
+  std::shared_ptr<const compact::CompactGraph> graph;
+  std::vector<int> landmarks;
+  // vertex major tables: fromLandmark[v * k + l] = d(landmarks[l], v), toLandmark[v * k + l] = d(v, landmarks[l])
+  std::vector<int> fromLandmark;
+  std::vector<int> toLandmark;
+
+public:
+  static constexpr int INF = std::numeric_limits<int>::max() / 2;
+
+  AltIndex(std::shared_ptr<const compact::CompactGraph> graph, int nrLandmarks,
+           LandmarkSelection selection = LandmarkSelection::Avoid,
+           unsigned nrThreads = utils::defaultThreadCount());
+  // Loads an index written by save(); throws if it was built for a different graph
+  AltIndex(std::shared_ptr<const compact::CompactGraph> graph, const std::string &path);
+
+  PathQueryResult findShortestPath(const idT &startId, const idT &endId) const;
+
+  void save(const std::string &path) const;
+
+  const compact::CompactGraph &getGraph() const { return *graph; }
+  std::vector<idT> getLandmarks() const;
+
+  // Bytes held by the index, without the compact graph it shares
+  std::size_t getMemoryUsage() const;
+};
+
+} // namespace index
+} // namespace graph
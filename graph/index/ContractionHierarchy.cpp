@@ -0,0 +1,485 @@
+#include "ContractionHierarchy.hpp"
+#include "../utils/BinaryIO.hpp"
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+
+namespace graph {
+namespace index {
+
+namespace {
+
+constexpr std::uint32_t CH_FILE_MAGIC = 0x31304843; // "CH01"
+// a witness search gives up after settling this many vertices (fewer when only estimating the priority)
+constexpr int WITNESS_SETTLE_LIMIT = 500;
+constexpr int SIMULATION_SETTLE_LIMIT = 50;
+
+using QueueEntry = std::pair<int, int>; // (distance, vertex)
+using MinQueue = std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>>;
+using Edge = ContractionHierarchy::UpwardEdge;
+
+struct Shortcut {
+  int from;
+  int to;
+  int weight;
+  int middle;
+};
+
+// Stores the edge, or lowers the weight of an already stored edge to the same vertex
+void addOrImprove(std::vector<Edge> &edges, int vertex, int weight, int middle) {
+  for (auto &edge : edges) {
+    if (edge.vertex == vertex) {
+      if (weight < edge.weight)
+        edge = {vertex, weight, middle};
+      return;
+    }
+  }
+  edges.push_back({vertex, weight, middle});
+}
+
+void removeEdgeTo(std::vector<Edge> &edges, int vertex) {
+  for (std::size_t i = 0; i < edges.size(); ++i) {
+    if (edges[i].vertex == vertex) {
+      edges[i] = edges.back();
+      edges.pop_back();
+      return;
+    }
+  }
+}
+
+// Dijkstra scratch space reused between searches, reset in O(1)
+struct SearchSpace {
+  std::vector<int> distance;
+  std::vector<int> parent;
+  std::vector<int> parentMiddle;
+  std::vector<unsigned> reached;
+  std::vector<unsigned> settled;
+  unsigned stamp = 0;
+
+  void reset(int n) {
+    if ((int)reached.size() != n || ++stamp == 0) {
+      distance.assign(n, 0);
+      parent.assign(n, -1);
+      parentMiddle.assign(n, -1);
+      reached.assign(n, 0);
+      settled.assign(n, 0);
+      stamp = 1;
+    }
+  }
+
+  bool isReached(int vertex) const { return reached[vertex] == stamp; }
+  int distanceTo(int vertex) const { return isReached(vertex) ? distance[vertex] : ContractionHierarchy::INF; }
+};
+
+// The graph being contracted: the remaining vertices with their original edges and the shortcuts added so far
+class Overlay {
+public:
+  std::vector<std::vector<Edge>> out;
+  std::vector<std::vector<Edge>> in;
+  std::vector<char> contracted;
+  std::vector<char> inRound; // the independent set contracted in the current round
+
+  explicit Overlay(const compact::CompactGraph &g)
+      : out(g.getNrOfVertices()), in(g.getNrOfVertices()),
+        contracted(g.getNrOfVertices(), 0), inRound(g.getNrOfVertices(), 0) {
+    for (int v = 0; v < g.getNrOfVertices(); ++v) {
+      auto neighbors = g.getOutNeighbors(v);
+      auto weights = g.getOutWeights(v);
+      for (std::size_t e = 0; e < neighbors.size(); ++e) {
+        if (neighbors[e] == v)
+          continue; // a loop is never part of a shortest path
+        addOrImprove(out[v], neighbors[e], weights[e], -1);
+        addOrImprove(in[neighbors[e]], v, weights[e], -1);
+      }
+    }
+  }
+
+  // Finds the shortcuts contracting v requires. The witness searches avoid v and, when
+  // avoidRound is set, every vertex contracted in the same round so that the shortcuts of
+  // the whole independent set stay correct when added together.
+  void findShortcuts(int v, bool avoidRound, SearchSpace &space, std::vector<Shortcut> &shortcuts) const {
+    int maxOut = 0;
+    for (const auto &edge : out[v])
+      maxOut = std::max(maxOut, edge.weight);
+    const int settleLimit = avoidRound ? WITNESS_SETTLE_LIMIT : SIMULATION_SETTLE_LIMIT;
+
+    for (const auto &inEdge : in[v]) {
+      const int source = inEdge.vertex;
+      const int limit = inEdge.weight + maxOut;
+
+      space.reset(out.size());
+      // the targets are marked so that the search can stop once all of them are settled
+      int targetsLeft = 0;
+      for (const auto &outEdge : out[v]) {
+        if (outEdge.vertex != source && space.settled[outEdge.vertex] != space.stamp) {
+          space.settled[outEdge.vertex] = space.stamp;
+          ++targetsLeft;
+        }
+      }
+      MinQueue queue;
+      space.reached[source] = space.stamp;
+      space.distance[source] = 0;
+      queue.push({0, source});
+      int settledCount = 0;
+      while (!queue.empty() && settledCount < settleLimit && targetsLeft > 0) {
+        auto [distance, vertex] = queue.top();
+        queue.pop();
+        if (distance > space.distance[vertex])
+          continue;
+        if (distance > limit)
+          break;
+        ++settledCount;
+        if (space.settled[vertex] == space.stamp) {
+          space.settled[vertex] = 0;
+          --targetsLeft;
+        }
+        for (const auto &edge : out[vertex]) {
+          if (edge.vertex == v || (avoidRound && inRound[edge.vertex]))
+            continue;
+          const int newDistance = distance + edge.weight;
+          if (!space.isReached(edge.vertex) || newDistance < space.distance[edge.vertex]) {
+            space.reached[edge.vertex] = space.stamp;
+            space.distance[edge.vertex] = newDistance;
+            queue.push({newDistance, edge.vertex});
+          }
+        }
+      }
+
+      for (const auto &outEdge : out[v]) {
+        if (outEdge.vertex == source)
+          continue;
+        const int viaV = inEdge.weight + outEdge.weight;
+        if (space.distanceTo(outEdge.vertex) > viaV)
+          shortcuts.push_back({source, outEdge.vertex, viaV, v});
+      }
+    }
+  }
+};
+
+// Rewrites a CSR graph stored with another vertex numbering
+ContractionHierarchy::UpwardEdge remapEdge(const Edge &edge, const std::vector<int> &newIndex) {
+  return {newIndex.at(edge.vertex), edge.weight, edge.middle == -1 ? -1 : newIndex.at(edge.middle)};
+}
+
+} // namespace
+
+
+// Contracts the graph in rounds. Every round the priorities of the remaining vertices are
+// computed in parallel, the vertices that are less important than all their neighbors form an
+// independent set, their shortcuts are searched in parallel and then all of them are contracted.
+ContractionHierarchy::ContractionHierarchy(std::shared_ptr<const compact::CompactGraph> graph, unsigned nrThreads)
+    : graph(std::move(graph)) {
+  const compact::CompactGraph &g = *this->graph;
+  const int n = g.getNrOfVertices();
+  if (g.getMinEdgeWeight() < 0)
+    throw std::runtime_error("Contraction hierarchies require non-negative edge weights");
+  nrThreads = std::max(1u, nrThreads);
+
+  Overlay overlay(g);
+  rank.assign(n, -1);
+  std::vector<int> deletedNeighbors(n, 0);
+  std::vector<int> level(n, 0);
+  std::vector<int> priority(n, 0);
+  std::vector<std::vector<Edge>> upOut(n);
+  std::vector<std::vector<Edge>> upIn(n);
+  std::vector<SearchSpace> spaces(nrThreads);
+  std::vector<std::vector<Shortcut>> roundShortcuts(nrThreads);
+
+  std::vector<int> remaining(n);
+  for (int v = 0; v < n; ++v)
+    remaining[v] = v;
+  // ties between equal priorities are broken by a scrambled index
+  auto tieBreak = [](int v) { return (unsigned)v * 2654435761u; };
+
+  // only the neighbors of contracted vertices need their priority recomputed
+  std::vector<char> dirty(n, 1);
+  std::vector<int> toUpdate;
+
+  int nextRank = 0;
+  while (!remaining.empty()) {
+    toUpdate.clear();
+    for (int v : remaining)
+      if (dirty[v])
+        toUpdate.push_back(v);
+    utils::parallelForRange(toUpdate.size(), nrThreads, [&](unsigned t, std::size_t begin, std::size_t end) {
+      std::vector<Shortcut> simulated;
+      for (std::size_t i = begin; i < end; ++i) {
+        const int v = toUpdate[i];
+        dirty[v] = 0;
+        simulated.clear();
+        overlay.findShortcuts(v, false, spaces[t], simulated);
+        const int edgeDifference = (int)simulated.size() - (int)(overlay.in[v].size() + overlay.out[v].size());
+        priority[v] = edgeDifference + deletedNeighbors[v] + level[v];
+      }
+    });
+
+    auto lessImportant = [&](int a, int b) {
+      return priority[a] < priority[b] || (priority[a] == priority[b] && tieBreak(a) < tieBreak(b));
+    };
+    std::vector<int> selected;
+    for (int v : remaining) {
+      bool isLocalMinimum = true;
+      for (const auto *edges : {&overlay.out[v], &overlay.in[v]})
+        for (const auto &edge : *edges)
+          if (!lessImportant(v, edge.vertex))
+            isLocalMinimum = false;
+      if (isLocalMinimum) {
+        selected.push_back(v);
+        overlay.inRound[v] = 1;
+      }
+    }
+
+    for (auto &shortcuts : roundShortcuts)
+      shortcuts.clear();
+    utils::parallelForRange(selected.size(), nrThreads, [&](unsigned t, std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; ++i)
+        overlay.findShortcuts(selected[i], true, spaces[t], roundShortcuts[t]);
+    });
+
+    // The selected vertices are not adjacent, so contracting them does not change each other's edges
+    for (int v : selected) {
+      rank[v] = nextRank++;
+      upOut[v] = overlay.out[v];
+      upIn[v] = overlay.in[v];
+      for (const auto &edge : overlay.out[v]) {
+        removeEdgeTo(overlay.in[edge.vertex], v);
+        ++deletedNeighbors[edge.vertex];
+        level[edge.vertex] = std::max(level[edge.vertex], level[v] + 1);
+        dirty[edge.vertex] = 1;
+      }
+      for (const auto &edge : overlay.in[v]) {
+        removeEdgeTo(overlay.out[edge.vertex], v);
+        ++deletedNeighbors[edge.vertex];
+        level[edge.vertex] = std::max(level[edge.vertex], level[v] + 1);
+        dirty[edge.vertex] = 1;
+      }
+      overlay.out[v].clear();
+      overlay.in[v].clear();
+      overlay.contracted[v] = 1;
+      overlay.inRound[v] = 0;
+    }
+    for (const auto &shortcuts : roundShortcuts) {
+      for (const auto &shortcut : shortcuts) {
+        addOrImprove(overlay.out[shortcut.from], shortcut.to, shortcut.weight, shortcut.middle);
+        addOrImprove(overlay.in[shortcut.to], shortcut.from, shortcut.weight, shortcut.middle);
+      }
+    }
+
+    std::erase_if(remaining, [&](int v) { return overlay.contracted[v]; });
+  }
+
+  auto toCsr = [n](std::vector<std::vector<Edge>> &lists, UpwardGraph &csr) {
+    csr.offsets.assign(n + 1, 0);
+    for (int v = 0; v < n; ++v) {
+      // sorted so that unpacking can binary search the edges of a vertex
+      std::sort(lists[v].begin(), lists[v].end(), [](const Edge &a, const Edge &b) { return a.vertex < b.vertex; });
+      csr.edges.insert(csr.edges.end(), lists[v].begin(), lists[v].end());
+      csr.offsets[v + 1] = csr.edges.size();
+      std::vector<Edge>().swap(lists[v]);
+    }
+  };
+  toCsr(upOut, forwardUp);
+  toCsr(upIn, backwardUp);
+}
+
+
+ContractionHierarchy::ContractionHierarchy(std::shared_ptr<const compact::CompactGraph> graph, const std::string &path)
+    : graph(std::move(graph)) {
+  std::ifstream fin(path, std::ios::binary);
+  if (!fin.is_open())
+    throw std::runtime_error("Could not open file '" + path + "' for reading");
+  if (utils::readPod<std::uint32_t>(fin) != CH_FILE_MAGIC)
+    throw std::runtime_error("'" + path + "' is not a contraction hierarchy");
+  if (utils::readPod<std::uint64_t>(fin) != this->graph->getFingerprint())
+    throw std::runtime_error("The contraction hierarchy in '" + path + "' was built for a different graph");
+
+  // The vertex numbering is not stable between runs, so everything is mapped back through the ids
+  const std::uint32_t n = utils::readPod<std::uint32_t>(fin);
+  if ((int)n != this->graph->getNrOfVertices())
+    throw std::runtime_error("The contraction hierarchy in '" + path + "' was built for a different graph");
+  std::vector<int> newIndex(n);
+  for (std::uint32_t v = 0; v < n; ++v)
+    newIndex[v] = this->graph->getIndex(utils::readString(fin));
+
+  std::vector<int> storedRank = utils::readVector<int>(fin);
+  if (storedRank.size() != n)
+    throw std::runtime_error("The contraction hierarchy in '" + path + "' is corrupted");
+  rank.assign(n, -1);
+  for (std::uint32_t v = 0; v < n; ++v)
+    rank[newIndex[v]] = storedRank[v];
+
+  for (UpwardGraph *upward : {&forwardUp, &backwardUp}) {
+    std::vector<std::size_t> offsets = utils::readVector<std::size_t>(fin);
+    std::vector<Edge> edges = utils::readVector<Edge>(fin);
+    if (offsets.size() != n + 1 || offsets.back() != edges.size())
+      throw std::runtime_error("The contraction hierarchy in '" + path + "' is corrupted");
+
+    upward->offsets.assign(n + 1, 0);
+    for (std::uint32_t v = 0; v < n; ++v)
+      upward->offsets[newIndex[v] + 1] = offsets[v + 1] - offsets[v];
+    for (std::uint32_t v = 0; v < n; ++v)
+      upward->offsets[v + 1] += upward->offsets[v];
+    upward->edges.resize(edges.size());
+    for (std::uint32_t v = 0; v < n; ++v) {
+      std::size_t slot = upward->offsets[newIndex[v]];
+      for (std::size_t e = offsets[v]; e < offsets[v + 1]; ++e)
+        upward->edges[slot++] = remapEdge(edges[e], newIndex);
+      std::sort(upward->edges.begin() + upward->offsets[newIndex[v]], upward->edges.begin() + slot,
+                [](const Edge &a, const Edge &b) { return a.vertex < b.vertex; });
+    }
+  }
+}
+
+
+/* Appends to path the vertices after fromVertex on the original edges the given edge stands for */
+void ContractionHierarchy::unpackEdge(int fromVertex, int toVertex, int middle, std::vector<int> &path) const {
+  auto findEdge = [](std::span<const Edge> edges, int vertex) -> const Edge & {
+    auto it = std::lower_bound(edges.begin(), edges.end(), vertex,
+                               [](const Edge &edge, int value) { return edge.vertex < value; });
+    if (it == edges.end() || it->vertex != vertex)
+      throw std::runtime_error("Corrupted contraction hierarchy: missing shortcut half");
+    return *it;
+  };
+
+  std::vector<Shortcut> stack{{fromVertex, toVertex, 0, middle}};
+  while (!stack.empty()) {
+    Shortcut current = stack.back();
+    stack.pop_back();
+    if (current.middle == -1) {
+      path.push_back(current.to);
+      continue;
+    }
+    // the middle vertex is lower than both ends: from -> middle is stored at the middle's
+    // backward edges, middle -> to at its forward edges
+    const Edge &firstHalf = findEdge(backwardUp.at(current.middle), current.from);
+    const Edge &secondHalf = findEdge(forwardUp.at(current.middle), current.to);
+    stack.push_back({current.middle, current.to, secondHalf.weight, secondHalf.middle});
+    stack.push_back({current.from, current.middle, firstHalf.weight, firstHalf.middle});
+  }
+}
+
+
+PathQueryResult ContractionHierarchy::findShortestPath(const idT &startId, const idT &endId) const {
+  const int n = graph->getNrOfVertices();
+  const int start = graph->getIndex(startId);
+  const int target = graph->getIndex(endId);
+
+  thread_local SearchSpace spaces[2];
+  SearchSpace &forward = spaces[0];
+  SearchSpace &backward = spaces[1];
+  forward.reset(n);
+  backward.reset(n);
+
+  MinQueue queues[2];
+  for (auto [space, queue, source] : {std::tuple{&forward, &queues[0], start}, std::tuple{&backward, &queues[1], target}}) {
+    space->reached[source] = space->stamp;
+    space->distance[source] = 0;
+    space->parent[source] = -1;
+    queue->push({0, source});
+  }
+
+  PathQueryResult result;
+  int best = INF;
+  int meeting = -1;
+  int side = 0;
+  while (true) {
+    // a direction is finished once its smallest key can no longer improve the best path
+    bool open[2];
+    for (int s = 0; s < 2; ++s)
+      open[s] = !queues[s].empty() && queues[s].top().first < best;
+    if (!open[0] && !open[1])
+      break;
+    if (!open[side])
+      side = 1 - side;
+
+    SearchSpace &space = spaces[side];
+    const SearchSpace &other = spaces[1 - side];
+    auto [distance, vertex] = queues[side].top();
+    queues[side].pop();
+    side = 1 - side; // alternate the directions
+    if (space.settled[vertex] == space.stamp)
+      continue;
+    space.settled[vertex] = space.stamp;
+    ++result.settledVertices;
+
+    if (other.isReached(vertex) && distance + other.distance[vertex] < best) {
+      best = distance + other.distance[vertex];
+      meeting = vertex;
+    }
+
+    const UpwardGraph &upward = (&space == &forward) ? forwardUp : backwardUp;
+    for (const auto &edge : upward.at(vertex)) {
+      const int newDistance = distance + edge.weight;
+      if (!space.isReached(edge.vertex) || newDistance < space.distance[edge.vertex]) {
+        space.reached[edge.vertex] = space.stamp;
+        space.distance[edge.vertex] = newDistance;
+        space.parent[edge.vertex] = vertex;
+        space.parentMiddle[edge.vertex] = edge.middle;
+        queues[&space == &forward ? 0 : 1].push({newDistance, edge.vertex});
+      }
+    }
+  }
+
+  if (meeting == -1)
+    return result;
+
+  // start -> meeting along the forward parents, meeting -> end along the backward ones
+  std::vector<Shortcut> upwardPath;
+  for (int v = meeting; v != start; v = forward.parent[v])
+    upwardPath.push_back({forward.parent[v], v, 0, forward.parentMiddle[v]});
+  std::reverse(upwardPath.begin(), upwardPath.end());
+  for (int v = meeting; v != target; v = backward.parent[v])
+    upwardPath.push_back({v, backward.parent[v], 0, backward.parentMiddle[v]});
+
+  std::vector<int> path{start};
+  for (const auto &edge : upwardPath)
+    unpackEdge(edge.from, edge.to, edge.middle, path);
+
+  result.cost = best;
+  for (int v : path)
+    result.path.push_back(graph->getId(v));
+  return result;
+}
+
+
+void ContractionHierarchy::save(const std::string &path) const {
+  std::ofstream fout(path, std::ios::binary);
+  if (!fout.is_open())
+    throw std::runtime_error("Could not open file '" + path + "' for writing");
+
+  utils::writePod(fout, CH_FILE_MAGIC);
+  utils::writePod<std::uint64_t>(fout, graph->getFingerprint());
+  utils::writePod<std::uint32_t>(fout, graph->getNrOfVertices());
+  for (int v = 0; v < graph->getNrOfVertices(); ++v)
+    utils::writeString(fout, graph->getId(v));
+  utils::writeVector(fout, rank);
+  for (const UpwardGraph *upward : {&forwardUp, &backwardUp}) {
+    utils::writeVector(fout, upward->offsets);
+    utils::writeVector(fout, upward->edges);
+  }
+  if (!fout)
+    throw std::runtime_error("Could not write the contraction hierarchy to '" + path + "'");
+}
+
+
+/* Returns the number of shortcut edges the contraction added */
+std::size_t ContractionHierarchy::getNrOfShortcuts() const {
+  std::size_t count = 0;
+  for (const UpwardGraph *upward : {&forwardUp, &backwardUp})
+    for (const auto &edge : upward->edges)
+      count += edge.middle != -1;
+  return count;
+}
+
+
+std::size_t ContractionHierarchy::getMemoryUsage() const {
+  std::size_t bytes = utils::vectorBytes(rank);
+  for (const UpwardGraph *upward : {&forwardUp, &backwardUp})
+    bytes += utils::vectorBytes(upward->offsets) + utils::vectorBytes(upward->edges);
+  return bytes;
+}
+
+} // namespace index
+} // namespace graph
@@ -0,0 +1,63 @@
+#pragma once
+#include "../compact/CompactGraph.hpp"
+#include "../utils/Parallel.hpp"
+#include "PathQueryResult.hpp"
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace graph {
+namespace index {
+
+// Contraction hierarchy over a (static) directed graph with non-negative weights.
+// The vertices are contracted in order of importance; contracting v adds a shortcut
+// u -> w (through v) whenever u -> v -> w is the only shortest path between them.
+// Queries are bidirectional Dijkstra searches that only go up in the order and the
+// shortcuts of the resulting path are unpacked back to the original edges.
+class ContractionHierarchy {
+public:
+  static constexpr int INF = std::numeric_limits<int>::max() / 2;
+
+  // An edge of the search graph; middle is the contracted vertex a shortcut bypasses (-1 for original edges)
+  struct UpwardEdge {
+    int vertex;
+    int weight;
+    int middle;
+  };
+
+  ContractionHierarchy(std::shared_ptr<const compact::CompactGraph> graph,
+                       unsigned nrThreads = utils::defaultThreadCount());
+  // Loads a hierarchy written by save(); throws if it was built for a different graph
+  ContractionHierarchy(std::shared_ptr<const compact::CompactGraph> graph, const std::string &path);
+
+  PathQueryResult findShortestPath(const idT &startId, const idT &endId) const;
+
+  void save(const std::string &path) const;
+
+  std::size_t getNrOfShortcuts() const;
+
+  // Bytes held by the hierarchy, without the compact graph it shares
+  std::size_t getMemoryUsage() const;
+
+private:
+  // CSR adjacency of the edges leading to vertices of higher rank
+  struct UpwardGraph {
+    std::vector<std::size_t> offsets;
+    std::vector<UpwardEdge> edges;
+    std::span<const UpwardEdge> at(int vertex) const {
+      return {edges.data() + offsets[vertex], edges.data() + offsets[vertex + 1]};
+    }
+  };
+
+  std::shared_ptr<const compact::CompactGraph> graph;
+  std::vector<int> rank;
+  UpwardGraph forwardUp;  // v -> w with rank[w] > rank[v]
+  UpwardGraph backwardUp; // u -> v with rank[u] > rank[v], stored at v
+
+  void unpackEdge(int fromVertex, int toVertex, int middle, std::vector<int> &path) const;
+};
+
+} // namespace index
+} // namespace graph
@@ -0,0 +1,17 @@
+#pragma once
+#include "../abstract/edges/Edge.hpp"
+#include <vector>
+
+namespace graph {
+namespace index {
+
+// Answer of a point to point query on a shortest path index.
+// An empty path means that the end is not reachable from the start.
+struct PathQueryResult {
+  std::vector<idT> path;
+  int cost = 0;
+  int settledVertices = 0; // vertices removed from the priority queue(s) while answering
+};
+
+} // namespace index
+} // namespace graph
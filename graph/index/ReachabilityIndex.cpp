@@ -0,0 +1,172 @@
+#include "ReachabilityIndex.hpp"
+#include "../algorithms/DirectedGraphAlgorithms.hpp"
+#include <algorithm>
+#include <queue>
+#include <random>
+
+namespace graph {
+namespace index {
+
+ReachabilityIndex::ReachabilityIndex(std::shared_ptr<const compact::CompactGraph> graph, int nrOfLabels)
+    : graph(std::move(graph)), nrOfLabels(std::max(1, nrOfLabels)) {
+  const compact::CompactGraph &g = *this->graph;
+  auto scc = algorithms::getStronglyConnectedComponents(g);
+  component = std::move(scc.component);
+  const int nrOfComponents = scc.nrOfComponents;
+
+  // Condensation DAG without duplicate edges
+  dagOut.resize(nrOfComponents);
+  dagIn.resize(nrOfComponents);
+  for (int v = 0; v < g.getNrOfVertices(); ++v)
+    for (int next : g.getOutNeighbors(v))
+      if (component[v] != component[next])
+        dagOut[component[v]].push_back(component[next]);
+  for (int c = 0; c < nrOfComponents; ++c) {
+    std::sort(dagOut[c].begin(), dagOut[c].end());
+    dagOut[c].erase(std::unique(dagOut[c].begin(), dagOut[c].end()), dagOut[c].end());
+    for (int next : dagOut[c])
+      dagIn[next].push_back(c);
+  }
+
+  // Every labeling is a post order DFS over the DAG with its own random root and child order:
+  // label = [lowest rank reachable, own rank]
+  labels.resize((std::size_t)nrOfComponents * this->nrOfLabels);
+  std::mt19937 rng(nrOfComponents);
+  std::vector<int> roots(nrOfComponents);
+  std::vector<char> visited(nrOfComponents);
+  std::vector<std::pair<int, std::size_t>> stack;
+  for (int i = 0; i < this->nrOfLabels; ++i) {
+    for (int c = 0; c < nrOfComponents; ++c)
+      roots[c] = c;
+    std::shuffle(roots.begin(), roots.end(), rng);
+    std::fill(visited.begin(), visited.end(), 0);
+    const unsigned childSeed = rng();
+    int rank = 0;
+
+    for (int root : roots) {
+      if (visited[root])
+        continue;
+      visited[root] = 1;
+      stack.push_back({root, 0});
+      while (!stack.empty()) {
+        auto &[current, explored] = stack.back();
+        const auto &children = dagOut[current];
+        if (explored < children.size()) {
+          // start at a pseudo random child so that the labelings differ
+          const std::size_t offset = ((unsigned)current * 2654435761u ^ childSeed) % children.size();
+          const int child = children[(offset + explored++) % children.size()];
+          if (!visited[child]) {
+            visited[child] = 1;
+            stack.push_back({child, 0});
+          }
+          continue;
+        }
+        Interval &label = labels[(std::size_t)current * this->nrOfLabels + i];
+        label.high = rank++;
+        label.low = label.high;
+        for (int child : children)
+          label.low = std::min(label.low, labels[(std::size_t)child * this->nrOfLabels + i].low);
+        stack.pop_back();
+      }
+    }
+  }
+}
+
+
+/* Returns false if the labels prove that fromComponent cannot reach toComponent */
+bool ReachabilityIndex::labelsAllow(int fromComponent, int toComponent) const {
+  const Interval *fromLabels = &labels[(std::size_t)fromComponent * nrOfLabels];
+  const Interval *toLabels = &labels[(std::size_t)toComponent * nrOfLabels];
+  for (int i = 0; i < nrOfLabels; ++i)
+    if (toLabels[i].low < fromLabels[i].low || toLabels[i].high > fromLabels[i].high)
+      return false;
+  return true;
+}
+
+
+bool ReachabilityIndex::componentReaches(int fromComponent, int toComponent) const {
+  if (fromComponent == toComponent)
+    return true;
+  if (!labelsAllow(fromComponent, toComponent))
+    return false;
+
+  // The labels cannot rule it out: DFS that only enters components the labels do not exclude
+  thread_local std::vector<unsigned> seen;
+  thread_local unsigned stamp = 0;
+  if (seen.size() != dagOut.size() || ++stamp == 0) {
+    seen.assign(dagOut.size(), 0);
+    stamp = 1;
+  }
+  std::vector<int> stack{fromComponent};
+  seen[fromComponent] = stamp;
+  while (!stack.empty()) {
+    int current = stack.back();
+    stack.pop_back();
+    for (int next : dagOut[current]) {
+      if (next == toComponent)
+        return true;
+      if (seen[next] != stamp && labelsAllow(next, toComponent)) {
+        seen[next] = stamp;
+        stack.push_back(next);
+      }
+    }
+  }
+  return false;
+}
+
+
+/* Returns true if there is a walk from fromId to toId */
+bool ReachabilityIndex::reachable(const idT &fromId, const idT &toId) const {
+  return componentReaches(component[graph->getIndex(fromId)], component[graph->getIndex(toId)]);
+}
+
+
+bool ReachabilityIndex::insertEdge(const idT &fromId, const idT &toId) {
+  const int fromComponent = component[graph->getIndex(fromId)];
+  const int toComponent = component[graph->getIndex(toId)];
+  if (componentReaches(fromComponent, toComponent))
+    return true; // the reachability relation does not change
+  if (componentReaches(toComponent, fromComponent))
+    return false; // a new cycle merges components
+
+  dagOut[fromComponent].push_back(toComponent);
+  dagIn[toComponent].push_back(fromComponent);
+
+  // Every ancestor's labels have to keep containing the labels of everything it reaches now
+  for (int i = 0; i < nrOfLabels; ++i) {
+    const Interval added = labels[(std::size_t)toComponent * nrOfLabels + i];
+    std::queue<int> queue;
+    queue.push(fromComponent);
+    while (!queue.empty()) {
+      int current = queue.front();
+      queue.pop();
+      Interval &label = labels[(std::size_t)current * nrOfLabels + i];
+      if (label.low <= added.low && label.high >= added.high)
+        continue; // already wide enough, and so are its ancestors
+      label.low = std::min(label.low, added.low);
+      label.high = std::max(label.high, added.high);
+      for (int previous : dagIn[current])
+        queue.push(previous);
+    }
+  }
+  return true;
+}
+
+
+int ReachabilityIndex::getNrOfComponents() const {
+  return dagOut.size();
+}
+
+
+std::size_t ReachabilityIndex::getMemoryUsage() const {
+  std::size_t bytes = utils::vectorBytes(component) + utils::vectorBytes(labels);
+  for (const auto *dag : {&dagOut, &dagIn}) {
+    bytes += utils::vectorBytes(*dag);
+    for (const auto &successors : *dag)
+      bytes += utils::vectorBytes(successors);
+  }
+  return bytes;
+}
+
+} // namespace index
+} // namespace graph
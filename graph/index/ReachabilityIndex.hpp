@@ -0,0 +1,48 @@
+#pragma once
+#include "../compact/CompactGraph.hpp"
+#include <memory>
+#include <vector>
+
+namespace graph {
+namespace index {
+
+// Answers "can a reach b" on a directed graph.
+// The strongly connected components are condensed into a DAG and every component gets
+// GRAIL interval labels from a few randomized DFS traversals: if a reaches b then every
+// label of b is contained in the matching label of a. Most negative queries are answered
+// by the labels alone, the rest by a DFS on the DAG that prunes with the same labels.
+class ReachabilityIndex {
+private:
+  struct Interval {
+    int low;
+    int high;
+  };
+
+  std::shared_ptr<const compact::CompactGraph> graph;
+  std::vector<int> component;
+  int nrOfLabels;
+  std::vector<std::vector<int>> dagOut;
+  std::vector<std::vector<int>> dagIn;
+  std::vector<Interval> labels; // labels[c * nrOfLabels + i] is the i'th label of component c
+
+  bool labelsAllow(int fromComponent, int toComponent) const;
+  bool componentReaches(int fromComponent, int toComponent) const;
+
+public:
+  explicit ReachabilityIndex(std::shared_ptr<const compact::CompactGraph> graph, int nrOfLabels = 3);
+
+  bool reachable(const idT &fromId, const idT &toId) const;
+
+  // Updates the index after the edge was added to the graph (the vertex set must not have changed).
+  // Returns false if the edge merged strongly connected components, in which case the index is stale
+  // and has to be rebuilt.
+  bool insertEdge(const idT &fromId, const idT &toId);
+
+  int getNrOfComponents() const;
+
+  // Bytes held by the index, without the compact graph it shares
+  std::size_t getMemoryUsage() const;
+};
+
+} // namespace index
+} // namespace graph
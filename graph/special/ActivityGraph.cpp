@@ -13,7 +13,27 @@ GraphType ActivityGraph::getGraphType() const {
   return GraphType::Activity;
 }
 
+
+/* Returns a copy sharing the edge storage with this graph. The activities are copied: computeSchedule writes
+   to them, which must not show in the versions and branches that share this graph. */
+std::unique_ptr<Graph> ActivityGraph::clone() const {
+  auto copy = std::make_unique<ActivityGraph>(*this);
+  copy->replaceVertices([](const VertexSharedPtr &vertex) -> VertexSharedPtr {
+    return std::make_shared<Activity>(*std::dynamic_pointer_cast<Activity>(vertex));
+  });
+  return copy;
+}
+
 bool ActivityGraph::computeSchedule() {
+  // from scratch: the times of an earlier schedule would bound the new ones
+  for (const auto &[_, vertex] : *this) {
+    const auto activity = std::dynamic_pointer_cast<Activity>(vertex);
+    activity->setEarliestStart(0);
+    activity->setEarliestEnd(0);
+    activity->setLatestStart(0);
+    activity->setLatestEnd(0);
+  }
+
   // Topological sort using predecessor counters
   std::unordered_map<idT, int> inDegree;
   std::queue<idT> queue;
@@ -108,5 +128,30 @@ int ActivityGraph::getLatestStart(const idT& activityId) const {
   return std::dynamic_pointer_cast<Activity>(this->getVertex({activityId}))->getLatestStart();
 }
 
+
+utils::MemoryReport ActivityGraph::getMemoryUsage() const {
+  utils::MemoryReport report = DirectedGraph::getMemoryUsage();
+  std::size_t idBytes = 0;
+  for (const auto &id : sortedOrder)
+    idBytes += utils::stringHeapBytes(id);
+  report.add("schedule order", utils::vectorBytes(sortedOrder), sortedOrder.size());
+  report.add("id strings", idBytes);
+  return report;
+}
+
+
+utils::MemoryReport ActivityGraph::projectMemoryUsage(std::size_t nrOfActivities, std::size_t nrOfDependencies,
+                                                      std::size_t averageIdLength) {
+  // the start activity X precedes the activities without predecessors and the final one Y
+  // succeeds the ones without successors, at most one extra dependency per activity each
+  const std::size_t nrOfVertices = nrOfActivities + 2;
+  const std::size_t nrOfEdges = nrOfDependencies + 2 * nrOfActivities;
+  utils::MemoryReport report = DirectedGraph::projectMemoryUsage(nrOfVertices, nrOfEdges, averageIdLength,
+                                                                 utils::sharedObjectBytes<Activity>());
+  report.add("schedule order", utils::mallocChunkBytes(nrOfVertices * sizeof(idT)), nrOfVertices);
+  report.add("id strings", nrOfVertices * utils::stringHeapBytes(averageIdLength));
+  return report;
+}
+
 } // namespace special
 } // namespace graph
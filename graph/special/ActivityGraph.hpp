@@ -8,6 +8,7 @@ namespace special {
 class ActivityGraph : public DirectedGraph {
 public:
   GraphType getGraphType() const override;
+  std::unique_ptr<Graph> clone() const override;
 
   //must run first // TODO: consider auto running it with caching
   bool computeSchedule(); // returns false if cycle
@@ -16,6 +17,11 @@ public:
   std::vector<idT> getCriticalActivities() const;
   int getEarliestStart(const idT& activityId) const;
   int getLatestStart(const idT& activityId) const;
+
+  utils::MemoryReport getMemoryUsage() const override;
+  // nrOfActivities and nrOfDependencies as in the file, the start and final activities are added
+  static utils::MemoryReport projectMemoryUsage(std::size_t nrOfActivities, std::size_t nrOfDependencies,
+                                                std::size_t averageIdLength);
 private:
   std::vector<idT> sortedOrder;
   int totalProjectTime = 0;
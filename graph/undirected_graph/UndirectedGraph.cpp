@@ -1,67 +1,116 @@
 #include "UndirectedGraph.hpp"
+#include "../vertices/StringVertex.hpp"
+#include <algorithm>
 #include <stdexcept>
 
 namespace graph {
 
-// TODO: Modify the EdgeHash class such that for undirected the direction does not matter
-
+/* Returns every edge once, from the half edge that starts at its smaller end */
 std::vector<Edge> UndirectedGraph::getEdges() const {
   std::vector<Edge> edgesV;
-  for (const auto &edge : this->edges)
-    edgesV.push_back(edge);
+  edgesV.reserve(nrOfEdges);
+  for (const auto &[fromId, neighbors] : adjacency)
+    for (const auto &[toId, weight] : *neighbors)
+      if (fromId <= toId)
+        edgesV.push_back(Edge{fromId, toId, weight});
   return edgesV;
 }
 
 
+/* The offset of the cursor counts the half edges of its chunk, only the canonical ones count against limit.
+   A page that stops inside a neighbor list keeps the neighbor, the next one resumes there without walking the
+   list up to it (the lists of the high degree vertices are long). */
+std::size_t UndirectedGraph::visitEdges(EdgeCursor &cursor, std::size_t limit, const EdgeVisitor &visit) const {
+  std::size_t passed = 0;
+  for (; !cursor.atEnd && passed < limit; ++cursor.chunk, cursor.offset = 0, cursor.neighbor.clear()) {
+    if (cursor.chunk >= std::min(adjacency.getNrOfChunks(), cursor.endChunk)) {
+      cursor.atEnd = true;
+      break;
+    }
+    std::size_t position = 0; // of the half edge in the chunk
+    for (const auto &[fromId, neighbors] : adjacency.getChunk(cursor.chunk)) {
+      if (position + neighbors->size() <= cursor.offset) {
+        position += neighbors->size();
+        continue;
+      }
+      auto it = neighbors->begin();
+      if (position < cursor.offset) {
+        it = cursor.neighbor.empty() ? neighbors->end() : neighbors->find(cursor.neighbor);
+        if (it == neighbors->end()) // a cursor without its neighbor
+          it = std::next(neighbors->begin(), cursor.offset - position);
+        position = cursor.offset;
+      }
+      for (; it != neighbors->end(); ++it, ++position) {
+        if (fromId > it->first)
+          continue;
+        if (passed == limit) {
+          cursor.offset = position;
+          cursor.neighbor = it->first;
+          return passed;
+        }
+        if (visit)
+          visit(fromId, it->first, it->second);
+        ++passed;
+      }
+    }
+  }
+  return passed;
+}
+
+
+std::size_t UndirectedGraph::getNrOfEdgeChunks() const {
+  return adjacency.getNrOfChunks();
+}
+
+
 int UndirectedGraph::getEdgeWeight(const idT &fromId, const idT &toId) const {
   if (!isVertex(fromId))
     throw std::runtime_error("from is not in the graph");
   if (!isVertex(toId))
     throw std::runtime_error("to is not in the graph");
 
-  // the edge can go either way because the graph is undirected
-  if (!isEdge(fromId, toId) && !isEdge(toId, fromId))
+  // either half edge has the weight, the one of fromId is as good as the other
+  const auto &neighbors = *adjacency.at(fromId);
+  auto it = neighbors.find(toId);
+  if (it == neighbors.end())
     throw std::runtime_error("The edge does not exists");
-
-  auto edge_it = edges.find(Edge{fromId, toId});
-  if (edge_it == edges.end())
-    edge_it = edges.find(Edge{toId, fromId});
-  if (edge_it == edges.end())
-    throw std::runtime_error("The edge " + fromId + " -- " + toId + " does not exists in the edges set");
-
-  return (*edge_it).weight;
+  return it->second;
 }
 
 GraphType UndirectedGraph::getGraphType() const {
   return GraphType::Undirected;
 }
 
+std::unique_ptr<Graph> UndirectedGraph::clone() const {
+  return std::make_unique<UndirectedGraph>(*this);
+}
+
 bool UndirectedGraph::isVertex(const idT &id) const {
-  return adjacency.find(id) != adjacency.end();
+  return adjacency.contains(id);
 }
 
 bool UndirectedGraph::isEdge(const idT &fromId, const idT &toId) const {
-  return isVertex(fromId) && isVertex(toId) &&
-         adjacency.at(fromId).find(toId) != adjacency.at(fromId).end() &&
-         (edges.find({fromId, toId}) != edges.end() || edges.find({toId, fromId}) != edges.end());
+  auto it = adjacency.find(fromId);
+  return it != adjacency.end() && it->second->contains(toId);
 }
 
 void UndirectedGraph::addVertex(const VertexSharedPtr &v) {
   if (isVertex(v->getId()))
     throw std::runtime_error("Vertex Already added");
 
-  adjacency[v->getId()] = std::unordered_set<idT>();
+  adjacency.insert({v->getId(), {}});
   vertices.insert({v->getId(), v});
 }
 
 void UndirectedGraph::removeVertex(const idT &id) {
   if (!isVertex(id))
     throw std::runtime_error("Vertex not in the graph");
-  
-  auto adjacentToV = adjacency[id];
-  for (const auto &ver : adjacentToV) {
-    removeEdge(id, ver);
-  }
+
+  const auto &neighbors = *adjacency.at(id);
+  for (const auto &[neighborId, _] : neighbors)
+    if (neighborId != id)
+      adjacency.getMutable(neighborId).mutate().erase(id);
+  nrOfEdges -= neighbors.size();
   adjacency.erase(id);
   vertices.erase(id);
 }
@@ -74,9 +123,9 @@ void UndirectedGraph::addEdge(const idT &fromId, const idT &toId, int weight) {
   if (isEdge(fromId, toId))
     throw std::runtime_error("The edge already exists");
 
-  adjacency.at(fromId).insert(toId);
-  adjacency.at(toId).insert(fromId);
-  edges.insert(Edge{fromId, toId, weight});
+  adjacency.getMutable(fromId).mutate().emplace(toId, weight);
+  adjacency.getMutable(toId).mutate().emplace(fromId, weight); // a self loop has a single half edge
+  ++nrOfEdges;
 }
 
 void UndirectedGraph::removeEdge(const idT &fromId, const idT &toId) {
@@ -87,14 +136,9 @@ void UndirectedGraph::removeEdge(const idT &fromId, const idT &toId) {
   if (!isEdge(fromId, toId))
     throw std::runtime_error("The edge does not exist");
 
-  adjacency[fromId].erase(toId);
-  adjacency[toId].erase(fromId);
-  auto edge_it = edges.find(Edge{fromId, toId});
-  if (edge_it == edges.end())
-    edge_it = edges.find(Edge{toId, fromId});
-  if (edge_it == edges.end())
-    throw std::runtime_error("The edge " + fromId + " -- " + toId + " does not exists in the edges set");
-  edges.erase(edge_it);
+  adjacency.getMutable(fromId).mutate().erase(toId);
+  adjacency.getMutable(toId).mutate().erase(fromId);
+  --nrOfEdges;
 }
 
 const VertexSharedPtr &UndirectedGraph::getVertex(const idT &id) const {
@@ -108,23 +152,20 @@ int UndirectedGraph::getNrOfVertices() const {
 }
 
 int UndirectedGraph::getNrOfEdges() const {
-  int count = 0;
-  for (const auto &[_, neighbors] : adjacency) {
-    count += neighbors.size();
-  }
-  return count / 2;
+  return nrOfEdges;
 }
 
 void UndirectedGraph::clear() {
   adjacency.clear();
   vertices.clear();
+  nrOfEdges = 0;
 }
 
-std::unordered_map<idT, VertexSharedPtr>::const_iterator UndirectedGraph::begin() const {
+VertexMap::const_iterator UndirectedGraph::begin() const {
   return vertices.begin();
 }
 
-std::unordered_map<idT, VertexSharedPtr>::const_iterator UndirectedGraph::end() const {
+VertexMap::const_iterator UndirectedGraph::end() const {
   return vertices.end();
 }
 
@@ -133,13 +174,54 @@ AdjacentEdgesView UndirectedGraph::getAdjacentEdges(const idT &id) const {
   if (!isVertex(id))
     throw std::runtime_error("Vertex is not in the graph");
   AdjacentEdgesView view;
-  auto it = adjacency.find(id);
-  if (it != adjacency.end()) {
-      // Populate edges
-      for (const idT& toId : it->second)
-        view.addEdge(Edge{id, toId, getEdgeWeight(id, toId)});
-  }
+  for (const auto &[toId, weight] : *adjacency.at(id))
+    view.addEdge(Edge{id, toId, weight});
   return view;
 }
 
+
+/* Returns the number of neighbors of the given vertex (itself once for a loop) */
+int UndirectedGraph::getDegree(const idT &id) const {
+  if (!isVertex(id))
+    throw std::runtime_error("Vertex is not in the graph");
+  return adjacency.at(id)->size();
+}
+
+
+/* Returns the bytes held by the vertices and the neighbor maps */
+utils::MemoryReport UndirectedGraph::getMemoryUsage() const {
+  utils::MemoryReport report;
+  report.nrOfVertices = vertices.size();
+  report.nrOfEdges = nrOfEdges;
+  std::size_t idBytes = 0;
+  for (const auto &[id, vertex] : vertices) {
+    vertex->addMemoryUsage(report);
+    idBytes += utils::stringHeapBytes(id);
+  }
+  report.add("vertex map", vertices.size() * utils::hashNodeChunkBytes<VertexMap::value_type>(), vertices.size());
+  report.add("cow chunks", vertices.getChunkBytes());
+  report.add("id strings", idBytes);
+  report.add("hash buckets", utils::bucketArrayBytes(vertices));
+  utils::addAdjacencyUsage(report, "adjacency", adjacency);
+  return report;
+}
+
+
+/* Returns the bytes a graph with the given sizes will hold, laid out as in getMemoryUsage */
+utils::MemoryReport UndirectedGraph::projectMemoryUsage(std::size_t nrOfVertices, std::size_t nrOfEdges,
+                                                        std::size_t averageIdLength) {
+  utils::MemoryReport report;
+  report.nrOfVertices = nrOfVertices;
+  report.nrOfEdges = nrOfEdges;
+  const std::size_t idHeapBytes = utils::stringHeapBytes(averageIdLength);
+  report.add("vertex objects", nrOfVertices * utils::sharedObjectBytes<StringVertex>(), nrOfVertices);
+  report.add("vertex map", nrOfVertices * utils::hashNodeChunkBytes<VertexMap::value_type>(), nrOfVertices);
+  report.add("cow chunks", VertexMap::projectChunkBytes(nrOfVertices));
+  report.add("id strings", 2 * nrOfVertices * idHeapBytes);
+  report.add("hash buckets", utils::bucketArrayBytes(utils::projectedBucketCount(nrOfVertices)));
+  // every edge is a half edge in the neighbor map of both of its ends
+  utils::projectAdjacencyUsage<WeightedAdjacencyMap>(report, "adjacency", nrOfVertices, 2 * nrOfEdges, idHeapBytes);
+  return report;
+}
+
 } //namespace graph
@@ -6,16 +6,21 @@
 
 namespace graph {
 
-// TODO: Modify the EdgeHash class such that for undirected the direction does not matter
-
+// Every edge is kept as two half edges, one in the neighbor map of each end, with its weight.
+// An edge is found with a single probe whichever way it is given, and getEdges reports it once,
+// in its canonical orientation (the smaller id first).
 class UndirectedGraph : public Graph {
 private:
-  std::unordered_map<idT, std::unordered_set<idT>> adjacency;
-  std::unordered_map<idT, VertexSharedPtr> vertices;
-  std::unordered_set<Edge, EdgeHash> edges;
+  using NeighborMap = std::unordered_map<idT, int>; // neighbor -> weight of the edge
+  using WeightedAdjacencyMap = utils::CowHashTable<std::unordered_map<idT, utils::CowPtr<NeighborMap>>>;
+
+  WeightedAdjacencyMap adjacency;
+  VertexMap vertices;
+  int nrOfEdges = 0;
 
 public:
   GraphType getGraphType() const override;
+  std::unique_ptr<Graph> clone() const override;
 
   bool isVertex(const idT &id) const override;
   void addVertex(const VertexSharedPtr &v) override;
@@ -29,26 +34,26 @@ public:
   int getNrOfEdges() const override;
   int getEdgeWeight(const idT &fromId, const idT &to) const override;
   std::vector<Edge> getEdges() const override;
+  std::size_t visitEdges(EdgeCursor &cursor, std::size_t limit, const EdgeVisitor &visit) const override;
+  std::size_t getNrOfEdgeChunks() const override;
 
   void clear() override;
-  std::unordered_map<idT, VertexSharedPtr>::const_iterator begin() const override;
-  std::unordered_map<idT, VertexSharedPtr>::const_iterator end() const override;
+  VertexMap::const_iterator begin() const override;
+  VertexMap::const_iterator end() const override;
 
   UndirectedGraph() {}
-  UndirectedGraph(const UndirectedGraph &other) {
-    this->adjacency = other.adjacency;
-    this->vertices = other.vertices;
-  }
+  // Shares the storage of other (the tables are copy-on-write)
+  UndirectedGraph(const UndirectedGraph &other) = default;
 
   AdjacentEdgesView getAdjacentEdges(const idT &id) const override;
+  int getDegree(const idT &id) const;
+
+  utils::MemoryReport getMemoryUsage() const override;
+  // What a graph with these sizes will take, before it is built
+  static utils::MemoryReport projectMemoryUsage(std::size_t nrOfVertices, std::size_t nrOfEdges,
+                                                std::size_t averageIdLength);
 
-  UndirectedGraph &operator=(const UndirectedGraph &other) {
-    if (this != &other) {
-      this->adjacency = other.adjacency;
-      this->vertices = other.vertices;
-    }
-    return *this;
-  }
+  UndirectedGraph &operator=(const UndirectedGraph &other) = default;
 };
 
 } //namespace graph
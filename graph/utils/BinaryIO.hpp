@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <ios>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace graph {
+namespace utils {
+
+// Little helpers for the binary files the indexes are saved to.
+// Values are written in the native byte order, so the files are not portable between architectures.
+
+template <typename T>
+void writePod(std::ostream &out, const T &value) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+T readPod(std::istream &in) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  T value;
+  if (!in.read(reinterpret_cast<char *>(&value), sizeof(T)))
+    throw std::runtime_error("Unexpected end of file");
+  return value;
+}
+
+// Bytes left to read in the stream, UINT64_MAX when it cannot seek. A length prefix is checked against
+// it before anything is allocated, so a damaged file fails instead of asking for a huge buffer.
+inline std::uint64_t getRemainingBytes(std::istream &in) {
+  const std::istream::pos_type position = in.tellg();
+  if (position == std::istream::pos_type(-1) || !in.seekg(0, std::ios::end))
+    return UINT64_MAX;
+  const std::istream::pos_type end = in.tellg();
+  in.seekg(position);
+  return end == std::istream::pos_type(-1) || end < position ? UINT64_MAX : std::uint64_t(end - position);
+}
+
+inline void writeString(std::ostream &out, const std::string &value) {
+  writePod<std::uint32_t>(out, value.size());
+  out.write(value.data(), value.size());
+}
+
+inline std::string readString(std::istream &in) {
+  const std::uint32_t size = readPod<std::uint32_t>(in);
+  if (size > getRemainingBytes(in))
+    throw std::runtime_error("Unexpected end of file");
+  std::string value(size, '\0');
+  if (!in.read(value.data(), value.size()))
+    throw std::runtime_error("Unexpected end of file");
+  return value;
+}
+
+template <typename T>
+void writeVector(std::ostream &out, const std::vector<T> &values) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  writePod<std::uint64_t>(out, values.size());
+  out.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+}
+
+template <typename T>
+std::vector<T> readVector(std::istream &in) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  const std::uint64_t size = readPod<std::uint64_t>(in);
+  if (size > getRemainingBytes(in) / sizeof(T))
+    throw std::runtime_error("Unexpected end of file");
+  std::vector<T> values(size);
+  if (!in.read(reinterpret_cast<char *>(values.data()), values.size() * sizeof(T)))
+    throw std::runtime_error("Unexpected end of file");
+  return values;
+}
+
+} // namespace utils
+} // namespace graph
@@ -0,0 +1,280 @@
+#pragma once
+#include "MemoryUsage.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+namespace utils {
+
+// A value shared by its copies until one of them changes it.
+// The use count is only a hint while other threads drop their copies: a stale count makes
+// mutate copy a value nobody else holds any more, which is wasted work but never wrong.
+template <typename T>
+class CowPtr {
+public:
+  using element_type = T;
+
+  CowPtr() : ptr(std::make_shared<T>()) {}
+  explicit CowPtr(T value) : ptr(std::make_shared<T>(std::move(value))) {}
+
+  const T &operator*() const { return *ptr; }
+  const T *operator->() const { return ptr.get(); }
+
+  // The value, copied first if another CowPtr shares it
+  T &mutate() {
+    if (ptr.use_count() > 1)
+      ptr = std::make_shared<T>(std::as_const(*ptr));
+    return *ptr;
+  }
+
+private:
+  std::shared_ptr<T> ptr;
+};
+
+
+// A std::unordered_map or std::unordered_set split in chunks by the hash of the key, the chunks are
+// reached through a two level directory (pages of up to PAGE_SIZE chunk pointers).
+// Copies share the directory: a copy costs a pointer, and a change copies only the directory, the
+// page and the chunk on its way that are shared (about 16 bytes per page, 8 per chunk in the page
+// and the MAX_CHUNK_SIZE keys of the chunk), so the copies keep sharing everything else.
+template <typename Table>
+class CowHashTable {
+  using Page = std::vector<std::shared_ptr<Table>>;
+  using Directory = std::vector<std::shared_ptr<Page>>;
+
+public:
+  using chunk_type = Table;
+  using key_type = typename Table::key_type;
+  using value_type = typename Table::value_type;
+  static constexpr std::size_t MAX_CHUNK_SIZE = 64;
+  static constexpr int PAGE_BITS = 6;
+  static constexpr std::size_t PAGE_SIZE = std::size_t{1} << PAGE_BITS;
+
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename Table::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type *;
+    using reference = const value_type &;
+
+    const_iterator() = default;
+
+    reference operator*() const { return *it; }
+    pointer operator->() const { return &*it; }
+
+    const_iterator &operator++() {
+      ++it;
+      skipEmptyChunks();
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator previous = *this;
+      ++*this;
+      return previous;
+    }
+
+    bool operator==(const const_iterator &other) const {
+      return chunk == other.chunk && (table == nullptr || chunk == table->nrOfChunks || it == other.it);
+    }
+
+  private:
+    friend class CowHashTable;
+    const CowHashTable *table = nullptr;
+    std::size_t chunk = 0;
+    typename Table::const_iterator it;
+
+    const_iterator(const CowHashTable *table, std::size_t chunk, typename Table::const_iterator it)
+        : table(table), chunk(chunk), it(it) {}
+
+    void skipEmptyChunks() {
+      while (it == table->getChunk(chunk).cend() && ++chunk < table->nrOfChunks)
+        it = table->getChunk(chunk).cbegin();
+    }
+  };
+
+  std::size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+
+  const_iterator begin() const {
+    if (nrOfChunks == 0)
+      return end();
+    const_iterator first(this, 0, getChunk(0).cbegin());
+    first.skipEmptyChunks();
+    return first;
+  }
+
+  const_iterator end() const { return const_iterator(this, nrOfChunks, {}); }
+
+  const_iterator find(const key_type &key) const {
+    if (nrOfChunks == 0)
+      return end();
+    const std::size_t chunk = getChunkIndex(key);
+    auto it = getChunk(chunk).find(key);
+    return it == getChunk(chunk).cend() ? end() : const_iterator(this, chunk, it);
+  }
+
+  bool contains(const key_type &key) const { return find(key) != end(); }
+
+  const auto &at(const key_type &key) const
+    requires requires { typename Table::mapped_type; }
+  {
+    auto it = find(key);
+    if (it == end())
+      throw std::out_of_range("Key not in the table");
+    return it->second;
+  }
+
+  // The value of the key, for changing it in place; what leads to it is copied first when it is shared
+  auto &getMutable(const key_type &key)
+    requires requires { typename Table::mapped_type; }
+  {
+    if (!contains(key))
+      throw std::out_of_range("Key not in the table");
+    return getMutableChunk(getChunkIndex(key)).find(key)->second;
+  }
+
+  // Returns false (and changes nothing) if the key is already in the table
+  bool insert(value_type value) {
+    if (nrOfChunks == 0) {
+      directory = std::make_shared<Directory>(1, std::make_shared<Page>(1, std::make_shared<Table>()));
+      nrOfChunks = 1;
+    }
+    const std::size_t chunk = getChunkIndex(getKey(value));
+    if (getChunk(chunk).contains(getKey(value)))
+      return false;
+    getMutableChunk(chunk).insert(std::move(value));
+    if (++count > MAX_CHUNK_SIZE * nrOfChunks)
+      rehash(2 * nrOfChunks);
+    return true;
+  }
+
+  // Returns false if the key was not in the table
+  bool erase(const key_type &key) {
+    if (!contains(key))
+      return false;
+    getMutableChunk(getChunkIndex(key)).erase(key);
+    --count;
+    return true;
+  }
+
+  void clear() {
+    directory.reset();
+    nrOfChunks = 0;
+    chunkBits = 0;
+    count = 0;
+  }
+
+  std::size_t getNrOfChunks() const { return nrOfChunks; }
+
+  // The chunks partition the table, resumable enumerations (Graph::visitEdges) keep their position in chunks
+  const chunk_type &getChunk(std::size_t chunk) const {
+    return *(*(*directory)[chunk >> PAGE_BITS])[chunk & (PAGE_SIZE - 1)];
+  }
+
+  std::size_t bucket_count() const {
+    std::size_t buckets = 0;
+    for (std::size_t chunk = 0; chunk < nrOfChunks; ++chunk)
+      buckets += getChunk(chunk).bucket_count();
+    return buckets;
+  }
+
+  // The directory, the pages and the chunk objects (the hash tables inside the chunks are counted apart)
+  std::size_t getChunkBytes() const { return projectChunkBytes(count); }
+
+  // The same for a table of nrOfElements (the chunks split in two when they average MAX_CHUNK_SIZE keys)
+  static std::size_t projectChunkBytes(std::size_t nrOfElements) {
+    std::size_t chunks = nrOfElements == 0 ? 0 : 1;
+    while (nrOfElements > MAX_CHUNK_SIZE * chunks)
+      chunks *= 2;
+    const std::size_t pages = (chunks + PAGE_SIZE - 1) / PAGE_SIZE;
+    return sharedObjectBytes<Directory>() + mallocChunkBytes(pages * 2 * sizeof(void *)) +
+           pages * sharedObjectBytes<Page>() + pages * mallocChunkBytes(std::min(chunks, PAGE_SIZE) * 2 * sizeof(void *)) +
+           chunks * sharedObjectBytes<Table>();
+  }
+
+private:
+  std::shared_ptr<Directory> directory; // null while the table is empty
+  std::size_t nrOfChunks = 0; // a power of two
+  int chunkBits = 0;
+  std::size_t count = 0;
+
+  static const key_type &getKey(const value_type &value) {
+    if constexpr (requires { typename Table::mapped_type; })
+      return value.first;
+    else
+      return value;
+  }
+
+  static const key_type &getKey(const typename Table::node_type &node) {
+    if constexpr (requires { typename Table::mapped_type; })
+      return node.key();
+    else
+      return node.value();
+  }
+
+  // The top bits of the mixed hash, the tables inside the chunks use it modulo their (prime) bucket count
+  std::size_t getChunkIndex(const key_type &key) const {
+    if (chunkBits == 0)
+      return 0;
+    const std::uint64_t hash = (std::uint64_t)typename Table::hasher{}(key) * 0x9E3779B97F4A7C15ull;
+    return hash >> (64 - chunkBits);
+  }
+
+  template <typename T>
+  static void unshare(std::shared_ptr<T> &ptr) {
+    if (ptr.use_count() > 1)
+      ptr = std::make_shared<T>(std::as_const(*ptr));
+  }
+
+  Table &getMutableChunk(std::size_t chunk) {
+    unshare(directory);
+    auto &page = (*directory)[chunk >> PAGE_BITS];
+    unshare(page);
+    auto &table = (*page)[chunk & (PAGE_SIZE - 1)];
+    unshare(table);
+    return *table;
+  }
+
+  // Moves the nodes of the chunks only this table holds, copies the values of the shared ones
+  void rehash(std::size_t chunks) {
+    auto rehashed = std::make_shared<Directory>((chunks + PAGE_SIZE - 1) / PAGE_SIZE);
+    for (auto &page : *rehashed) {
+      page = std::make_shared<Page>(std::min(chunks, PAGE_SIZE));
+      for (auto &table : *page)
+        table = std::make_shared<Table>();
+    }
+    auto getRehashedChunk = [&](const key_type &key) -> Table & {
+      const std::size_t chunk = getChunkIndex(key);
+      return *(*(*rehashed)[chunk >> PAGE_BITS])[chunk & (PAGE_SIZE - 1)];
+    };
+
+    const std::shared_ptr<Directory> old = std::move(directory);
+    const bool ownsDirectory = old.use_count() == 1;
+    chunkBits = std::countr_zero(chunks);
+    for (auto &page : *old)
+      for (auto &table : *page) {
+        if (ownsDirectory && page.use_count() == 1 && table.use_count() == 1)
+          while (!table->empty()) {
+            auto node = table->extract(table->begin());
+            Table &target = getRehashedChunk(getKey(node));
+            target.insert(std::move(node));
+          }
+        else
+          for (const auto &value : *table)
+            getRehashedChunk(getKey(value)).insert(value);
+      }
+    directory = std::move(rehashed);
+    nrOfChunks = chunks;
+  }
+};
+
+} // namespace utils
+} // namespace graph
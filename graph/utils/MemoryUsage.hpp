@@ -0,0 +1,188 @@
+#pragma once
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace graph {
+namespace utils {
+
+// Byte estimates for the standard containers, modelled on libstdc++ on 64 bit Linux:
+// every allocation is a malloc chunk (8 byte header, 16 byte alignment, at least 32 bytes),
+// std::string keeps up to 15 characters inline, hash table nodes hold the next pointer and,
+// for std::string keys, the cached hash.
+inline std::size_t mallocChunkBytes(std::size_t bytes) {
+  if (bytes == 0)
+    return 0;
+  return std::max<std::size_t>(32, (bytes + 8 + 15) & ~std::size_t{15});
+}
+
+inline std::size_t stringHeapBytes(std::size_t capacity) {
+  return capacity <= 15 ? 0 : mallocChunkBytes(capacity + 1);
+}
+
+inline std::size_t stringHeapBytes(const std::string &s) {
+  return stringHeapBytes(s.capacity());
+}
+
+template <typename Value, bool cachedHash = true>
+constexpr std::size_t hashNodeBytes() {
+  return sizeof(void *) + sizeof(Value) + (cachedHash ? sizeof(std::size_t) : 0);
+}
+
+template <typename Value, bool cachedHash = true>
+std::size_t hashNodeChunkBytes() {
+  return mallocChunkBytes(hashNodeBytes<Value, cachedHash>());
+}
+
+// The bucket array of a hash table (a table with a single bucket keeps it inline)
+inline std::size_t bucketArrayBytes(std::size_t bucketCount) {
+  return bucketCount <= 1 ? 0 : mallocChunkBytes(bucketCount * sizeof(void *));
+}
+
+template <typename HashContainer>
+std::size_t bucketArrayBytes(const HashContainer &container) {
+  return bucketArrayBytes(container.bucket_count());
+}
+
+// Tables grow to the next prime after twice their size, so with n elements there are between n and 2n buckets
+inline std::size_t projectedBucketCount(std::size_t nrOfElements) {
+  return nrOfElements == 0 ? 1 : nrOfElements + nrOfElements / 2;
+}
+
+template <typename T>
+std::size_t vectorBytes(const std::vector<T> &v) {
+  return mallocChunkBytes(v.capacity() * sizeof(T));
+}
+
+// An object created by std::make_shared: the control block (two counters and a vtable) next to the object
+template <typename T>
+std::size_t sharedObjectBytes() {
+  return mallocChunkBytes(2 * sizeof(int) + sizeof(void *) + sizeof(T));
+}
+
+
+// Where the bytes of a data structure go, one entry per kind of allocation
+class MemoryReport {
+public:
+  struct Entry {
+    std::string name;
+    std::size_t bytes = 0;
+    std::size_t count = 0; // how many objects the bytes are spread over (0 if not meaningful)
+  };
+
+  std::size_t nrOfVertices = 0;
+  std::size_t nrOfEdges = 0;
+
+  void add(const std::string &name, std::size_t bytes, std::size_t count = 0) {
+    for (auto &entry : entries)
+      if (entry.name == name) {
+        entry.bytes += bytes;
+        entry.count += count;
+        return;
+      }
+    entries.push_back({name, bytes, count});
+  }
+
+  // Adds the entries of other, named "prefix: name"
+  void add(const std::string &prefix, const MemoryReport &other) {
+    for (const auto &entry : other.entries)
+      add(prefix + ": " + entry.name, entry.bytes, entry.count);
+  }
+
+  const std::vector<Entry> &getEntries() const { return entries; }
+
+  std::size_t getTotalBytes() const {
+    std::size_t total = 0;
+    for (const auto &entry : entries)
+      total += entry.bytes;
+    return total;
+  }
+
+  double getBytesPerVertex() const { return nrOfVertices == 0 ? 0 : (double)getTotalBytes() / nrOfVertices; }
+  double getBytesPerEdge() const { return nrOfEdges == 0 ? 0 : (double)getTotalBytes() / nrOfEdges; }
+
+  // 512 B, 1.5 KB, 3.25 MB, 1.10 GB
+  static std::string formatBytes(double bytes) {
+    static const char *units[] = {"B", "KB", "MB", "GB", "TB"};
+    int unit = 0;
+    while (bytes >= 1024 && unit < 4) {
+      bytes /= 1024;
+      ++unit;
+    }
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), unit == 0 ? "%.0f %s" : "%.2f %s", bytes, units[unit]);
+    return buffer;
+  }
+
+  std::string toString() const {
+    const std::size_t total = getTotalBytes();
+    char line[160];
+    std::string output;
+    for (const auto &entry : entries) {
+      std::snprintf(line, sizeof(line), "%-40s %12s %6.1f%%", entry.name.c_str(), formatBytes(entry.bytes).c_str(),
+                    total == 0 ? 0.0 : 100.0 * entry.bytes / total);
+      output += line;
+      if (entry.count > 0) {
+        std::snprintf(line, sizeof(line), "  (%zu x %.1f B)", entry.count, (double)entry.bytes / entry.count);
+        output += line;
+      }
+      output += "\n";
+    }
+    std::snprintf(line, sizeof(line), "%-40s %12s\n%zu vertices, %zu edges: %.1f bytes per vertex, %.1f bytes per edge",
+                  "total", formatBytes(total).c_str(), nrOfVertices, nrOfEdges, getBytesPerVertex(), getBytesPerEdge());
+    return output + line;
+  }
+
+private:
+  std::vector<Entry> entries;
+};
+
+
+// Adds a chunked map of id -> shared hash set of ids, or hash map of id -> weight (the adjacency of the
+// graph classes): the nodes of the map and of the sets under name, the chunks and set objects under "cow chunks", their bucket arrays
+// under "hash buckets", their keys under "id strings"
+template <typename AdjacencyMap>
+void addAdjacencyUsage(MemoryReport &report, const std::string &name, const AdjacencyMap &adjacency) {
+  using Set = typename AdjacencyMap::value_type::second_type::element_type;
+  std::size_t nodeBytes = adjacency.size() * hashNodeChunkBytes<typename AdjacencyMap::value_type>();
+  std::size_t nrOfNodes = adjacency.size();
+  std::size_t buckets = bucketArrayBytes(adjacency.bucket_count());
+  std::size_t idBytes = 0;
+  for (const auto &[id, neighbors] : adjacency) {
+    idBytes += stringHeapBytes(id);
+    nodeBytes += neighbors->size() * hashNodeChunkBytes<typename Set::value_type>();
+    nrOfNodes += neighbors->size();
+    buckets += bucketArrayBytes(*neighbors);
+    for (const auto &neighbor : *neighbors) {
+      if constexpr (requires { typename Set::mapped_type; })
+        idBytes += stringHeapBytes(neighbor.first);
+      else
+        idBytes += stringHeapBytes(neighbor);
+    }
+  }
+  report.add(name, nodeBytes, nrOfNodes);
+  report.add("cow chunks", adjacency.getChunkBytes() + adjacency.size() * sharedObjectBytes<Set>());
+  report.add("id strings", idBytes);
+  report.add("hash buckets", buckets);
+}
+
+// Projection of the same for nrOfKeys keys that hold nrOfElements ids in total
+template <typename AdjacencyMap>
+void projectAdjacencyUsage(MemoryReport &report, const std::string &name, std::size_t nrOfKeys,
+                           std::size_t nrOfElements, std::size_t idHeapBytes) {
+  using Set = typename AdjacencyMap::value_type::second_type::element_type;
+  report.add(name,
+             nrOfKeys * hashNodeChunkBytes<typename AdjacencyMap::value_type>() +
+                 nrOfElements * hashNodeChunkBytes<typename Set::value_type>(),
+             nrOfKeys + nrOfElements);
+  report.add("cow chunks", AdjacencyMap::projectChunkBytes(nrOfKeys) + nrOfKeys * sharedObjectBytes<Set>());
+  report.add("id strings", (nrOfKeys + nrOfElements) * idHeapBytes);
+  std::size_t buckets = bucketArrayBytes(projectedBucketCount(nrOfKeys));
+  if (nrOfKeys > 0 && nrOfElements > 0)
+    buckets += nrOfKeys * bucketArrayBytes(projectedBucketCount((nrOfElements + nrOfKeys - 1) / nrOfKeys));
+  report.add("hash buckets", buckets);
+}
+
+} // namespace utils
+} // namespace graph
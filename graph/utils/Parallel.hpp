@@ -0,0 +1,72 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace graph {
+namespace utils {
+
+inline std::atomic<unsigned> threadCountOverride{0};
+
+// Number of worker threads used when the caller does not specify one
+inline unsigned defaultThreadCount() {
+  if (unsigned count = threadCountOverride.load(std::memory_order_relaxed))
+    return count;
+  unsigned count = std::thread::hardware_concurrency();
+  return count == 0 ? 1 : count;
+}
+
+// Overrides the hardware concurrency as the default (0 restores it)
+inline void setDefaultThreadCount(unsigned nrThreads) {
+  threadCountOverride.store(nrThreads, std::memory_order_relaxed);
+}
+
+// Runs fn(threadIndex) on nrThreads threads and waits for all of them.
+// The first exception thrown by a worker is rethrown in the caller.
+template <typename Fn>
+void runParallel(unsigned nrThreads, Fn &&fn) {
+  if (nrThreads <= 1) {
+    fn(0u);
+    return;
+  }
+
+  std::vector<std::thread> workers;
+  std::vector<std::exception_ptr> errors(nrThreads);
+  workers.reserve(nrThreads - 1);
+  for (unsigned t = 1; t < nrThreads; ++t) {
+    workers.emplace_back([&, t]() {
+      try {
+        fn(t);
+      } catch (...) {
+        errors[t] = std::current_exception();
+      }
+    });
+  }
+  try {
+    fn(0u);
+  } catch (...) {
+    errors[0] = std::current_exception();
+  }
+  for (auto &worker : workers)
+    worker.join();
+  for (const auto &error : errors)
+    if (error)
+      std::rethrow_exception(error);
+}
+
+// Splits [0, size) into nrThreads contiguous ranges and runs fn(threadIndex, begin, end) on each
+template <typename Fn>
+void parallelForRange(std::size_t size, unsigned nrThreads, Fn &&fn) {
+  nrThreads = std::max(1u, std::min<unsigned>(nrThreads, size == 0 ? 1 : size));
+  std::size_t chunk = (size + nrThreads - 1) / nrThreads;
+  runParallel(nrThreads, [&](unsigned t) {
+    std::size_t begin = std::min(size, t * chunk);
+    std::size_t end = std::min(size, begin + chunk);
+    fn(t, begin, end);
+  });
+}
+
+} // namespace utils
+} // namespace graph
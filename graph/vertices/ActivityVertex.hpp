@@ -40,6 +40,12 @@ public:
   int getLatestEnd() const { return latestEnd; }
   void setLatestEnd(int newLatestEnd) { latestEnd = newLatestEnd; }
 
+  void addMemoryUsage(utils::MemoryReport &report) const override {
+    report.add("vertex objects", utils::sharedObjectBytes<Activity>(), 1);
+    report.add("id strings", utils::stringHeapBytes(id));
+    report.add("activity names", utils::stringHeapBytes(name));
+  }
+
   std::string toString() const override {
     std::string displayableName = name.empty() ? "" : std::format(" name: {}", name);
     return std::format("{}{} (duration: {}, earliestStart: {}, latestStart: {}, earliestEnd: {}, latestEnd: {})",
@@ -1,4 +1,5 @@
 #pragma once
+#include "../utils/MemoryUsage.hpp"
 #include <string>
 #include <memory>
 
@@ -13,6 +14,9 @@ public:
 
   [[ nodiscard ]] virtual std::string toString() const = 0;
 
+  // Adds the heap bytes of the vertex (as created by std::make_shared) and of its strings
+  virtual void addMemoryUsage(utils::MemoryReport &report) const = 0;
+
   bool operator==(const BaseVertex &other) const {
     return getId() == other.getId();
   }
@@ -16,6 +16,11 @@ public:
   std::string toString() const override {
     return id;
   }
+
+  void addMemoryUsage(utils::MemoryReport &report) const override {
+    report.add("vertex objects", utils::sharedObjectBytes<StringVertex>(), 1);
+    report.add("id strings", utils::stringHeapBytes(id));
+  }
 };
 
 }
@@ -1,15 +1,114 @@
 // #include "graph/DirectedGraph.hpp"
 // #include "graph/UndirectedGraph.hpp"
 #include "ui/Console.hpp"
+#include "ui/CommandServer.hpp"
 #include "controller/CommandController.hpp"
 #include "service/GraphService.hpp"
+#include "graph/distributed/BspEngine.hpp"
 #include <assert.h>
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
 
 
-int main() {
+static int usage(const char *program) {
+  std::cerr << "Usage: " << program << " [--script <file_path>|--batch|--listen <address>] [--threads <count>] [--timing]"
+            << " [--keep-going] [--stats-json <file_path>]\n"
+            << "  --script <file_path>  runs the commands of the file without prompts (- reads them from stdin)\n"
+            << "  --batch               same as --script -\n"
+            << "  --listen <address>    serves the commands on unix:<socket_path> or tcp:<port> (localhost)\n"
+            << "  --threads <count>     number of threads of the parallel algorithms and of the server (default: all the cores)\n"
+            << "  --timing              reports the latency of every command on stderr\n"
+            << "  --keep-going          runs the rest of the script after a command failed\n"
+            << "  --stats-json <path>   writes the command statistics as JSON on exit\n"
+            << "  (--shard-worker <shard_file> <control_fd> <peer_fds> is how run_partitioned starts its workers)\n";
+  return 2;
+}
+
+
+// --shard-worker <shard_file> <control_fd> <peer_fds>: a worker of run_partitioned, started by the coordinator
+// with the sockets already open; peer_fds lists the socket of every shard, -1 for its own
+static int runShardWorker(char **argv) {
+  std::vector<int> peerFds;
+  std::string peers = argv[4];
+  for (std::size_t start = 0; start <= peers.size();) {
+    const std::size_t end = std::min(peers.find(',', start), peers.size());
+    peerFds.push_back(std::atoi(peers.substr(start, end - start).c_str()));
+    start = end + 1;
+  }
+  return graph::distributed::runShardWorker(argv[2], std::atoi(argv[3]), peerFds);
+}
+
+
+int main(int argc, char **argv) {
+  if (argc == 5 && std::string(argv[1]) == "--shard-worker")
+    return runShardWorker(argv);
+  std::string statsJsonPath;
+  std::string scriptPath;
+  std::string listenAddress;
+  BatchOptions batchOptions;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "--stats-json" && i + 1 < argc) {
+      statsJsonPath = argv[++i];
+    } else if (arg == "--script" && i + 1 < argc) {
+      scriptPath = argv[++i];
+    } else if (arg == "--listen" && i + 1 < argc) {
+      listenAddress = argv[++i];
+    } else if (arg == "--batch") {
+      scriptPath = "-";
+    } else if (arg == "--threads" && i + 1 < argc) {
+      const int nrThreads = std::atoi(argv[++i]);
+      if (nrThreads <= 0)
+        return usage(argv[0]);
+      graph::utils::setDefaultThreadCount(nrThreads);
+    } else if (arg == "--timing") {
+      batchOptions.timing = true;
+    } else if (arg == "--keep-going") {
+      batchOptions.keepGoing = true;
+    } else {
+      return usage(argv[0]);
+    }
+  }
+
   Console console; 
   GraphService service;
   CommandController controller(console, service);
-  console.startConsoleLoop();
-  return 0;
+  int status;
+  if (!listenAddress.empty()) {
+    try {
+      CommandServer server(console, listenAddress, graph::utils::defaultThreadCount());
+      std::signal(SIGINT, [](int) { CommandServer::requestStop(); });
+      std::signal(SIGTERM, [](int) { CommandServer::requestStop(); });
+      status = server.run();
+    } catch (std::runtime_error &e) {
+      std::cerr << e.what() << '\n';
+      return 1;
+    }
+  } else if (scriptPath.empty()) {
+    status = console.startConsoleLoop();
+  } else {
+    // the output is only flushed when the buffer fills up, at errors and at the end
+    std::ios::sync_with_stdio(false);
+    std::cin.tie(nullptr);
+    static char outputBuffer[1 << 16];
+    std::cout.rdbuf()->pubsetbuf(outputBuffer, sizeof(outputBuffer));
+    if (scriptPath == "-") {
+      status = console.runScript(std::cin, std::cout, batchOptions);
+    } else {
+      std::ifstream script(scriptPath);
+      if (!script.is_open()) {
+        std::cerr << "Could not open script '" << scriptPath << "'\n";
+        return 1;
+      }
+      status = console.runScript(script, std::cout, batchOptions);
+    }
+  }
+  if (!statsJsonPath.empty())
+    console.getStats().saveJson(statsJsonPath);
+  return status;
 }
@@ -6,71 +6,272 @@
 #include "../graph/special/ActivityGraph.hpp"
 #include "../graph/algorithms/UndirectedGraphAlgorithms.hpp"
 #include "../graph/algorithms/DirectedGraphAlgorithms.hpp"
+#include "../graph/algorithms/GenericAlgorithms.hpp"
+#include "../graph/core/Adapters.hpp"
 #include "../graph/special/ActivityGraph.hpp"
 #include "../graph/abstract/Graph.hpp"
 #include "../graph/vertices/StringVertex.hpp"
 #include "../graph/vertices/ActivityVertex.hpp"
 #include "../graph/undirected_graph/UndirectedGraph.hpp"
+#include "../graph/utils/Parallel.hpp"
 #include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <fstream>
 #include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
 #include <iostream>
 #include <vector>
+#include <sstream>
+#include <string_view>
+#include <unordered_map>
+#include <format>
+#include <unistd.h>
+
+// "Cycle detected: a -> b -> a", used when an algorithm needs a DAG
+static std::string describeCycle(const graph::DirectedGraph &g) {
+  std::string description = "Cycle detected";
+  auto cycles = graph::algorithms::findCycles(g);
+  if (cycles.empty())
+    return description + "!";
+  description += ": ";
+  for (const auto &vertexId : cycles.front())
+    description += vertexId + " -> ";
+  return description + cycles.front().front();
+}
+
+
+// The weakly connected components of a read only copy of a directed graph (compressed or mapped), by id
+template <typename ReadOnlyGraph>
+static std::vector<std::vector<graph::idT>> getWeakComponents(const ReadOnlyGraph &g) {
+  const auto adapted = graph::core::adapt(g);
+  std::vector<std::vector<graph::idT>> components;
+  for (const auto &vertices : graph::algorithms::connectedComponents(graph::core::UndirectedView(adapted))) {
+    components.emplace_back();
+    for (int vertex : vertices)
+      components.back().emplace_back(g.getId(vertex));
+  }
+  return components;
+}
+
+
+// Dijkstra on a read only copy of a directed graph, whose weights are not negative
+template <typename ReadOnlyGraph>
+static graph::index::PathQueryResult findCheapestWalk(const ReadOnlyGraph &g, const graph::idT &startId,
+                                                      const graph::idT &endId) {
+  const int start = g.getIndex(startId), end = g.getIndex(endId);
+  const auto paths = graph::algorithms::dijkstra(graph::core::adapt(g), start, end);
+  graph::index::PathQueryResult result;
+  for (int vertex : paths.getPath(end))
+    result.path.emplace_back(g.getId(vertex));
+  if (!result.path.empty())
+    result.cost = paths.distance[end];
+  return result;
+}
+
+
+GraphService::GraphService(std::unique_ptr<graph::Graph> graph) {
+  auto version = std::make_shared<GraphVersion>();
+  version->graph = std::move(graph);
+  publish(std::move(version));
+}
+
+
+GraphService::~GraphService() {
+  std::lock_guard<std::mutex> lock(checkpointThreadMutex);
+  if (checkpointThread.joinable())
+    checkpointThread.join();
+}
+
+
+GraphSnapshot GraphService::snapshot() const {
+  std::lock_guard<std::mutex> lock(versionMutex);
+  return GraphSnapshot(latest);
+}
+
+
+void GraphService::forkBranch(const std::string &name) {
+  std::lock_guard<std::mutex> lock(writeMutex);
+  requireNoLog("fork a branch");
+  if (name == currentBranch || branches.count(name) > 0)
+    throw std::runtime_error("Branch " + name + " already exists");
+  branches.emplace(currentBranch, latest);
+  currentBranch = name;
+}
+
+
+/* Keeps the latest version of the branch it leaves, the snapshots taken before go on reading the old branch */
+void GraphService::switchBranch(const std::string &name) {
+  std::lock_guard<std::mutex> lock(writeMutex);
+  if (name == currentBranch)
+    return;
+  requireNoLog("switch branches");
+  auto branch = branches.find(name);
+  if (branch == branches.end())
+    throw std::runtime_error("There is no branch " + name);
+  std::shared_ptr<const GraphVersion> head = std::move(branch->second);
+  branches.erase(branch);
+  branches.emplace(currentBranch, latest);
+  currentBranch = name;
+  std::lock_guard<std::mutex> versionLock(versionMutex);
+  std::swap(latest, head);
+}
+
+
+void GraphService::discardBranch(const std::string &name) {
+  std::shared_ptr<const GraphVersion> head; // released after the lock
+  std::lock_guard<std::mutex> lock(writeMutex);
+  if (name == currentBranch)
+    throw std::runtime_error("Cannot discard the current branch, switch to another one first");
+  auto branch = branches.find(name);
+  if (branch == branches.end())
+    throw std::runtime_error("There is no branch " + name);
+  head = std::move(branch->second);
+  branches.erase(branch);
+}
+
+
+std::vector<GraphService::BranchInfo> GraphService::getBranches() {
+  std::lock_guard<std::mutex> lock(writeMutex);
+  std::vector<BranchInfo> result;
+  auto describe = [&](const std::string &name, const GraphVersion &version, bool current) {
+    if (version.mappedGraph)
+      result.push_back({name, version.number, version.mappedGraph->getNrOfVertices(),
+                        (int)version.mappedGraph->getNrOfEdges(), current});
+    else
+      result.push_back({name, version.number, version.graph->getNrOfVertices(), version.graph->getNrOfEdges(), current});
+  };
+  describe(currentBranch, *latest, true);
+  for (const auto &[name, version] : branches)
+    describe(name, *version, false);
+  std::sort(result.begin(), result.end(), [](const auto &a, const auto &b) { return a.name < b.name; });
+  return result;
+}
+
+
+std::string GraphService::getCurrentBranch() {
+  std::lock_guard<std::mutex> lock(writeMutex);
+  return currentBranch;
+}
+
 
 graph::GraphType GraphService::getGraphType() const {
-  return graph->getGraphType();
+  return snapshot().getGraphType();
 }
 
 void GraphService::addVertex(const graph::VertexSharedPtr &vertex) {
-  graph->addVertex(vertex);
+  update([&](graph::Graph &graph) { graph.addVertex(vertex); },
+         {MutationLog::RecordType::AddVertex, vertex->getId(), {}});
 }
 
 
 void GraphService::removeVertex(const graph::idT &vertexId) {
-  graph->removeVertex(vertexId);
+  update([&](graph::Graph &graph) { graph.removeVertex(vertexId); }, {MutationLog::RecordType::RemoveVertex, vertexId, {}});
 }
 
 
 bool GraphService::isVertex(const graph::idT &vertexId) {
-  return graph->isVertex(vertexId);
+  const auto pinned = snapshot();
+  if (auto mapped = pinned.getMappedGraph())
+    return mapped->isVertex(vertexId);
+  return pinned.getGraph().isVertex(vertexId);
 }
   
 
 void GraphService::addEdge(const graph::idT &fromVertexId, const graph::idT &toVertexId, int weight) {
+  std::shared_ptr<MutationLog> log;
+  std::uint64_t lsn = 0;
+  std::unique_lock<std::mutex> lock(writeMutex);
+  requireInMemory(*latest);
+  auto graph = latest->graph->clone();
   graph->addEdge(fromVertexId, toVertexId, weight);
+  auto version = std::make_shared<GraphVersion>();
+  version->graph = std::move(graph);
+
+  // The vertex set did not change, so the reachability index can take the new edge. The old version gives
+  // it up, unless another branch starts from it; it is changed in place if no reader is using it (the
+  // readers only get it under cacheMutex).
+  const bool branchHead = std::any_of(branches.begin(), branches.end(),
+                                      [&](const auto &branch) { return branch.second == latest; });
+  std::shared_ptr<graph::index::ReachabilityIndex> reachability;
+  {
+    std::lock_guard<std::mutex> cacheLock(latest->cacheMutex);
+    reachability = branchHead ? latest->reachabilityIndex : std::move(latest->reachabilityIndex);
+  }
+  if (reachability && reachability.use_count() > 1)
+    reachability = std::make_shared<graph::index::ReachabilityIndex>(*reachability);
+  if (reachability && reachability->insertEdge(fromVertexId, toVertexId))
+    version->reachabilityIndex = std::move(reachability);
+  if ((log = mutationLog))
+    lsn = log->append({MutationLog::RecordType::AddEdge, fromVertexId, toVertexId, weight});
+  publish(std::move(version));
+  lock.unlock();
+  if (log)
+    commitChange(log, lsn);
 }
 
 
 void GraphService::removeEdge(const graph::idT &fromVertexId, const graph::idT &toVertexId) {
-  graph->removeEdge(fromVertexId, toVertexId);
+  update([&](graph::Graph &graph) { graph.removeEdge(fromVertexId, toVertexId); },
+         {MutationLog::RecordType::RemoveEdge, fromVertexId, toVertexId});
 }
 
 
 bool GraphService::isEdge(const graph::idT &fromVertexId, const graph::idT &toVertexId) {
-  return graph->isEdge(fromVertexId, toVertexId);
+  const auto pinned = snapshot();
+  if (auto mapped = pinned.getMappedGraph())
+    return mapped->isVertex(fromVertexId) && mapped->isVertex(toVertexId) &&
+           mapped->isEdge(mapped->getIndex(fromVertexId), mapped->getIndex(toVertexId));
+  return pinned.getGraph().isEdge(fromVertexId, toVertexId);
 }
 
 
 std::vector<graph::VertexSharedPtr> GraphService::getVertices() {
+  const auto pinned = snapshot();
   std::vector<graph::VertexSharedPtr> vertices;
-  for (const auto& [_, vertexPtr] : *graph) {
+  for (const auto& [_, vertexPtr] : pinned.getGraph()) {
     vertices.push_back(vertexPtr);
   }
   return vertices; 
 }
 
 
+// The outbound or inbound edges of a vertex of the mapped graph
+static std::vector<graph::Edge> getMappedEdges(const graph::compact::MappedGraph &mapped, const graph::idT &vertexId,
+                                               bool outbound) {
+  const int vertex = mapped.getIndex(vertexId);
+  std::vector<graph::Edge> edges;
+  if (outbound)
+    mapped.forEachOutEdge(vertex, [&](int to, int weight) {
+      edges.emplace_back(vertexId, graph::idT(mapped.getId(to)), weight);
+    });
+  else
+    mapped.forEachInEdge(vertex, [&](int from, int weight) {
+      edges.emplace_back(graph::idT(mapped.getId(from)), vertexId, weight);
+    });
+  return edges;
+}
+
+
 std::vector<graph::Edge> GraphService::getAdjacentEdges(const graph::idT &vertexId) const {
-  return graph->getAdjacentEdges(vertexId).getAll();
+  const auto pinned = snapshot();
+  if (auto mapped = pinned.getMappedGraph())
+    return getMappedEdges(*mapped, vertexId, true);
+  return pinned.getGraph().getAdjacentEdges(vertexId).getAll();
 }
 
 
 std::vector<graph::Edge> GraphService::getOutboundEdges(const graph::idT &vertexId) const {
-  if (graph->getGraphType() != graph::GraphType::Directed)
+  const auto pinned = snapshot();
+  if (pinned.getGraphType() != graph::GraphType::Directed)
     throw InvalidOperationOnGraphType("Outbound Vertices are defined only for Directed graphs");
-  auto *directed = dynamic_cast<graph::DirectedGraph*>(graph.get());
+  if (auto mapped = pinned.getMappedGraph())
+    return getMappedEdges(*mapped, vertexId, true);
+  auto *directed = dynamic_cast<const graph::DirectedGraph*>(&pinned.getGraph());
   std::vector<graph::Edge> edges;
   for (const graph::Edge& edge : directed->initOutboundEdgesIt(vertexId)) {
     edges.push_back(edge);
@@ -80,9 +281,12 @@ std::vector<graph::Edge> GraphService::getOutboundEdges(const graph::idT &vertex
 
 
 std::vector<graph::Edge> GraphService::getInboundEdges(const graph::idT &vertexId) const { 
-  if (graph->getGraphType() != graph::GraphType::Directed)
+  const auto pinned = snapshot();
+  if (pinned.getGraphType() != graph::GraphType::Directed)
     throw InvalidOperationOnGraphType("Inbound Vertices are defined only for Directed graphs");
-  auto *directed = dynamic_cast<graph::DirectedGraph*>(graph.get());
+  if (auto mapped = pinned.getMappedGraph())
+    return getMappedEdges(*mapped, vertexId, false);
+  auto *directed = dynamic_cast<const graph::DirectedGraph*>(&pinned.getGraph());
   std::vector<graph::Edge> edges;
   for (const graph::Edge& edge : directed->initInboundEdgesIt(vertexId)) {
     edges.push_back(edge);
@@ -92,15 +296,92 @@ std::vector<graph::Edge> GraphService::getInboundEdges(const graph::idT &vertexI
 
 
 std::vector<graph::Edge> GraphService::getEdges() {
-  return graph->getEdges();
+  return snapshot().getGraph().getEdges();
 }
 
+
+/* The token is <version>.<chunk>.<offset>[.<neighbor>], the position of the cursor in that version */
+GraphService::EdgePage GraphService::visitEdges(
+    const std::string &token, std::size_t offset, std::size_t limit, const EdgeVisitorFactory &makeVisitor) const {
+  std::shared_ptr<const GraphVersion> version;
+  graph::EdgeCursor cursor;
+  if (token.empty())
+    version = snapshot().version;
+  else {
+    std::uint64_t number = 0;
+    const char *position = token.data(), *end = token.data() + token.size();
+    auto parse = [&](auto &value, bool last) {
+      auto [next, error] = std::from_chars(position, end, value);
+      if (error != std::errc() || (last ? next != end && *next != '.' : next == end || *next != '.'))
+        throw std::runtime_error("Invalid continuation token '" + token + "'");
+      position = next + 1;
+    };
+    parse(number, false);
+    parse(cursor.chunk, false);
+    parse(cursor.offset, true);
+    if (position < end)
+      cursor.neighbor.assign(position, end);
+    std::lock_guard<std::mutex> lock(pagingMutex);
+    for (const auto &paged : pagedVersions)
+      if (paged->number == number)
+        version = paged;
+    if (!version)
+      throw std::runtime_error("The listing of token '" + token + "' expired, start it again");
+  }
+
+  // the mapped graph lists its edges by source vertex, in the order of the file
+  const graph::compact::MappedGraph *mapped = version->mappedGraph.get();
+  auto visit = [&](graph::EdgeCursor &at, std::size_t count, const graph::EdgeVisitor &visitor) {
+    return mapped ? mapped->visitEdges(at, count, visitor) : version->graph->visitEdges(at, count, visitor);
+  };
+  std::optional<graph::compact::MappedGraph::SequentialScan> scan;
+  if (mapped)
+    scan.emplace(*mapped);
+
+  cursor.atEnd = false;
+  visit(cursor, offset, {});
+  EdgePage page{0, ""};
+  page.nrOfEdges = visit(cursor, limit == 0 ? SIZE_MAX : limit,
+                         makeVisitor(version->graph->getGraphType(),
+                                     mapped ? mapped->getNrOfEdges() : version->graph->getNrOfEdges()));
+  graph::EdgeCursor probe = cursor;
+  if (visit(probe, 1, {}) == 0)
+    return page;
+
+  page.nextToken = std::format("{}.{}.{}", version->number, cursor.chunk, cursor.offset);
+  if (!cursor.neighbor.empty())
+    page.nextToken += "." + cursor.neighbor;
+  std::shared_ptr<const GraphVersion> evicted; // released after the lock
+  std::lock_guard<std::mutex> lock(pagingMutex);
+  pagedVersions.remove(version);
+  pagedVersions.push_front(version);
+  if (pagedVersions.size() > MAX_PAGED_VERSIONS) {
+    evicted = std::move(pagedVersions.back());
+    pagedVersions.pop_back();
+  }
+  return page;
+}
+
+/* Reads the graph next to the current one, which the queries keep using until the new one is published */
 void GraphService::loadGraph(const std::string &path, const std::string &graphType) {
+  if (graphType == "mapped") {
+    auto version = std::make_shared<GraphVersion>();
+    version->graph = std::make_shared<graph::DirectedGraph>();
+    version->mappedGraph = std::make_shared<const graph::compact::MappedGraph>(path);
+    std::lock_guard<std::mutex> lock(writeMutex);
+    requireNoLog("load a graph");
+    publish(std::move(version));
+    return;
+  }
   std::ifstream fin(path);
   if (!fin.is_open())
     throw std::runtime_error("Could not open file '" + path + "' for reading");
+  std::lock_guard<std::mutex> lock(writeMutex);
+  requireNoLog("load a graph");
+  checkMemoryBudget(projectLoadMemoryUsage(path, graphType));
 
   //chose the graph type
+  std::shared_ptr<graph::Graph> graph;
   if (graphType == "undirected") {
     graph = std::make_shared<graph::UndirectedGraph>();
   } else if (graphType == "directed") {
@@ -110,7 +391,6 @@ void GraphService::loadGraph(const std::string &path, const std::string &graphTy
   } else {
     throw std::runtime_error("'" + graphType + "' is not a valid graph type");
   }
-  graph->clear();
 
   // custom split function
   auto split = [](const std::string &str, const std::string &separator = " ") -> std::vector<std::string> {
@@ -256,91 +536,846 @@ void GraphService::loadGraph(const std::string &path, const std::string &graphTy
 
     } while (std::getline(fin, line) && (firstLine = split(line), !line.empty()));
   }
+
+  auto version = std::make_shared<GraphVersion>();
+  version->graph = graph;
+  // indexes saved next to the graph are picked up if they were built for this graph
+  if (graph->getGraphType() == graph::GraphType::Directed && std::ifstream(path + ".alt").good()) {
+    try {
+      version->altIndex =
+          std::make_shared<graph::index::AltIndex>(GraphSnapshot(version).getCompactGraph(), path + ".alt");
+    } catch (std::runtime_error &) {} // stale index, the graph file changed since
+  }
+  if (graph->getGraphType() == graph::GraphType::Directed && std::ifstream(path + ".ch").good()) {
+    try {
+      version->contractionHierarchy = std::make_shared<graph::index::ContractionHierarchy>(
+          GraphSnapshot(version).getCompactGraph(), path + ".ch");
+    } catch (std::runtime_error &) {}
+  }
+  publish(std::move(version));
 }
 
 
-void GraphService::saveGraph(const std::string& path) const {
-  std::ofstream fout(path);
-  if (!fout.is_open())
+// The generated graph for graphType, without self loops and duplicate edges
+static graph::generators::GeneratedGraph generateSimpleGraph(const std::string &graphType, const std::string &model,
+                                                             const std::vector<long long> &parameters,
+                                                             graph::generators::GeneratorOptions options) {
+  if (graphType != "directed" && graphType != "undirected" && graphType != "activity")
+    throw std::runtime_error("'" + graphType + "' is not a valid graph type");
+  if (graphType == "activity" && model != "layered_dag")
+    throw std::runtime_error("Activity networks can only be generated with the layered_dag model");
+  options.directed = graphType != "undirected";
+  auto generated = graph::generators::generate(model, parameters, options);
+  graph::generators::simplify(generated, options.nrThreads);
+  return generated;
+}
+
+
+std::size_t GraphService::generateGraph(const std::string &graphType, const std::string &model,
+                                        const std::vector<long long> &parameters,
+                                        const graph::generators::GeneratorOptions &options) {
+  auto generated = generateSimpleGraph(graphType, model, parameters, options);
+  std::lock_guard<std::mutex> lock(writeMutex);
+  requireNoLog("generate a graph");
+  checkMemoryBudget(projectMemoryUsage(graphType, generated.nrOfVertices, generated.edges.size(),
+                                       std::to_string(generated.nrOfVertices).size()));
+  auto version = std::make_shared<GraphVersion>();
+  if (graphType == "undirected") {
+    auto undirected = std::make_shared<graph::UndirectedGraph>();
+    graph::generators::fillGraph(generated, *undirected);
+    version->graph = undirected;
+  } else if (graphType == "directed") {
+    auto directed = std::make_shared<graph::DirectedGraph>();
+    graph::generators::fillGraph(generated, *directed);
+    version->graph = directed;
+  } else {
+    auto activityGraph = std::make_shared<graph::special::ActivityGraph>();
+    graph::generators::fillGraph(generated, *activityGraph);
+    version->graph = activityGraph;
+  }
+  publish(std::move(version));
+  return generated.edges.size();
+}
+
+
+std::size_t GraphService::generateGraphFile(const std::string &path, const std::string &graphType, const std::string &model,
+                                            const std::vector<long long> &parameters,
+                                            graph::generators::GeneratorOptions options) {
+  auto generated = generateSimpleGraph(graphType, model, parameters, options);
+  graph::generators::writeGraph(generated, path, graphType == "activity", options.nrThreads);
+  return generated.edges.size();
+}
+
+
+// Appends the decimal digits of value
+static void appendNumber(std::string &buffer, long long value) {
+  char digits[24];
+  auto [end, _] = std::to_chars(digits, digits + sizeof(digits), value);
+  buffer.append(digits, end);
+}
+
+
+static void writeBuffer(std::FILE *fout, const std::string &buffer, const std::string &path) {
+  if (std::fwrite(buffer.data(), 1, buffer.size(), fout) != buffer.size()) {
+    std::fclose(fout);
+    throw std::runtime_error("Could not write to '" + path + "'");
+  }
+}
+
+
+/* Every round each thread formats the next itemsPerRun items with format(buffer, first, last) into its own buffer,
+   then the buffers are written out in order */
+template <typename Format>
+static void writeInRounds(std::FILE *fout, const std::string &path, std::size_t nrOfItems, std::size_t itemsPerRun,
+                          unsigned nrThreads, Format &&format) {
+  std::vector<std::string> buffers(nrThreads);
+  for (std::size_t roundStart = 0; roundStart < nrOfItems; roundStart += itemsPerRun * nrThreads) {
+    graph::utils::runParallel(nrThreads, [&](unsigned t) {
+      buffers[t].clear();
+      const std::size_t first = std::min(nrOfItems, roundStart + t * itemsPerRun);
+      format(buffers[t], first, std::min(nrOfItems, first + itemsPerRun));
+    });
+    for (const auto &buffer : buffers)
+      writeBuffer(fout, buffer, path);
+  }
+}
+
+
+/* The lines are formatted in parallel with to_chars, by runs of vertices of a mapped graph and by runs of the
+   chunks of the edge table of a graph in memory (visitEdges lists an undirected edge once). The isolated
+   vertices get a line of their own, except under a header, which implies the vertices 0..n-1. */
+void GraphService::saveGraph(const std::string &path, bool withHeader) const {
+  const auto pinned = snapshot();
+  if (!pinned.getMappedGraph() && pinned.getGraphType() == graph::GraphType::Activity)
+    throw std::runtime_error("Activity graphs cannot be saved");
+  std::FILE *fout = std::fopen(path.c_str(), "w");
+  if (fout == nullptr)
     throw std::runtime_error("Could not open file '" + path + "' for writing");
+  const unsigned nrThreads = graph::utils::defaultThreadCount();
+  std::string header;
 
-  if (graph->getGraphType() == graph::GraphType::Directed) {
-    auto *directed = dynamic_cast<graph::DirectedGraph*>(graph.get());
-    for (const auto &[fromId, _] : *directed) {
-      for (const auto &[__, to, cost] : directed->initOutboundEdgesIt(fromId))
-          fout << fromId << " " << to << " " << cost << "\n";
+  if (auto mapped = pinned.getMappedGraph()) {
+    const graph::compact::MappedGraph::SequentialScan scan(*mapped);
+    if (withHeader) {
+      appendNumber(header, mapped->getNrOfVertices());
+      header += ' ';
+      appendNumber(header, mapped->getNrOfEdges());
+      header += '\n';
+      writeBuffer(fout, header, path);
     }
-    for (const auto& [vertexId, _] : *directed) {
-      auto outEdges = directed->initOutboundEdgesIt(vertexId);
-      auto inEdges = directed->initInboundEdgesIt(vertexId);
-
-      if (outEdges.begin() == outEdges.end() && inEdges.begin() == inEdges.end()) {
-        fout << vertexId << "\n";
+    constexpr std::size_t VERTICES_PER_RUN = 1 << 14;
+    writeInRounds(fout, path, mapped->getNrOfVertices(), VERTICES_PER_RUN, nrThreads,
+                  [&](std::string &buffer, std::size_t first, std::size_t last) {
+      for (int v = first; v < (int)last; ++v) {
+        if (!withHeader && mapped->getOutNeighbors(v).empty() && mapped->getInNeighbors(v).empty()) {
+          buffer += mapped->getId(v);
+          buffer += '\n';
+        }
+        mapped->forEachOutEdge(v, [&](int to, int cost) {
+          if (withHeader) {
+            appendNumber(buffer, v);
+            buffer += ' ';
+            appendNumber(buffer, to);
+          } else {
+            buffer += mapped->getId(v);
+            buffer += ' ';
+            buffer += mapped->getId(to);
+          }
+          buffer += ' ';
+          appendNumber(buffer, cost);
+          buffer += '\n';
+        });
       }
+    });
+  } else {
+    const graph::Graph &g = pinned.getGraph();
+    // the vertex numbers under a header, in the order of the vertex table
+    std::unordered_map<std::string_view, int> numbers;
+    if (withHeader) {
+      numbers.reserve(g.getNrOfVertices());
+      for (const auto &[vertexId, _] : g)
+        numbers.emplace(vertexId, numbers.size());
+      appendNumber(header, g.getNrOfVertices());
+      header += ' ';
+      appendNumber(header, g.getNrOfEdges());
+      header += '\n';
+      writeBuffer(fout, header, path);
     }
-  }
+    constexpr std::size_t CHUNKS_PER_RUN = 1 << 12; // of up to CowHashTable::MAX_CHUNK_SIZE entries
+    writeInRounds(fout, path, g.getNrOfEdgeChunks(), CHUNKS_PER_RUN, nrThreads,
+                  [&](std::string &buffer, std::size_t first, std::size_t last) {
+      graph::EdgeCursor cursor;
+      cursor.chunk = first;
+      cursor.endChunk = last;
+      g.visitEdges(cursor, SIZE_MAX, [&](const graph::idT &fromId, const graph::idT &toId, int cost) {
+        if (withHeader) {
+          appendNumber(buffer, numbers.find(fromId)->second);
+          buffer += ' ';
+          appendNumber(buffer, numbers.find(toId)->second);
+        } else {
+          buffer += fromId;
+          buffer += ' ';
+          buffer += toId;
+        }
+        buffer += ' ';
+        appendNumber(buffer, cost);
+        buffer += '\n';
+      });
+    });
 
-  else if (graph->getGraphType() == graph::GraphType::Undirected) {
-    auto *undirected = dynamic_cast<graph::UndirectedGraph*>(graph.get());
-    for (const auto &[vertexId, _] : *undirected) {
-      auto adjacentEdges = undirected->getAdjacentEdges(vertexId);
-      if (adjacentEdges.empty())
-        fout << vertexId << "\n";
-      else for (const auto &edge : adjacentEdges) {
-          fout << edge.fromId << " " << edge.toId << " " << edge.weight << "\n";
-      }
+    if (!withHeader) {
+      std::string isolated;
+      auto *directed = dynamic_cast<const graph::DirectedGraph *>(&g);
+      auto *undirected = dynamic_cast<const graph::UndirectedGraph *>(&g);
+      for (const auto &[vertexId, _] : g)
+        if (directed ? directed->getOutDegree(vertexId) == 0 && directed->getInDegree(vertexId) == 0
+                     : undirected->getDegree(vertexId) == 0) {
+          isolated += vertexId;
+          isolated += '\n';
+        }
+      writeBuffer(fout, isolated, path);
     }
+    // the indexes travel with the graph
+    if (auto altIndex = pinned.getAltIndex())
+      altIndex->save(path + ".alt");
+    if (auto contractionHierarchy = pinned.getContractionHierarchy())
+      contractionHierarchy->save(path + ".ch");
   }
-  fout.close();
+  if (std::fclose(fout) != 0)
+    throw std::runtime_error("Could not write to '" + path + "'");
 }
 
 
-std::vector<graph::UndirectedGraph> GraphService::getConnectedComponentsOfUnorderedGraph() const {
-  if (graph->getGraphType() != graph::GraphType::Undirected)
-    throw std::runtime_error("getConnectedComponentsOfUndirectedGraph is only available for undirected graphs");
-  auto undirected = dynamic_cast<graph::UndirectedGraph*>(graph.get());
-  return graph::algorithms::getConnectedComponentsDFS(*undirected);
+void GraphService::saveMappedGraph(const std::string &path) const {
+  const auto pinned = snapshot();
+  if (auto mapped = pinned.getMappedGraph())
+    throw std::runtime_error("The graph is mapped from '" + mapped->getPath() + "' already");
+  if (pinned.getGraphType() != graph::GraphType::Directed)
+    throw std::runtime_error("Only directed graphs can be mapped");
+  graph::compact::MappedGraph::save(dynamic_cast<const graph::DirectedGraph &>(pinned.getGraph()), path);
+}
+
+
+std::vector<std::vector<graph::idT>> GraphService::getConnectedComponentsOfUnorderedGraph() const {
+  const auto pinned = snapshot();
+  // weakly connected components
+  if (auto mapped = pinned.getMappedGraph()) {
+    const graph::compact::MappedGraph::SequentialScan scan(*mapped);
+    return getWeakComponents(*mapped);
+  }
+  if (auto compressed = pinned.getCompressedGraph())
+    return getWeakComponents(*compressed);
+  if (pinned.getGraphType() != graph::GraphType::Undirected)
+    throw std::runtime_error("getConnectedComponentsOfUndirectedGraph is only available for undirected "
+                             "(or compressed or mapped) graphs");
+  auto undirected = dynamic_cast<const graph::UndirectedGraph*>(&pinned.getGraph());
+  return graph::algorithms::getConnectedComponentVertices(*undirected);
 }
 
 
 std::pair<std::vector<graph::idT>, int> GraphService::getLowestCostWalk(const graph::idT &startId, const graph::idT &endId) const {
-  if (graph->getGraphType() != graph::GraphType::Directed)
+  auto result = findLowestCostWalk(startId, endId);
+  if (result.path.empty())
+    return {};
+  return {result.path, result.cost};
+}
+
+
+graph::index::PathQueryResult GraphService::findLowestCostWalk(const graph::idT &startId, const graph::idT &endId) const {
+  const auto pinned = snapshot();
+  if (pinned.getGraphType() != graph::GraphType::Directed)
     throw std::runtime_error("getLowestCostWalk is only available for directed graphs");
-  auto directed = dynamic_cast<graph::DirectedGraph*>(graph.get());
-  return graph::algorithms::getLowestCostWalk(*directed, startId, endId);
+  if (auto mapped = pinned.getMappedGraph()) {
+    if (mapped->getMinEdgeWeight() < 0)
+      throw std::runtime_error("The mapped graph has negative weights, getLowestCostWalk needs it in memory");
+    return findCheapestWalk(*mapped, startId, endId);
+  }
+  if (auto contractionHierarchy = pinned.getContractionHierarchy())
+    return contractionHierarchy->findShortestPath(startId, endId);
+  if (auto altIndex = pinned.getAltIndex())
+    return altIndex->findShortestPath(startId, endId);
+
+  if (auto compressed = pinned.getCompressedGraph(); compressed && compressed->getMinEdgeWeight() >= 0)
+    return findCheapestWalk(*compressed, startId, endId);
+
+  auto directed = dynamic_cast<const graph::DirectedGraph*>(&pinned.getGraph());
+  auto [path, cost] = graph::algorithms::getLowestCostWalk(*directed, startId, endId);
+  return {path, cost};
+}
+
+
+graph::utils::MemoryReport GraphService::compressGraph() {
+  std::lock_guard<std::mutex> lock(writeMutex);
+  requireInMemory(*latest);
+  if (latest->graph->getGraphType() != graph::GraphType::Directed)
+    throw std::runtime_error("Only directed graphs can be compressed");
+  auto version = deriveVersion(*latest);
+  version->compressedGraph = std::make_shared<graph::compact::CompressedGraph>(
+      dynamic_cast<const graph::DirectedGraph &>(*latest->graph));
+  auto report = version->compressedGraph->getMemoryUsage();
+  publish(std::move(version));
+  return report;
+}
+
+
+std::pair<graph::compact::LocalityMetrics, graph::compact::LocalityMetrics> GraphService::reorderGraph(
+    const std::string &order) {
+  const auto vertexOrder = graph::compact::parseVertexOrder(order);
+  std::lock_guard<std::mutex> lock(writeMutex);
+  requireInMemory(*latest);
+  if (latest->graph->getGraphType() != graph::GraphType::Directed)
+    throw std::runtime_error("Only directed graphs have a compact representation");
+  const auto current = GraphSnapshot(latest).getCompactGraph();
+  // the new numbering is computed from the current one, whatever it is
+  std::shared_ptr<const graph::compact::CompactGraph> reordered;
+  if (vertexOrder == graph::compact::VertexOrder::Insertion)
+    reordered = std::make_shared<const graph::compact::CompactGraph>(
+        dynamic_cast<const graph::DirectedGraph &>(*latest->graph));
+  else
+    reordered = std::make_shared<const graph::compact::CompactGraph>(
+        *current, graph::compact::computeVertexOrder(*current, vertexOrder));
+
+  auto version = deriveVersion(*latest);
+  version->compactGraph = reordered;
+  version->reachabilityIndex = nullptr; // it would keep the old compact graph alive
+  this->vertexOrder = vertexOrder;
+  publish(std::move(version));
+  return {graph::compact::measureLocality(*current), graph::compact::measureLocality(*reordered)};
+}
+
+
+void GraphService::buildAltIndex(int nrLandmarks, const std::string &selection) {
+  std::lock_guard<std::mutex> lock(writeMutex);
+  if (latest->graph->getGraphType() != graph::GraphType::Directed)
+    throw std::runtime_error("The ALT index is only available for directed graphs");
+  graph::index::LandmarkSelection landmarkSelection;
+  if (selection == "avoid")
+    landmarkSelection = graph::index::LandmarkSelection::Avoid;
+  else if (selection == "farthest")
+    landmarkSelection = graph::index::LandmarkSelection::Farthest;
+  else
+    throw std::runtime_error("'" + selection + "' is not a landmark selection (farthest or avoid)");
+  // the queries keep running on the latest version while the index is built
+  auto version = deriveVersion(*latest);
+  version->altIndex = std::make_shared<graph::index::AltIndex>(GraphSnapshot(latest).getCompactGraph(), nrLandmarks,
+                                                               landmarkSelection);
+  publish(std::move(version));
+}
+
+
+void GraphService::saveAltIndex(const std::string &path) const {
+  auto altIndex = snapshot().getAltIndex();
+  if (!altIndex)
+    throw std::runtime_error("There is no ALT index to save");
+  altIndex->save(path);
+}
+
+
+void GraphService::loadAltIndex(const std::string &path) {
+  std::lock_guard<std::mutex> lock(writeMutex);
+  if (latest->graph->getGraphType() != graph::GraphType::Directed)
+    throw std::runtime_error("The ALT index is only available for directed graphs");
+  auto version = deriveVersion(*latest);
+  version->altIndex = std::make_shared<graph::index::AltIndex>(GraphSnapshot(latest).getCompactGraph(), path);
+  publish(std::move(version));
+}
+
+
+bool GraphService::hasAltIndex() const {
+  return snapshot().getAltIndex() != nullptr;
+}
+
+
+void GraphService::buildContractionHierarchy() {
+  std::lock_guard<std::mutex> lock(writeMutex);
+  if (latest->graph->getGraphType() != graph::GraphType::Directed)
+    throw std::runtime_error("Contraction hierarchies are only available for directed graphs");
+  auto version = deriveVersion(*latest);
+  version->contractionHierarchy =
+      std::make_shared<graph::index::ContractionHierarchy>(GraphSnapshot(latest).getCompactGraph());
+  publish(std::move(version));
+}
+
+
+void GraphService::saveContractionHierarchy(const std::string &path) const {
+  auto contractionHierarchy = snapshot().getContractionHierarchy();
+  if (!contractionHierarchy)
+    throw std::runtime_error("There is no contraction hierarchy to save");
+  contractionHierarchy->save(path);
+}
+
+
+void GraphService::loadContractionHierarchy(const std::string &path) {
+  std::lock_guard<std::mutex> lock(writeMutex);
+  if (latest->graph->getGraphType() != graph::GraphType::Directed)
+    throw std::runtime_error("Contraction hierarchies are only available for directed graphs");
+  auto version = deriveVersion(*latest);
+  version->contractionHierarchy =
+      std::make_shared<graph::index::ContractionHierarchy>(GraphSnapshot(latest).getCompactGraph(), path);
+  publish(std::move(version));
+}
+
+
+MutationLog::Recovery GraphService::openLog(const std::string &directory, MutationLog::Options options) {
+  std::lock_guard<std::mutex> lock(writeMutex);
+  if (mutationLog)
+    throw std::runtime_error("The changes are logged to '" + mutationLog->getDirectory() + "' already");
+  std::filesystem::create_directories(directory);
+  MutationLog::Recovery recovery;
+  if (auto recovered = MutationLog::recover(directory, recovery)) {
+    auto version = std::make_shared<GraphVersion>();
+    version->graph = std::move(recovered);
+    publish(std::move(version));
+  } else {
+    requireInMemory(*latest);
+    MutationLog::writeCheckpoint(directory, *latest->graph, 0);
+  }
+  mutationLog = std::make_shared<MutationLog>(directory, recovery.lastLsn, options);
+  return recovery;
+}
+
+
+/* The log is synced when its last user lets it go, after a checkpoint in progress */
+void GraphService::closeLog() {
+  std::shared_ptr<MutationLog> log;
+  {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    if (!mutationLog)
+      throw std::runtime_error("No mutation log is open");
+    log = std::move(mutationLog);
+  }
+  std::lock_guard<std::mutex> lock(checkpointThreadMutex);
+  if (checkpointThread.joinable())
+    checkpointThread.join();
+  log->sync();
+}
+
+
+std::uint64_t GraphService::checkpoint() {
+  std::shared_ptr<MutationLog> log;
+  {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    if (!mutationLog)
+      throw std::runtime_error("No mutation log is open");
+    log = mutationLog;
+  }
+  return writeCheckpoint(log);
+}
+
+
+/* The segment is switched under writeMutex, so the latest version is the graph after the last record of the
+   closed segments; the graph is written outside of it, the writers go on appending to the new segment */
+std::uint64_t GraphService::writeCheckpoint(const std::shared_ptr<MutationLog> &log) {
+  std::lock_guard<std::mutex> checkpointLock(checkpointMutex);
+  std::shared_ptr<const GraphVersion> version;
+  MutationLog::Rotation rotation;
+  {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    version = latest;
+    rotation = log->rotate();
+  }
+  MutationLog::writeCheckpoint(log->getDirectory(), *version->graph, rotation.lastLsn);
+  log->dropSegmentsBefore(rotation.segment);
+  return rotation.lastLsn;
+}
+
+
+MutationLog::Stats GraphService::getLogStats() {
+  std::lock_guard<std::mutex> lock(writeMutex);
+  if (!mutationLog)
+    throw std::runtime_error("No mutation log is open");
+  return mutationLog->getStats();
+}
+
+
+bool GraphService::canReach(const graph::idT &fromId, const graph::idT &toId) {
+  const auto pinned = snapshot();
+  if (pinned.getGraphType() != graph::GraphType::Directed)
+    throw std::runtime_error("canReach is only available for directed graphs");
+  return pinned.getReachabilityIndex()->reachable(fromId, toId);
+}
+
+
+std::size_t GraphService::getNrOfShortcuts() const {
+  auto contractionHierarchy = snapshot().getContractionHierarchy();
+  if (!contractionHierarchy)
+    throw std::runtime_error("There is no contraction hierarchy");
+  return contractionHierarchy->getNrOfShortcuts();
 }
 
 
 std::vector<graph::idT> GraphService::topologicalSort() const {
-  if (graph->getGraphType() != graph::GraphType::Directed) 
+  const auto pinned = snapshot();
+  if (pinned.getGraphType() != graph::GraphType::Directed) 
     throw std::runtime_error("topologicalSort is only available for directed graphs");
-  auto directed = dynamic_cast<graph::DirectedGraph*>(graph.get());
-  return graph::algorithms::getTopologicalOrder(*directed);
+  if (auto mapped = pinned.getMappedGraph())
+    throw std::runtime_error("topologicalSort is not available for the graph mapped from '" + mapped->getPath() + "'");
+  auto directed = dynamic_cast<const graph::DirectedGraph*>(&pinned.getGraph());
+  auto order = graph::algorithms::getTopologicalOrder(*directed);
+  if (order.empty() && directed->getNrOfVertices() != 0)
+    throw std::runtime_error(describeCycle(*directed));
+  return order;
 }
 
 
-int GraphService::getTotalProjectTime() {
-  if (graph->getGraphType() != graph::GraphType::Activity) 
-    throw std::runtime_error("getToatalProjectTime is only available for ActivityGraph");
-  const auto &activityGraph = std::dynamic_pointer_cast<graph::special::ActivityGraph>(graph);
+std::vector<std::vector<graph::idT>> GraphService::getStronglyConnectedComponents(bool parallel) const {
+  const auto pinned = snapshot();
+  if (pinned.getGraphType() != graph::GraphType::Directed)
+    throw std::runtime_error("getStronglyConnectedComponents is only available for directed graphs");
+  auto compact = pinned.getCompactGraph();
+  auto scc = parallel ? graph::algorithms::getStronglyConnectedComponentsParallel(*compact)
+                      : graph::algorithms::getStronglyConnectedComponents(*compact);
+  std::vector<std::vector<graph::idT>> components(scc.nrOfComponents);
+  for (int v = 0; v < compact->getNrOfVertices(); ++v)
+    components[scc.component[v]].push_back(compact->getId(v));
+  return components;
+}
+
+
+void GraphService::saveCondensation(const std::string &path, bool parallel) const {
+  const auto pinned = snapshot();
+  if (pinned.getGraphType() != graph::GraphType::Directed)
+    throw std::runtime_error("saveCondensation is only available for directed graphs");
+  auto compact = pinned.getCompactGraph();
+  auto scc = parallel ? graph::algorithms::getStronglyConnectedComponentsParallel(*compact)
+                      : graph::algorithms::getStronglyConnectedComponents(*compact);
+  GraphService(std::make_unique<graph::DirectedGraph>(graph::algorithms::getCondensation(*compact, scc))).saveGraph(path);
+}
+
+
+graph::algorithms::ShortestPathTree GraphService::getShortestPathTree(const graph::idT &sourceId, int delta) const {
+  const auto pinned = snapshot();
+  if (pinned.getGraphType() != graph::GraphType::Directed)
+    throw std::runtime_error("getShortestPathTree is only available for directed graphs");
+  auto compact = pinned.getCompactGraph();
+  return graph::algorithms::deltaSteppingShortestPaths(*compact, compact->getIndex(sourceId), delta);
+}
+
+
+void GraphService::saveShortestPathTree(const graph::idT &sourceId, const std::string &path, int delta) const {
+  auto tree = getShortestPathTree(sourceId, delta);
+  std::ofstream fout(path);
+  if (!fout.is_open())
+    throw std::runtime_error("Could not open file '" + path + "' for writing");
+
+  // one line per vertex: id distance parent ('inf' and '-' when the vertex is not reachable)
+  for (std::size_t i = 0; i < tree.vertexIds.size(); ++i) {
+    fout << tree.vertexIds[i] << " ";
+    if (tree.distance[i] == graph::algorithms::ShortestPathTree::UNREACHABLE)
+      fout << "inf";
+    else
+      fout << tree.distance[i];
+    fout << " " << (tree.parent[i] == -1 ? "-" : tree.vertexIds[tree.parent[i]]) << "\n";
+  }
+  fout.close();
+}
+
+
+// One "id value" line per vertex of the file, the ids are streamed from it
+static void saveVertexValues(graph::compact::GraphFileReader &file, const std::vector<int> &values,
+                             const std::string &path) {
+  std::ofstream fout(path);
+  if (!fout.is_open())
+    throw std::runtime_error("Could not open file '" + path + "' for writing");
+  file.readIds([&](int vertex, std::string_view id) { fout << id << " " << values[vertex] << "\n"; });
+  if (!fout)
+    throw std::runtime_error("Could not write to '" + path + "'");
+}
+
+
+graph::algorithms::ExternalBfsResult GraphService::runExternalBfs(
+    const std::string &path, const graph::idT &sourceId, const std::string &outputPath,
+    const graph::algorithms::ExternalProgressCallback &progress) {
+  graph::compact::GraphFileReader file(path);
+  const int source = file.findVertex(sourceId);
+  if (source == -1)
+    throw std::runtime_error("Vertex " + sourceId + " is not in the graph");
+  auto result = graph::algorithms::externalBfs(file, source, progress);
+  if (!outputPath.empty())
+    saveVertexValues(file, result.level, outputPath);
+  return result;
+}
+
+
+graph::algorithms::ExternalComponentsResult GraphService::runExternalComponents(
+    const std::string &path, const std::string &outputPath,
+    const graph::algorithms::ExternalProgressCallback &progress) {
+  graph::compact::GraphFileReader file(path);
+  auto result = graph::algorithms::externalConnectedComponents(file, progress);
+  if (!outputPath.empty())
+    saveVertexValues(file, result.component, outputPath);
+  return result;
+}
+
+
+graph::distributed::Partition GraphService::partitionGraph(int nrOfShards, const std::string &strategy,
+                                                          const std::string &prefix) const {
+  graph::distributed::PartitionStrategy partitionStrategy;
+  if (strategy == "hash")
+    partitionStrategy = graph::distributed::PartitionStrategy::Hash;
+  else if (strategy == "greedy")
+    partitionStrategy = graph::distributed::PartitionStrategy::Greedy;
+  else
+    throw std::runtime_error("Unknown partition strategy '" + strategy + "' (hash or greedy)");
+  const auto compactGraph = snapshot().getCompactGraph();
+  auto partition = graph::distributed::partitionGraph(*compactGraph, nrOfShards, partitionStrategy);
+  graph::distributed::saveShards(*compactGraph, partition, prefix);
+  return partition;
+}
+
+
+graph::distributed::PartitionedResult GraphService::runPartitioned(const std::string &prefix,
+                                                                   const std::string &algorithm,
+                                                                   const graph::idT &sourceId,
+                                                                   const std::string &outputPath) {
+  graph::distributed::BspAlgorithm bspAlgorithm;
+  if (algorithm == "bfs")
+    bspAlgorithm = graph::distributed::BspAlgorithm::Bfs;
+  else if (algorithm == "cc")
+    bspAlgorithm = graph::distributed::BspAlgorithm::Components;
+  else if (algorithm == "sssp")
+    bspAlgorithm = graph::distributed::BspAlgorithm::ShortestPaths;
+  else
+    throw std::runtime_error("Unknown algorithm '" + algorithm + "' (bfs, cc or sssp)");
+  auto result = graph::distributed::runPartitioned(prefix, bspAlgorithm, sourceId, !outputPath.empty());
+
+  // the label of a component is its smallest vertex, so the scan meets the components in that order
+  if (bspAlgorithm == graph::distributed::BspAlgorithm::Components) {
+    std::int64_t nrOfComponents = 0;
+    for (std::size_t v = 0; v < result.value.size(); ++v)
+      result.value[v] = result.value[v] == (std::int64_t)v ? nrOfComponents++ : result.value[result.value[v]];
+  }
+  if (!outputPath.empty()) {
+    std::ofstream fout(outputPath);
+    if (!fout.is_open())
+      throw std::runtime_error("Could not open file '" + outputPath + "' for writing");
+    for (std::size_t v = 0; v < result.value.size(); ++v) {
+      fout << result.ids[v] << " ";
+      if (result.value[v] != graph::distributed::PartitionedResult::UNREACHED)
+        fout << result.value[v];
+      else
+        fout << (bspAlgorithm == graph::distributed::BspAlgorithm::Bfs ? "-1" : "inf");
+      fout << "\n";
+    }
+    if (!fout)
+      throw std::runtime_error("Could not write to '" + outputPath + "'");
+  }
+  return result;
+}
+
+
+/* The schedule is kept in the activities, so it is computed on a copy of the latest graph (the clone copies the
+   activities) and published as the next version, where the listings show it. The versions before, the snapshots
+   and the other branches keep their activities as they were. */
+std::shared_ptr<const graph::special::ActivityGraph> GraphService::scheduleActivities(const std::string &operation) {
+  if (latest->mappedGraph || latest->graph->getGraphType() != graph::GraphType::Activity)
+    throw std::runtime_error(operation + " is only available for ActivityGraph");
+  if (latest->number == scheduledVersion)
+    return std::dynamic_pointer_cast<const graph::special::ActivityGraph>(latest->graph);
+  std::shared_ptr<graph::special::ActivityGraph> activityGraph(
+      dynamic_cast<graph::special::ActivityGraph *>(latest->graph->clone().release()));
+  // the other branches and the snapshots may share the latest graph: the schedule may only go to new activities
+  for (const auto &[activityId, activity] : *activityGraph)
+    if (activity == latest->graph->getVertex(activityId))
+      throw std::runtime_error("The copy of the activity graph shares activity " + activityId + " with the branches");
   if (!activityGraph->computeSchedule())
-    throw std::runtime_error("Cycle detected!");
-  return activityGraph->getTotalProjectTime();
+    throw std::runtime_error(describeCycle(*activityGraph));
+  auto version = deriveVersion(*latest);
+  version->graph = activityGraph;
+  publish(std::move(version));
+  scheduledVersion = lastVersionNumber;
+  return activityGraph;
+}
+
+
+int GraphService::getTotalProjectTime() {
+  std::lock_guard<std::mutex> lock(writeMutex);
+  return scheduleActivities("getTotalProjectTime")->getTotalProjectTime();
 }
 
 std::vector<graph::idT> GraphService::getCriticalActivities() {
-  if (graph->getGraphType() != graph::GraphType::Activity) 
-    throw std::runtime_error("getCriticalActivities is only available for ActivityGraph");
-  const auto &activityGraph = std::dynamic_pointer_cast<graph::special::ActivityGraph>(graph);
-  if (!activityGraph->computeSchedule())
-    throw std::runtime_error("Cycle detected!");
-  return activityGraph->getCriticalActivities();
+  std::lock_guard<std::mutex> lock(writeMutex);
+  return scheduleActivities("getCriticalActivities")->getCriticalActivities();
 }
 
 
 std::vector<graph::idT> GraphService::getMinimumVertexCover() {
-  if (graph->getGraphType() != graph::GraphType::Undirected) 
+  const auto pinned = snapshot();
+  if (pinned.getGraphType() != graph::GraphType::Undirected) 
     throw std::runtime_error("MinimumVertexCover is only available for Undirected Graphs!");
-  auto undirected = dynamic_cast<graph::UndirectedGraph*>(graph.get());
+  auto undirected = dynamic_cast<const graph::UndirectedGraph*>(&pinned.getGraph());
   return graph::algorithms::getMinimumVertexCover(*undirected);
 }
+
+
+graph::utils::MemoryReport GraphService::getMemoryUsage() const {
+  return snapshot().getMemoryUsage();
+}
+
+
+graph::utils::MemoryReport GraphService::projectMemoryUsage(const std::string &graphType, std::size_t nrOfVertices,
+                                                            std::size_t nrOfEdges, std::size_t averageIdLength) {
+  if (graphType == "undirected")
+    return graph::UndirectedGraph::projectMemoryUsage(nrOfVertices, nrOfEdges, averageIdLength);
+  if (graphType == "directed")
+    return graph::DirectedGraph::projectMemoryUsage(nrOfVertices, nrOfEdges, averageIdLength);
+  if (graphType == "activity")
+    return graph::special::ActivityGraph::projectMemoryUsage(nrOfVertices, nrOfEdges, averageIdLength);
+  throw std::runtime_error("'" + graphType + "' is not a valid graph type");
+}
+
+
+/* Reads the "n m" header when there is one, otherwise counts the lines (and the predecessors of the activities) */
+graph::utils::MemoryReport GraphService::projectLoadMemoryUsage(const std::string &path, const std::string &graphType) {
+  std::ifstream fin(path);
+  if (!fin.is_open())
+    throw std::runtime_error("Could not open file '" + path + "' for reading");
+  std::string firstLine;
+  std::getline(fin, firstLine);
+  std::istringstream header(firstLine);
+  std::size_t nrOfVertices = 0, nrOfEdges = 0;
+  std::string rest;
+  if (graphType != "activity" && header >> nrOfVertices >> nrOfEdges && !(header >> rest))
+    return projectMemoryUsage(graphType, nrOfVertices, nrOfEdges, std::to_string(nrOfVertices).size());
+
+  // the length of the first id stands for all of them
+  const std::size_t averageIdLength = firstLine.find_first_of(" |") == std::string::npos
+                                          ? firstLine.size() : firstLine.find_first_of(" |");
+  std::size_t nrOfLines = firstLine.empty() ? 0 : 1, nrOfCommas = 0;
+  fin.clear();
+  char buffer[1 << 16];
+  bool lineStarted = false;
+  while (fin.read(buffer, sizeof(buffer)) || fin.gcount() > 0) {
+    for (std::streamsize i = 0; i < fin.gcount(); ++i) {
+      nrOfCommas += buffer[i] == ',';
+      if (buffer[i] == '\n') {
+        nrOfLines += lineStarted;
+        lineStarted = false;
+      } else {
+        lineStarted = true;
+      }
+    }
+  }
+  nrOfLines += lineStarted;
+  if (graphType == "activity") // one activity per line, every comma separates two predecessors
+    return projectMemoryUsage(graphType, nrOfLines, nrOfLines + nrOfCommas, averageIdLength);
+  // an edge per line; the vertices are not known without reading the ids, assume two edges per vertex
+  return projectMemoryUsage(graphType, nrOfLines / 2 + 1, nrOfLines, averageIdLength);
+}
+
+
+void GraphService::setMemoryLimit(std::size_t bytes) {
+  memoryLimit = bytes;
+}
+
+
+std::size_t GraphService::getMemoryLimit() const {
+  return memoryLimit;
+}
+
+
+// MemAvailable of /proc/meminfo: the free memory plus the caches the kernel can drop
+static std::size_t getAvailableMemory() {
+  std::ifstream meminfo("/proc/meminfo");
+  std::string key;
+  std::size_t kilobytes;
+  std::string unit;
+  while (meminfo >> key >> kilobytes >> unit)
+    if (key == "MemAvailable:")
+      return kilobytes * 1024;
+  return (std::size_t)sysconf(_SC_AVPHYS_PAGES) * (std::size_t)sysconf(_SC_PAGESIZE);
+}
+
+
+void GraphService::checkMemoryBudget(const graph::utils::MemoryReport &projection) const {
+  // the limit covers everything the service holds, the available memory excludes what it holds already
+  const std::size_t limit = memoryLimit;
+  std::size_t budget;
+  if (limit == 0)
+    budget = getAvailableMemory();
+  else
+    budget = limit - std::min(limit, getMemoryUsage().getTotalBytes());
+  if (projection.getTotalBytes() > budget)
+    throw std::runtime_error(std::format("Refusing to build a graph with {} vertices and {} edges: it needs about {}, "
+                                         "but only {} are available",
+                                         projection.nrOfVertices, projection.nrOfEdges,
+                                         graph::utils::MemoryReport::formatBytes(projection.getTotalBytes()),
+                                         graph::utils::MemoryReport::formatBytes(budget)));
+}
+
+
+/* The record goes to the log under writeMutex, so the log has the changes in the order of the versions; the
+   sync waits outside of it, where the writers that come meanwhile share it */
+void GraphService::update(const std::function<void(graph::Graph &)> &change, const MutationLog::Record &record) {
+  std::shared_ptr<MutationLog> log;
+  std::uint64_t lsn = 0;
+  {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    requireInMemory(*latest);
+    auto graph = latest->graph->clone();
+    change(*graph);
+    auto version = std::make_shared<GraphVersion>();
+    version->graph = std::move(graph);
+    if ((log = mutationLog))
+      lsn = log->append(record);
+    publish(std::move(version));
+  }
+  if (log)
+    commitChange(log, lsn);
+}
+
+
+void GraphService::commitChange(const std::shared_ptr<MutationLog> &log, std::uint64_t lsn) {
+  log->commit(lsn);
+  if (!log->needsCheckpoint() || checkpointPending.exchange(true))
+    return;
+  std::lock_guard<std::mutex> lock(checkpointThreadMutex);
+  if (checkpointThread.joinable()) // the previous one, done: it clears the flag last
+    checkpointThread.join();
+  checkpointThread = std::thread([this, log] {
+    try {
+      writeCheckpoint(log);
+    } catch (const std::exception &e) {
+      std::cerr << "Checkpoint failed: " << e.what() << '\n';
+      log->recordCheckpointFailure(e.what());
+    }
+    checkpointPending = false;
+  });
+}
+
+
+void GraphService::requireNoLog(const std::string &operation) const {
+  if (mutationLog)
+    throw std::runtime_error("Cannot " + operation + " while the changes are logged to '" +
+                             mutationLog->getDirectory() + "', close the log first");
+}
+
+
+std::shared_ptr<GraphVersion> GraphService::deriveVersion(const GraphVersion &version) {
+  auto derived = std::make_shared<GraphVersion>();
+  derived->graph = version.graph;
+  derived->altIndex = version.altIndex;
+  derived->contractionHierarchy = version.contractionHierarchy;
+  derived->compressedGraph = version.compressedGraph;
+  derived->mappedGraph = version.mappedGraph;
+  std::lock_guard<std::mutex> lock(version.cacheMutex);
+  derived->compactGraph = version.compactGraph;
+  derived->reachabilityIndex = version.reachabilityIndex;
+  return derived;
+}
+
+
+void GraphService::requireInMemory(const GraphVersion &version) {
+  if (version.mappedGraph)
+    throw std::runtime_error("The graph mapped from '" + version.mappedGraph->getPath() + "' is read only");
+}
+
+
+// The previous version goes away with its last snapshot, here if there is none
+void GraphService::publish(std::shared_ptr<GraphVersion> version) {
+  version->number = ++lastVersionNumber;
+  version->vertexOrder = vertexOrder;
+  std::shared_ptr<const GraphVersion> previous; // released after the lock
+  std::lock_guard<std::mutex> lock(versionMutex);
+  previous = std::exchange(latest, std::move(version));
+}
@@ -2,14 +2,60 @@
 #include "../graph/abstract/Graph.hpp"
 #include "../graph/undirected_graph/UndirectedGraph.hpp"
 #include "../graph/vertices/BaseVertex.hpp"
+#include "../graph/compact/CompactGraph.hpp"
+#include "../graph/algorithms/DirectedGraphAlgorithms.hpp"
+#include "../graph/algorithms/SemiExternalAlgorithms.hpp"
+#include "../graph/index/AltIndex.hpp"
+#include "../graph/index/ContractionHierarchy.hpp"
+#include "../graph/index/ReachabilityIndex.hpp"
+#include "../graph/generators/Generators.hpp"
+#include "../graph/distributed/BspEngine.hpp"
+#include "GraphSnapshot.hpp"
+#include "MutationLog.hpp"
+#include <atomic>
+#include <functional>
+#include <list>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
+namespace graph::special {
+class ActivityGraph;
+}
+
+// The queries run against a snapshot of the latest version of the graph, so they never wait for the
+// writers: a change is applied to a copy of the latest version (sharing all the storage it does not
+// touch) and published as the next version when it is complete. The writers take turns.
 class GraphService {
 public:
-  GraphService(std::unique_ptr<graph::Graph> graph) : graph(std::move(graph)) {}
+  GraphService(std::unique_ptr<graph::Graph> graph);
   GraphService() : GraphService(std::make_unique<graph::UndirectedGraph>()) {}
+  // Waits for a background checkpoint
+  ~GraphService();
+
+  // Pins the latest version, the algorithms run against it while the writers go on
+  GraphSnapshot snapshot() const;
+
+  // What-if branches: named lines of versions, all the other commands work on the current one. A fork
+  // starts from the latest version of the current branch and shares it (graph, caches and indexes), so it
+  // costs a map entry; afterwards every branch copies only the chunks of the tables it changes.
+  struct BranchInfo {
+    std::string name;
+    std::uint64_t version;
+    int nrOfVertices;
+    int nrOfEdges;
+    bool current;
+  };
+  // Creates the branch and switches to it
+  void forkBranch(const std::string &name);
+  void switchBranch(const std::string &name);
+  // The current branch cannot be discarded, its versions go away with their last snapshot
+  void discardBranch(const std::string &name);
+  std::vector<BranchInfo> getBranches();
+  std::string getCurrentBranch();
 
   graph::GraphType getGraphType() const;
 
@@ -28,13 +74,111 @@ public:
   std::vector<graph::VertexSharedPtr> getVertices();
 
   std::vector<graph::Edge> getEdges();
+  // Pages of the edges, in storage order. Skips offset edges from where the page of token stopped (from
+  // the first edge when it is empty), then visits up to limit of them (0: all the rest) with the visitor
+  // makeVisitor returns for the graph of the listed version, given its type and edge count. The token of
+  // the next page is empty after the last edge. A listing keeps reading the version it started on whatever
+  // the writers do meanwhile; the versions of the last MAX_PAGED_VERSIONS listings are kept for that.
+  struct EdgePage {
+    std::size_t nrOfEdges; // visited
+    std::string nextToken;
+  };
+  using EdgeVisitorFactory = std::function<graph::EdgeVisitor(graph::GraphType, std::size_t nrOfEdges)>;
+  EdgePage visitEdges(const std::string &token, std::size_t offset, std::size_t limit,
+                      const EdgeVisitorFactory &makeVisitor) const;
 
+  // graphType "mapped" maps a file saveMappedGraph wrote instead of reading it: opening it checks the offsets
+  // and the neighbors, the other pages are read as the queries touch them. A mapped graph is read only; the lookups, the listings,
+  // the walks and the (weakly) connected components work on it.
   void loadGraph(const std::string &path, const std::string &graphType);
-  void saveGraph(const std::string& path) const;
+  // One "from to cost" line per edge (an undirected edge once) and a line per isolated vertex, in the load_graph
+  // format. withHeader: the vertices numbered 0..n-1 under a "vertex_count edge_count" line instead of the ids.
+  void saveGraph(const std::string &path, bool withHeader = false) const;
+  // The directed graph as a binary CSR file, for load_graph mapped
+  void saveMappedGraph(const std::string &path) const;
+
+  // synthetic graphs: replace the current graph, or only write the file (for graphs too large to keep in memory)
+  std::size_t generateGraph(const std::string &graphType, const std::string &model, const std::vector<long long> &parameters,
+                            const graph::generators::GeneratorOptions &options);
+  std::size_t generateGraphFile(const std::string &path, const std::string &graphType, const std::string &model,
+                                const std::vector<long long> &parameters, graph::generators::GeneratorOptions options);
 
-  std::vector<graph::UndirectedGraph> getConnectedComponentsOfUnorderedGraph() const;
+  std::vector<std::vector<graph::idT>> getConnectedComponentsOfUnorderedGraph() const;
   std::pair<std::vector<graph::idT>, int> getLowestCostWalk(const graph::idT &startId, const graph::idT &endId) const;
+  // Same as getLowestCostWalk, but also reports the search effort when an index answered the query
+  graph::index::PathQueryResult findLowestCostWalk(const graph::idT &startId, const graph::idT &endId) const;
   std::vector<graph::idT> topologicalSort() const;
+  // strongly connected components, numbered so that the condensation edges go from higher to lower numbers
+  std::vector<std::vector<graph::idT>> getStronglyConnectedComponents(bool parallel = false) const;
+  void saveCondensation(const std::string &path, bool parallel = false) const;
+  graph::algorithms::ShortestPathTree getShortestPathTree(const graph::idT &sourceId, int delta = 0) const;
+  void saveShortestPathTree(const graph::idT &sourceId, const std::string &path, int delta = 0) const;
+
+  // Semi-external algorithms on a mapped graph file (saveMappedGraph) that is too large for the memory: the
+  // file is streamed in blocks, only the per-vertex state is kept. With an output path, one "id value" line
+  // per vertex is written there (the level, -1 when unreached; the component).
+  static graph::algorithms::ExternalBfsResult runExternalBfs(
+      const std::string &path, const graph::idT &sourceId, const std::string &outputPath,
+      const graph::algorithms::ExternalProgressCallback &progress = {});
+  static graph::algorithms::ExternalComponentsResult runExternalComponents(
+      const std::string &path, const std::string &outputPath,
+      const graph::algorithms::ExternalProgressCallback &progress = {});
+
+  // Partitioned execution in worker processes (graph/distributed). partitionGraph splits the directed graph
+  // into nrOfShards shard files "<prefix>.<i>", by "hash" or "greedy" (edge cut minimizing). runPartitioned
+  // runs "bfs", "cc" or "sssp" on the shards at the prefix, without the graph loaded; the components are
+  // renumbered 0..k-1 in the order of their smallest vertex. With an output path, one "id value" line per
+  // vertex is written there like for the semi-external algorithms ("inf" for the unreached ones of sssp).
+  graph::distributed::Partition partitionGraph(int nrOfShards, const std::string &strategy,
+                                               const std::string &prefix) const;
+  static graph::distributed::PartitionedResult runPartitioned(const std::string &prefix, const std::string &algorithm,
+                                                              const graph::idT &sourceId,
+                                                              const std::string &outputPath);
+
+  // point to point shortest path index
+  void buildAltIndex(int nrLandmarks, const std::string &selection = "avoid");
+  void saveAltIndex(const std::string &path) const;
+  void loadAltIndex(const std::string &path);
+  bool hasAltIndex() const;
+  void buildContractionHierarchy();
+  void saveContractionHierarchy(const std::string &path) const;
+  void loadContractionHierarchy(const std::string &path);
+  std::size_t getNrOfShortcuts() const;
+
+  // Read only compressed copy of the directed graph, kept next to it until the graph changes. The shortest
+  // paths without an index and the weakly connected components run on it. Returns its memory usage.
+  graph::utils::MemoryReport compressGraph();
+
+  // Renumbers the compact graph of the current version, and of the next ones, for locality: "insertion",
+  // "degree", "rcm" or "gorder" (see graph::compact::VertexOrder). The algorithms and indexes that run on the
+  // compact graph use the new numbering, the ids stay the same. Returns the locality before and after.
+  std::pair<graph::compact::LocalityMetrics, graph::compact::LocalityMetrics> reorderGraph(const std::string &order);
+
+  // Write-ahead logging of the changes (see MutationLog): once the log is open, every change is appended to it
+  // before its command returns, so the graph survives a crash without being saved. Opening recovers the graph
+  // of the directory, the checkpoint and the changes after it, when there is one; otherwise the current graph
+  // (directed or undirected) becomes its first checkpoint. While the log is open the graph cannot be replaced
+  // (load_graph, generate_graph) and the branches cannot change, the log follows one line of versions.
+  MutationLog::Recovery openLog(const std::string &directory, MutationLog::Options options);
+  // Syncs the log and stops logging
+  void closeLog();
+  // Writes the latest version as the checkpoint and deletes the segments it covers; returns its lsn
+  std::uint64_t checkpoint();
+  // Throws when no log is open
+  MutationLog::Stats getLogStats();
+
+  // reachability queries, answered from an index built on the first call
+  bool canReach(const graph::idT &fromId, const graph::idT &toId);
+
+  // memory accounting: the graph together with the caches and indexes built on it
+  graph::utils::MemoryReport getMemoryUsage() const;
+  static graph::utils::MemoryReport projectMemoryUsage(const std::string &graphType, std::size_t nrOfVertices,
+                                                       std::size_t nrOfEdges, std::size_t averageIdLength = 8);
+  // Projection for loading the file, from its header or from a scan of its lines
+  static graph::utils::MemoryReport projectLoadMemoryUsage(const std::string &path, const std::string &graphType);
+  // Loads and generated graphs that are projected to need more are refused; 0 means the available memory
+  void setMemoryLimit(std::size_t bytes);
+  std::size_t getMemoryLimit() const;
 
   // for activity graph
   int getTotalProjectTime();
@@ -44,5 +188,43 @@ public:
   std::vector<graph::idT> getMinimumVertexCover();
 
 private:
-  std::shared_ptr<graph::Graph> graph;
+  // Applies change to a copy of the latest graph and publishes it, without the structures derived from the old one.
+  // With a log open, record is appended before the publication and the call returns once it is committed.
+  void update(const std::function<void(graph::Graph &)> &change, const MutationLog::Record &record);
+  // After a change is published: waits for its record, starts a checkpoint in the background when one is due
+  void commitChange(const std::shared_ptr<MutationLog> &log, std::uint64_t lsn);
+  std::uint64_t writeCheckpoint(const std::shared_ptr<MutationLog> &log);
+  // Computes the schedule of the latest activity graph on a copy and publishes it (the caller holds writeMutex)
+  std::shared_ptr<const graph::special::ActivityGraph> scheduleActivities(const std::string &operation);
+  // Throws while the log is open (the caller holds writeMutex)
+  void requireNoLog(const std::string &operation) const;
+  // A version of the same graph with the same derived structures, for adding an index to it
+  static std::shared_ptr<GraphVersion> deriveVersion(const GraphVersion &version);
+  // Throws when the version is a mapped graph, which cannot change
+  static void requireInMemory(const GraphVersion &version);
+  // Makes version the latest one (the caller holds writeMutex)
+  void publish(std::shared_ptr<GraphVersion> version);
+  // Throws if the projection does not fit in the limit, next to what the service holds already
+  // (the current version stays readable while the new graph is built)
+  void checkMemoryBudget(const graph::utils::MemoryReport &projection) const;
+
+  mutable std::mutex versionMutex; // guards the latest pointer only, held for a pointer copy
+  std::shared_ptr<const GraphVersion> latest;
+  std::mutex writeMutex; // also guards the members below
+  std::uint64_t lastVersionNumber = 0; // the numbers are unique across the branches
+  std::string currentBranch = "main";
+  std::map<std::string, std::shared_ptr<const GraphVersion>> branches; // the latest versions of the other branches
+  graph::compact::VertexOrder vertexOrder = graph::compact::VertexOrder::Insertion; // of the published versions
+  std::shared_ptr<MutationLog> mutationLog; // null when the changes are not logged
+  std::uint64_t scheduledVersion = 0; // the last version scheduleActivities published
+
+  std::mutex checkpointMutex; // one checkpoint at a time
+  std::mutex checkpointThreadMutex;
+  std::thread checkpointThread;
+  std::atomic<bool> checkpointPending = false;
+
+  static constexpr std::size_t MAX_PAGED_VERSIONS = 8;
+  mutable std::mutex pagingMutex;
+  mutable std::list<std::shared_ptr<const GraphVersion>> pagedVersions; // most recently paged first
+  std::atomic<std::size_t> memoryLimit = 0;
 };
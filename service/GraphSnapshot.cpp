@@ -0,0 +1,54 @@
+#include "GraphSnapshot.hpp"
+#include "../graph/directed_graph/DirectedGraph.hpp"
+#include <stdexcept>
+
+std::shared_ptr<const graph::compact::CompactGraph> GraphSnapshot::getCompactGraph() const {
+  if (version->mappedGraph)
+    throw std::runtime_error("Not available for the graph mapped from '" + version->mappedGraph->getPath() + "'");
+  std::lock_guard<std::mutex> lock(version->cacheMutex);
+  if (!version->compactGraph) {
+    auto *directed = dynamic_cast<const graph::DirectedGraph *>(version->graph.get());
+    if (directed == nullptr)
+      throw std::runtime_error("Only directed graphs have a compact representation");
+    auto compactGraph = std::make_shared<const graph::compact::CompactGraph>(*directed);
+    if (version->vertexOrder != graph::compact::VertexOrder::Insertion)
+      compactGraph = std::make_shared<const graph::compact::CompactGraph>(
+          *compactGraph, graph::compact::computeVertexOrder(*compactGraph, version->vertexOrder));
+    version->compactGraph = std::move(compactGraph);
+  }
+  return version->compactGraph;
+}
+
+
+std::shared_ptr<const graph::index::ReachabilityIndex> GraphSnapshot::getReachabilityIndex() const {
+  {
+    std::lock_guard<std::mutex> lock(version->cacheMutex);
+    if (version->reachabilityIndex)
+      return version->reachabilityIndex;
+  }
+  // built outside of the lock; when two readers race, the first one to finish is kept
+  auto built = std::make_shared<graph::index::ReachabilityIndex>(getCompactGraph());
+  std::lock_guard<std::mutex> lock(version->cacheMutex);
+  if (!version->reachabilityIndex)
+    version->reachabilityIndex = built;
+  return version->reachabilityIndex;
+}
+
+
+/* Returns the bytes of the graph (its resident pages when it is mapped), then the compact copy and the indexes */
+graph::utils::MemoryReport GraphSnapshot::getMemoryUsage() const {
+  graph::utils::MemoryReport report = version->mappedGraph ? version->mappedGraph->getMemoryUsage()
+                                                           : version->graph->getMemoryUsage();
+  std::lock_guard<std::mutex> lock(version->cacheMutex);
+  if (version->compactGraph)
+    report.add("compact graph cache", version->compactGraph->getMemoryUsage());
+  if (version->altIndex)
+    report.add("ALT index", version->altIndex->getMemoryUsage());
+  if (version->contractionHierarchy)
+    report.add("contraction hierarchy", version->contractionHierarchy->getMemoryUsage());
+  if (version->compressedGraph)
+    report.add("compressed graph", version->compressedGraph->getMemoryUsage());
+  if (version->reachabilityIndex)
+    report.add("reachability index", version->reachabilityIndex->getMemoryUsage());
+  return report;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "../graph/abstract/Graph.hpp"
+#include "../graph/compact/CompactGraph.hpp"
+#include "../graph/compact/CompressedGraph.hpp"
+#include "../graph/compact/MappedGraph.hpp"
+#include "../graph/compact/VertexOrder.hpp"
+#include "../graph/index/AltIndex.hpp"
+#include "../graph/index/ContractionHierarchy.hpp"
+#include "../graph/index/ReachabilityIndex.hpp"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+// One published state of the graph with the structures derived from it. Nothing changes once it is
+// published, except the caches that the readers fill in on demand (under cacheMutex).
+struct GraphVersion {
+  std::uint64_t number = 0;
+  std::shared_ptr<const graph::Graph> graph;
+  std::shared_ptr<const graph::index::AltIndex> altIndex;
+  std::shared_ptr<const graph::index::ContractionHierarchy> contractionHierarchy;
+  std::shared_ptr<const graph::compact::CompressedGraph> compressedGraph;
+  // Set when the graph is a mapped file (load_graph mapped): graph is empty then, and the version is read only
+  std::shared_ptr<const graph::compact::MappedGraph> mappedGraph;
+  // The numbering of the compact graph when a reader builds it (GraphService::reorderGraph)
+  graph::compact::VertexOrder vertexOrder = graph::compact::VertexOrder::Insertion;
+
+  mutable std::mutex cacheMutex;
+  mutable std::shared_ptr<const graph::compact::CompactGraph> compactGraph;
+  // survives edge insertions: the writer takes it over for the next version (GraphService::addEdge)
+  mutable std::shared_ptr<graph::index::ReachabilityIndex> reachabilityIndex;
+};
+
+// A read handle pinned to one version of the graph: whatever the writers publish meanwhile, everything
+// read through it describes that version. A version is freed with its last snapshot, the storage it
+// shares with the newer versions stays (see utils::CowHashTable).
+class GraphSnapshot {
+public:
+  std::uint64_t getVersion() const { return version->number; }
+  const graph::Graph &getGraph() const { return *version->graph; }
+  graph::GraphType getGraphType() const { return version->graph->getGraphType(); }
+
+  // Built by the first caller that needs them, shared by all the snapshots of the version
+  std::shared_ptr<const graph::compact::CompactGraph> getCompactGraph() const;
+  std::shared_ptr<const graph::index::ReachabilityIndex> getReachabilityIndex() const;
+
+  std::shared_ptr<const graph::index::AltIndex> getAltIndex() const { return version->altIndex; }
+  std::shared_ptr<const graph::index::ContractionHierarchy> getContractionHierarchy() const {
+    return version->contractionHierarchy;
+  }
+  std::shared_ptr<const graph::compact::CompressedGraph> getCompressedGraph() const { return version->compressedGraph; }
+  std::shared_ptr<const graph::compact::MappedGraph> getMappedGraph() const { return version->mappedGraph; }
+
+  // The graph together with the caches and indexes built on it
+  graph::utils::MemoryReport getMemoryUsage() const;
+
+private:
+  friend class GraphService;
+  explicit GraphSnapshot(std::shared_ptr<const GraphVersion> version) : version(std::move(version)) {}
+
+  std::shared_ptr<const GraphVersion> version;
+};
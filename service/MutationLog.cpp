@@ -0,0 +1,476 @@
+#include "MutationLog.hpp"
+#include "../graph/directed_graph/DirectedGraph.hpp"
+#include "../graph/undirected_graph/UndirectedGraph.hpp"
+#include "../graph/vertices/StringVertex.hpp"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+// The checkpoint: the header, then the ids (uint32 length + bytes) in the order the edges refer to them,
+// then the edges as uint32 from, uint32 to (positions in the ids) and int32 weight; every undirected edge once
+constexpr std::uint64_t CHECKPOINT_MAGIC = 0x504b434850415247; // "GRAPHCKP"
+constexpr std::uint32_t CHECKPOINT_VERSION = 1;
+
+struct CheckpointHeader {
+  std::uint64_t magic;
+  std::uint32_t version;
+  std::uint32_t graphType; // graph::GraphType
+  std::uint64_t lsn;
+  std::uint64_t nrOfVertices;
+  std::uint64_t nrOfEdges;
+  std::uint64_t payloadBytes;
+  std::uint32_t payloadCrc;
+  std::uint32_t reserved;
+};
+
+// length and CRC of a record
+constexpr std::size_t RECORD_HEADER_BYTES = 2 * sizeof(std::uint32_t);
+constexpr std::uint32_t MAX_RECORD_BYTES = 1 << 30;
+
+
+/* CRC-32 (the polynomial of zlib and Ethernet), a byte at a time: the records are small */
+static std::uint32_t crc32(std::string_view bytes) {
+  static const auto table = [] {
+    std::array<std::uint32_t, 256> values{};
+    for (std::uint32_t i = 0; i < 256; ++i) {
+      std::uint32_t c = i;
+      for (int k = 0; k < 8; ++k)
+        c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+      values[i] = c;
+    }
+    return values;
+  }();
+  std::uint32_t crc = 0xffffffff;
+  for (const unsigned char byte : bytes)
+    crc = table[(crc ^ byte) & 0xff] ^ (crc >> 8);
+  return crc ^ 0xffffffff;
+}
+
+
+template <typename T>
+static void appendPod(std::string &out, const T &value) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+static void appendString(std::string &out, const std::string &value) {
+  appendPod<std::uint32_t>(out, value.size());
+  out += value;
+}
+
+// Reads the fields of a record or a checkpoint; false once one would go past the end
+struct FieldReader {
+  std::string_view bytes;
+
+  template <typename T>
+  bool read(T &value) {
+    if (bytes.size() < sizeof(T))
+      return false;
+    std::memcpy(&value, bytes.data(), sizeof(T));
+    bytes.remove_prefix(sizeof(T));
+    return true;
+  }
+
+  bool read(std::string &value) {
+    std::uint32_t length;
+    if (!read(length) || bytes.size() < length)
+      return false;
+    value.assign(bytes.data(), length);
+    bytes.remove_prefix(length);
+    return true;
+  }
+};
+
+
+static void writeAll(int fd, std::string_view bytes, const std::string &path) {
+  while (!bytes.empty()) {
+    const ssize_t count = ::write(fd, bytes.data(), bytes.size());
+    if (count < 0 && errno == EINTR)
+      continue;
+    if (count < 0)
+      throw std::runtime_error("Could not write to '" + path + "': " + std::strerror(errno));
+    bytes.remove_prefix(count);
+  }
+}
+
+
+/* Makes a file creation, rename or removal in the directory durable */
+static void syncDirectory(const std::string &directory) {
+  const int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd >= 0) {
+    ::fsync(fd);
+    ::close(fd);
+  }
+}
+
+
+static std::string readFile(const std::string &path) {
+  std::ifstream fin(path, std::ios::binary);
+  if (!fin.is_open())
+    throw std::runtime_error("Could not open file '" + path + "' for reading");
+  return std::string(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+}
+
+
+static std::string getSegmentPath(const std::string &directory, std::uint64_t segment) {
+  return directory + "/wal." + std::to_string(segment);
+}
+
+
+/* The numbers of the segments in the directory, ascending */
+static std::vector<std::uint64_t> listSegments(const std::string &directory) {
+  std::vector<std::uint64_t> segments;
+  for (const auto &entry : std::filesystem::directory_iterator(directory)) {
+    const std::string name = entry.path().filename().string();
+    if (name.rfind("wal.", 0) == 0 && name.size() > 4 &&
+        name.find_first_not_of("0123456789", 4) == std::string::npos)
+      segments.push_back(std::stoull(name.substr(4)));
+  }
+  std::sort(segments.begin(), segments.end());
+  return segments;
+}
+
+
+static void apply(graph::Graph &g, const MutationLog::Record &record) {
+  switch (record.type) {
+  case MutationLog::RecordType::AddVertex:
+    g.addVertex(std::make_shared<graph::StringVertex>(record.fromId));
+    break;
+  case MutationLog::RecordType::RemoveVertex:
+    g.removeVertex(record.fromId);
+    break;
+  case MutationLog::RecordType::AddEdge:
+    g.addEdge(record.fromId, record.toId, record.weight);
+    break;
+  case MutationLog::RecordType::RemoveEdge:
+    g.removeEdge(record.fromId, record.toId);
+    break;
+  default:
+    throw std::runtime_error("Unknown change");
+  }
+}
+
+
+void MutationLog::writeCheckpoint(const std::string &directory, const graph::Graph &g, std::uint64_t lsn) {
+  if (g.getGraphType() != graph::GraphType::Directed && g.getGraphType() != graph::GraphType::Undirected)
+    throw std::runtime_error("Only directed and undirected graphs can be checkpointed");
+  std::string payload;
+  std::unordered_map<std::string_view, std::uint32_t> positions;
+  positions.reserve(g.getNrOfVertices());
+  for (const auto &[vertexId, _] : g) {
+    positions.emplace(vertexId, positions.size());
+    appendString(payload, vertexId);
+  }
+  std::uint64_t nrOfEdges = 0;
+  graph::EdgeCursor cursor;
+  g.visitEdges(cursor, std::numeric_limits<std::size_t>::max(), [&](const auto &fromId, const auto &toId, int weight) {
+    appendPod(payload, positions.at(fromId));
+    appendPod(payload, positions.at(toId));
+    appendPod<std::int32_t>(payload, weight);
+    ++nrOfEdges;
+  });
+  const CheckpointHeader header{CHECKPOINT_MAGIC, CHECKPOINT_VERSION, (std::uint32_t)g.getGraphType(),
+                                lsn, positions.size(), nrOfEdges, payload.size(), crc32(payload), 0};
+
+  const std::string path = directory + "/checkpoint", temporary = path + ".tmp";
+  const int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0)
+    throw std::runtime_error("Could not open file '" + temporary + "' for writing");
+  try {
+    writeAll(fd, std::string_view(reinterpret_cast<const char *>(&header), sizeof(header)), temporary);
+    writeAll(fd, payload, temporary);
+    if (::fsync(fd) != 0)
+      throw std::runtime_error("Could not sync '" + temporary + "'");
+  } catch (...) {
+    ::close(fd);
+    std::filesystem::remove(temporary);
+    throw;
+  }
+  ::close(fd);
+  if (std::rename(temporary.c_str(), path.c_str()) != 0)
+    throw std::runtime_error("Could not rename '" + temporary + "' to '" + path + "'");
+  syncDirectory(directory);
+}
+
+
+/* Builds the graph of the checkpoint, checking its CRC first */
+static std::unique_ptr<graph::Graph> readCheckpoint(const std::string &path, std::uint64_t &lsn) {
+  const std::string bytes = readFile(path);
+  CheckpointHeader header;
+  if (bytes.size() < sizeof(header))
+    throw std::runtime_error("'" + path + "' is not a checkpoint");
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  if (header.magic != CHECKPOINT_MAGIC)
+    throw std::runtime_error("'" + path + "' is not a checkpoint");
+  if (header.version != CHECKPOINT_VERSION)
+    throw std::runtime_error("'" + path + "' is a checkpoint of another format version");
+  const std::string_view payload = std::string_view(bytes).substr(sizeof(header));
+  if (payload.size() != header.payloadBytes || crc32(payload) != header.payloadCrc)
+    throw std::runtime_error("'" + path + "' is damaged");
+
+  std::unique_ptr<graph::Graph> g;
+  if (header.graphType == (std::uint32_t)graph::GraphType::Directed)
+    g = std::make_unique<graph::DirectedGraph>();
+  else if (header.graphType == (std::uint32_t)graph::GraphType::Undirected)
+    g = std::make_unique<graph::UndirectedGraph>();
+  else
+    throw std::runtime_error("'" + path + "' is damaged");
+  FieldReader reader{payload};
+  std::vector<std::string> ids(header.nrOfVertices);
+  for (auto &id : ids) {
+    if (!reader.read(id))
+      throw std::runtime_error("'" + path + "' is damaged");
+    g->addVertex(std::make_shared<graph::StringVertex>(id));
+  }
+  for (std::uint64_t e = 0; e < header.nrOfEdges; ++e) {
+    std::uint32_t from, to;
+    std::int32_t weight;
+    if (!reader.read(from) || !reader.read(to) || !reader.read(weight) || from >= ids.size() || to >= ids.size())
+      throw std::runtime_error("'" + path + "' is damaged");
+    g->addEdge(ids[from], ids[to], weight);
+  }
+  lsn = header.lsn;
+  return g;
+}
+
+
+/* Replays the segments in order; a record is complete when its length fits in the file and its CRC matches */
+std::unique_ptr<graph::Graph> MutationLog::recover(const std::string &directory, Recovery &recovery) {
+  recovery = Recovery();
+  const std::string checkpointPath = directory + "/checkpoint";
+  if (!std::filesystem::exists(checkpointPath)) {
+    if (!listSegments(directory).empty())
+      throw std::runtime_error("'" + directory + "' has log segments but no checkpoint");
+    return nullptr;
+  }
+  auto g = readCheckpoint(checkpointPath, recovery.checkpointLsn);
+  recovery.fromCheckpoint = true;
+  recovery.lastLsn = recovery.checkpointLsn;
+
+  const auto segments = listSegments(directory);
+  for (std::size_t i = 0; i < segments.size(); ++i) {
+    const std::string path = getSegmentPath(directory, segments[i]);
+    const std::string bytes = readFile(path);
+    std::size_t at = 0;
+    while (at < bytes.size()) {
+      std::uint32_t length = 0, crc = 0;
+      if (at + RECORD_HEADER_BYTES <= bytes.size()) {
+        std::memcpy(&length, bytes.data() + at, sizeof(length));
+        std::memcpy(&crc, bytes.data() + at + sizeof(length), sizeof(crc));
+      }
+      const bool complete = at + RECORD_HEADER_BYTES <= bytes.size() && length <= MAX_RECORD_BYTES &&
+                            length <= bytes.size() - at - RECORD_HEADER_BYTES &&
+                            crc32(std::string_view(bytes).substr(at + RECORD_HEADER_BYTES, length)) == crc;
+      if (!complete) {
+        // a crash in the middle of a write leaves a partial record, only at the end of the last segment
+        if (i + 1 != segments.size())
+          throw std::runtime_error("'" + path + "' is damaged at byte " + std::to_string(at));
+        std::filesystem::resize_file(path, at);
+        recovery.truncatedBytes = bytes.size() - at;
+        break;
+      }
+
+      FieldReader reader{std::string_view(bytes).substr(at + RECORD_HEADER_BYTES, length)};
+      at += RECORD_HEADER_BYTES + length;
+      std::uint64_t lsn;
+      std::uint8_t type;
+      Record record;
+      if (!reader.read(lsn) || !reader.read(type) || !reader.read(record.fromId))
+        throw std::runtime_error("'" + path + "' has a bad record");
+      record.type = (RecordType)type;
+      if ((record.type == RecordType::AddEdge || record.type == RecordType::RemoveEdge) && !reader.read(record.toId))
+        throw std::runtime_error("'" + path + "' has a bad record");
+      if (record.type == RecordType::AddEdge && !reader.read(record.weight))
+        throw std::runtime_error("'" + path + "' has a bad record");
+      if (lsn <= recovery.checkpointLsn) // the checkpoint has it: the crash came before the segment was deleted
+        continue;
+      if (lsn != recovery.lastLsn + 1)
+        throw std::runtime_error("'" + path + "' misses the changes " + std::to_string(recovery.lastLsn + 1) +
+                                 " to " + std::to_string(lsn - 1));
+      try {
+        apply(*g, record);
+      } catch (const std::exception &e) {
+        throw std::runtime_error("Could not replay change " + std::to_string(lsn) + " of '" + path + "': " + e.what());
+      }
+      recovery.lastLsn = lsn;
+      ++recovery.nrOfReplayed;
+    }
+  }
+  return g;
+}
+
+
+MutationLog::MutationLog(const std::string &directory, std::uint64_t lastLsn, Options options)
+    : directory(directory), options(options), lastLsn(lastLsn), durableLsn(lastLsn) {
+  const auto segments = listSegments(directory);
+  const std::uint64_t next = segments.empty() ? 1 : segments.back() + 1;
+  firstSegment = segments.empty() ? next : segments.front();
+  openSegment(next);
+  if (options.syncIntervalMs > 0)
+    syncer = std::thread([this] {
+      std::unique_lock<std::mutex> lock(mutex);
+      while (!stopping) {
+        stopRequested.wait_for(lock, std::chrono::milliseconds(this->options.syncIntervalMs));
+        try {
+          syncUpTo(lock, this->lastLsn);
+        } catch (const std::exception &e) {
+          std::cerr << "Mutation log: " << e.what() << '\n';
+        }
+      }
+    });
+}
+
+
+MutationLog::~MutationLog() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  stopRequested.notify_all();
+  if (syncer.joinable())
+    syncer.join();
+  try {
+    sync();
+  } catch (const std::exception &e) {
+    std::cerr << "Mutation log: " << e.what() << '\n';
+  }
+  ::close(fd);
+}
+
+
+void MutationLog::openSegment(std::uint64_t number) {
+  const std::string path = getSegmentPath(directory, number);
+  fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (fd < 0)
+    throw std::runtime_error("Could not open file '" + path + "' for writing");
+  syncDirectory(directory);
+  segment = number;
+}
+
+
+std::uint64_t MutationLog::append(const Record &record) {
+  std::string body;
+  appendPod(body, std::uint64_t{0}); // the lsn, known under the lock
+  appendPod(body, (std::uint8_t)record.type);
+  appendString(body, record.fromId);
+  if (record.type == RecordType::AddEdge || record.type == RecordType::RemoveEdge)
+    appendString(body, record.toId);
+  if (record.type == RecordType::AddEdge)
+    appendPod<std::int32_t>(body, record.weight);
+
+  std::lock_guard<std::mutex> lock(mutex);
+  const std::uint64_t lsn = ++lastLsn;
+  std::memcpy(body.data(), &lsn, sizeof(lsn));
+  appendPod<std::uint32_t>(pending, body.size());
+  appendPod<std::uint32_t>(pending, crc32(body));
+  pending += body;
+  bytesSinceCheckpoint += RECORD_HEADER_BYTES + body.size();
+  return lsn;
+}
+
+
+/* Group commit: the first waiter takes the pending records of everyone, writes and syncs them outside of the
+   lock while the others append or wait, and wakes them all up */
+void MutationLog::syncUpTo(std::unique_lock<std::mutex> &lock, std::uint64_t lsn) {
+  lsn = std::min(lsn, lastLsn);
+  while (durableLsn < lsn) {
+    if (syncing) {
+      synced.wait(lock);
+      continue;
+    }
+    syncing = true;
+    std::string batch;
+    batch.swap(pending);
+    const std::uint64_t batchLsn = lastLsn;
+    const int batchFd = fd;
+    const std::string path = getSegmentPath(directory, segment);
+    lock.unlock();
+    try {
+      writeAll(batchFd, batch, path);
+      if (::fdatasync(batchFd) != 0)
+        throw std::runtime_error("Could not sync '" + path + "'");
+    } catch (...) {
+      lock.lock();
+      syncing = false;
+      synced.notify_all();
+      throw;
+    }
+    lock.lock();
+    syncing = false;
+    durableLsn = batchLsn;
+    ++nrOfSyncs;
+    synced.notify_all();
+  }
+}
+
+
+void MutationLog::commit(std::uint64_t lsn) {
+  if (options.syncIntervalMs > 0)
+    return;
+  std::unique_lock<std::mutex> lock(mutex);
+  syncUpTo(lock, lsn);
+}
+
+
+void MutationLog::sync() {
+  std::unique_lock<std::mutex> lock(mutex);
+  syncUpTo(lock, lastLsn);
+}
+
+
+MutationLog::Rotation MutationLog::rotate() {
+  std::unique_lock<std::mutex> lock(mutex);
+  syncUpTo(lock, lastLsn);
+  synced.wait(lock, [&] { return !syncing; });
+  ::close(fd);
+  openSegment(segment + 1);
+  bytesSinceCheckpoint = 0;
+  return {lastLsn, segment};
+}
+
+
+void MutationLog::dropSegmentsBefore(std::uint64_t number) {
+  std::lock_guard<std::mutex> lock(mutex);
+  for (; firstSegment < number; ++firstSegment)
+    std::filesystem::remove(getSegmentPath(directory, firstSegment));
+  syncDirectory(directory);
+}
+
+
+bool MutationLog::needsCheckpoint() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return bytesSinceCheckpoint > options.checkpointBytes;
+}
+
+
+void MutationLog::recordCheckpointFailure(const std::string &error) {
+  std::lock_guard<std::mutex> lock(mutex);
+  ++nrOfFailedCheckpoints;
+  lastCheckpointError = error;
+}
+
+
+MutationLog::Stats MutationLog::getStats() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return {lastLsn,
+          durableLsn,
+          nrOfSyncs,
+          bytesSinceCheckpoint,
+          segment - firstSegment + 1,
+          nrOfFailedCheckpoints,
+          lastCheckpointError};
+}
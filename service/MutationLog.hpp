@@ -0,0 +1,122 @@
+#pragma once
+#include "../graph/abstract/Graph.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Append-only journal of the changes made through GraphService, kept in a directory next to a checkpoint of
+// the graph, so that persisting a change costs one small append instead of a rewrite of the graph file:
+//   checkpoint     the graph after the change of number lsn, binary (see writeCheckpoint)
+//   wal.<n>        segments of records of the later changes, each
+//                  uint32 length, uint32 CRC-32 of the next length bytes, uint64 lsn, uint8 type, the fields
+//                  (the ids as uint32 length + bytes, then the weight as int32), in the native byte order
+// The changes are numbered from 1 (their lsn, log sequence number). A checkpoint closes the current segment,
+// is written from the version of the graph at that change, and deletes the closed segments once it is in place.
+class MutationLog {
+public:
+  enum class RecordType : std::uint8_t { AddVertex = 1, RemoveVertex, AddEdge, RemoveEdge };
+
+  struct Record {
+    RecordType type;
+    graph::idT fromId; // the vertex of the vertex records
+    graph::idT toId;
+    int weight = 0;
+  };
+
+  struct Options {
+    // 0: a change returns once its record is on disk, and the changes waiting at the same time share one
+    // fdatasync (group commit). Otherwise the records are written and synced in the background every that many
+    // milliseconds: a change costs an append to memory, and a crash loses at most the last interval.
+    int syncIntervalMs = 0;
+    // A checkpoint is taken in the background when the segments since the last one grow past this
+    std::size_t checkpointBytes = std::size_t{64} << 20;
+  };
+
+  // What a recovery found
+  struct Recovery {
+    bool fromCheckpoint = false; // false: the directory had no checkpoint yet
+    std::uint64_t checkpointLsn = 0;
+    std::uint64_t lastLsn = 0;
+    std::uint64_t nrOfReplayed = 0;
+    std::uint64_t truncatedBytes = 0; // of the partial record a crash left at the end of the log
+  };
+
+  struct Stats {
+    std::uint64_t lastLsn = 0;
+    std::uint64_t durableLsn = 0;
+    std::uint64_t nrOfSyncs = 0;
+    std::uint64_t bytesSinceCheckpoint = 0;
+    std::uint64_t nrOfSegments = 0;
+    std::uint64_t nrOfFailedCheckpoints = 0; // in the background, since open_log
+    std::string lastCheckpointError;
+  };
+
+  // Loads the checkpoint of the directory and replays the records after it; a partial record at the end of
+  // the last segment is cut off, any other damage throws. Returns null when there is no checkpoint.
+  static std::unique_ptr<graph::Graph> recover(const std::string &directory, Recovery &recovery);
+
+  // Writes the graph (directed or undirected) as the checkpoint of the change lsn: to a temporary file, synced,
+  // then renamed over the old one
+  static void writeCheckpoint(const std::string &directory, const graph::Graph &g, std::uint64_t lsn);
+
+  // Appends to a new segment after the ones in the directory, the next change being lastLsn + 1
+  MutationLog(const std::string &directory, std::uint64_t lastLsn, Options options);
+  MutationLog(const MutationLog &) = delete;
+  MutationLog &operator=(const MutationLog &) = delete;
+  // Syncs what is left
+  ~MutationLog();
+
+  const std::string &getDirectory() const { return directory; }
+
+  // Appends the record of a change to the buffer and returns its lsn; the caller makes the appends in the
+  // order it applies the changes
+  std::uint64_t append(const Record &record);
+  // Returns once the record of lsn is on disk (at once with a sync interval)
+  void commit(std::uint64_t lsn);
+  // Puts every record appended so far on disk
+  void sync();
+
+  // For a checkpoint: syncs and closes the current segment, opens the next one
+  struct Rotation {
+    std::uint64_t lastLsn; // of the closed segments
+    std::uint64_t segment; // the new one
+  };
+  Rotation rotate();
+  // Deletes the segments before the given one, once the checkpoint that replaces them is in place
+  void dropSegmentsBefore(std::uint64_t segment);
+
+  bool needsCheckpoint() const;
+  // A background checkpoint failed: the segments it rotated stay until one succeeds, log_stats shows why
+  void recordCheckpointFailure(const std::string &error);
+  Stats getStats() const;
+
+private:
+  std::string directory;
+  Options options;
+
+  mutable std::mutex mutex;
+  std::condition_variable synced;
+  std::string pending; // appended, not written yet
+  std::uint64_t lastLsn;
+  std::uint64_t durableLsn;
+  bool syncing = false; // a committer is writing and syncing a batch outside the mutex
+  int fd = -1;
+  std::uint64_t segment = 0;   // the number of the current segment
+  std::uint64_t firstSegment;  // the oldest segment still in the directory
+  std::uint64_t bytesSinceCheckpoint = 0;
+  std::uint64_t nrOfSyncs = 0;
+  std::uint64_t nrOfFailedCheckpoints = 0;
+  std::string lastCheckpointError;
+
+  // the background syncs, with a sync interval
+  std::condition_variable stopRequested;
+  bool stopping = false;
+  std::thread syncer;
+
+  // Writes and syncs the pending records until lsn is durable; the first waiter syncs for all (needs the lock)
+  void syncUpTo(std::unique_lock<std::mutex> &lock, std::uint64_t lsn);
+  void openSegment(std::uint64_t number);
+};
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""Minimal client for `graph_app --listen`.
+
+Sends the commands (one per line, from the arguments or from stdin) pipelined on one
+connection and prints the responses in order. A command prefixed with '!' asks for the
+binary encoding, which is decoded back to text here.
+
+    graph_client.py --unix /tmp/graph.sock 'load_graph directed g.txt' '!list_edges'
+    graph_client.py --tcp 7000 < queries.txt
+"""
+import argparse
+import socket
+import struct
+import sys
+
+
+def read_exactly(sock, size):
+    data = bytearray()
+    while len(data) < size:
+        chunk = sock.recv(size - len(data))
+        if not chunk:
+            raise EOFError("the server closed the connection")
+        data += chunk
+    return bytes(data)
+
+
+def read_string(payload, offset):
+    (length,) = struct.unpack_from("=I", payload, offset)
+    offset += 4
+    return payload[offset:offset + length].decode(), offset + length
+
+
+def decode_edges(payload):
+    offset = 0
+    (nr_of_ids,) = struct.unpack_from("=I", payload, offset)
+    offset += 4
+    ids = []
+    for _ in range(nr_of_ids):
+        vertex_id, offset = read_string(payload, offset)
+        ids.append(vertex_id)
+    (nr_of_edges,) = struct.unpack_from("=I", payload, offset)
+    offset += 4
+    lines = []
+    for from_index, to_index, weight in struct.iter_unpack("=IIi", payload[offset:offset + 12 * nr_of_edges]):
+        lines.append(f"{ids[from_index]} {ids[to_index]} {weight}")
+    return "\n".join(lines)
+
+
+def decode_path(payload):
+    offset = 0
+    (nr_of_vertices,) = struct.unpack_from("=I", payload, offset)
+    offset += 4
+    path = []
+    for _ in range(nr_of_vertices):
+        vertex_id, offset = read_string(payload, offset)
+        path.append(vertex_id)
+    (cost,) = struct.unpack_from("=i", payload, offset)
+    return " ".join(path) + f"\ncost {cost}" if path else "no path"
+
+
+def decode(command, payload):
+    name = command.lstrip("! \t").split()[0]
+    if name in ("list_edges", "list_adj"):
+        return decode_edges(payload)
+    if name == "get_lowest_cost_walk":
+        return decode_path(payload)
+    return payload.hex()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    address = parser.add_mutually_exclusive_group(required=True)
+    address.add_argument("--unix", help="path of the server socket")
+    address.add_argument("--tcp", type=int, help="localhost port of the server")
+    parser.add_argument("--quiet", action="store_true", help="only report the errors")
+    parser.add_argument("commands", nargs="*", help="commands to send (default: the lines of stdin)")
+    options = parser.parse_args()
+
+    commands = options.commands or [line.rstrip("\n") for line in sys.stdin if line.strip()]
+    if options.unix:
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        sock.connect(options.unix)
+    else:
+        sock = socket.create_connection(("127.0.0.1", options.tcp))
+
+    # everything is sent up front, the responses come back in the same order
+    sock.sendall("".join(command + "\n" for command in commands).encode())
+    sock.shutdown(socket.SHUT_WR)
+    failed = False
+    for command in commands:
+        try:
+            status, encoding, length = struct.unpack("=ccI", read_exactly(sock, 6))
+        except EOFError:
+            break  # after exit the server closes the connection
+        payload = read_exactly(sock, length)
+        text = decode(command, payload) if encoding == b"B" else payload.decode()
+        if status == b"E":
+            failed = True
+            print(f"{command}: {text}", file=sys.stderr)
+        elif not options.quiet:
+            print(text)
+    sock.close()
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
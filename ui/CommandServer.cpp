@@ -0,0 +1,300 @@
+#include "CommandServer.hpp"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// a line longer than this is not a command, the connection is dropped
+static constexpr std::size_t MAX_REQUEST_SIZE = 1 << 20;
+
+static std::atomic<bool> stopRequested{false};
+
+void CommandServer::requestStop() {
+  stopRequested.store(true);
+}
+
+
+static std::runtime_error systemError(const std::string &what) {
+  return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+
+CommandServer::CommandServer(Console &console, const std::string &address, unsigned nrThreads)
+  : console(console), address(address) {
+  try {
+    listen();
+  } catch (...) {
+    if (listenFd >= 0)
+      close(listenFd);
+    throw;
+  }
+  for (unsigned t = 0; t < std::max(1u, nrThreads); ++t)
+    workers.emplace_back([this]() {
+      while (true) {
+        std::function<void()> task;
+        {
+          std::unique_lock<std::mutex> lock(queueMutex);
+          queueChanged.wait(lock, [&]() { return stopping || !queue.empty(); });
+          if (queue.empty())
+            return;
+          task = std::move(queue.front());
+          queue.pop_front();
+        }
+        task();
+      }
+    });
+}
+
+
+CommandServer::~CommandServer() {
+  reapConnections(true);
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    stopping = true;
+  }
+  queueChanged.notify_all();
+  for (auto &worker : workers)
+    worker.join();
+  if (listenFd >= 0)
+    close(listenFd);
+  if (!unixPath.empty())
+    unlink(unixPath.c_str());
+}
+
+
+/* Binds the listening socket of the address */
+void CommandServer::listen() {
+  if (address.rfind("unix:", 0) == 0) {
+    const std::string path = address.substr(5);
+    sockaddr_un socketAddress{};
+    socketAddress.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(socketAddress.sun_path))
+      throw std::runtime_error("Invalid socket path '" + path + "'");
+    std::memcpy(socketAddress.sun_path, path.c_str(), path.size() + 1);
+    struct stat status;
+    if (stat(path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode))
+      unlink(path.c_str()); // left behind by a server that did not stop cleanly
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd < 0)
+      throw systemError("socket");
+    if (bind(listenFd, reinterpret_cast<sockaddr *>(&socketAddress), sizeof(socketAddress)) < 0)
+      throw systemError("Could not bind to '" + path + "'");
+    unixPath = path;
+  } else if (address.rfind("tcp:", 0) == 0) {
+    const int port = std::stoi(address.substr(4));
+    if (port < 0 || port > 65535)
+      throw std::runtime_error("Invalid port " + std::to_string(port));
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd < 0)
+      throw systemError("socket");
+    int reuse = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in socketAddress{};
+    socketAddress.sin_family = AF_INET;
+    socketAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // local clients only
+    socketAddress.sin_port = htons(port);
+    if (bind(listenFd, reinterpret_cast<sockaddr *>(&socketAddress), sizeof(socketAddress)) < 0)
+      throw systemError("Could not bind to port " + std::to_string(port));
+    socklen_t length = sizeof(socketAddress);
+    getsockname(listenFd, reinterpret_cast<sockaddr *>(&socketAddress), &length);
+    address = "tcp:" + std::to_string(ntohs(socketAddress.sin_port));
+  } else {
+    throw std::runtime_error("Expected unix:<path> or tcp:<port> instead of '" + address + "'");
+  }
+  if (::listen(listenFd, 128) < 0)
+    throw systemError("listen");
+}
+
+
+int CommandServer::run() {
+  std::cout << "Listening on " << address << std::endl;
+  while (!stopRequested.load()) {
+    pollfd listener{listenFd, POLLIN, 0};
+    const int ready = poll(&listener, 1, 200); // wakes up to notice requestStop
+    reapConnections(false);
+    if (ready <= 0)
+      continue;
+    const int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0)
+      continue;
+    auto connection = std::make_unique<Connection>();
+    connection->fd = fd;
+    Connection &accepted = *connection;
+    connections.push_back(std::move(connection));
+    accepted.reader = std::thread([this, &accepted]() { serveConnection(accepted); });
+  }
+  reapConnections(true);
+  return 0;
+}
+
+
+void CommandServer::submit(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    queue.push_back(std::move(task));
+  }
+  queueChanged.notify_one();
+}
+
+
+/* Reads the requests of the connection and hands them to the pool, keeping the commands that are not reads in order.
+   The reads are pipelined up to MAX_IN_FLIGHT, then the reading stops until the writer catches up. */
+void CommandServer::serveConnection(Connection &connection) {
+  connection.writer = std::thread([this, &connection]() { writeResponses(connection); });
+  std::string buffer;
+  char chunk[1 << 16];
+  std::uint64_t sequence = 0;
+  bool open = true;
+  while (open) {
+    const ssize_t received = recv(connection.fd, chunk, sizeof(chunk), 0);
+    if (received < 0 && errno == EINTR)
+      continue;
+    if (received <= 0)
+      break;
+    buffer.append(chunk, received);
+
+    std::size_t start = 0, end;
+    while (open && (end = buffer.find('\n', start)) != std::string::npos) {
+      std::string line = buffer.substr(start, end - start);
+      start = end + 1;
+      const auto first = line.find_first_not_of(" \t\r");
+      if (first == std::string::npos)
+        continue;
+      const bool binary = line[first] == '!';
+      if (binary)
+        line.erase(first, 1);
+      const auto args = console.parseLine(line);
+      const bool read = !args.empty() && console.isReadCommand(args[0]);
+
+      std::unique_lock<std::mutex> lock(connection.mutex);
+      connection.idle.wait(lock, [&]() { return connection.inFlight < (read ? MAX_IN_FLIGHT : 1); });
+      if (connection.closing || connection.writeFailed) {
+        open = false;
+        break;
+      }
+      ++connection.inFlight;
+      lock.unlock();
+      const std::uint64_t current = sequence++;
+      submit([this, &connection, current, line, binary, read]() { runRequest(connection, current, line, binary, read); });
+      if (!read) {
+        lock.lock();
+        connection.idle.wait(lock, [&]() { return connection.inFlight == 0; });
+      }
+    }
+    buffer.erase(0, start);
+    if (buffer.size() > MAX_REQUEST_SIZE)
+      break;
+  }
+
+  std::unique_lock<std::mutex> lock(connection.mutex);
+  connection.idle.wait(lock, [&]() { return connection.inFlight == 0; });
+  connection.readerDone = true;
+  connection.responsesReady.notify_all();
+  lock.unlock();
+  connection.writer.join();
+  shutdown(connection.fd, SHUT_RDWR); // the client reads to the end of its responses
+  connection.finished = true;
+}
+
+
+void CommandServer::runRequest(Connection &connection, std::uint64_t sequence, const std::string &line, bool binary,
+                               bool read) {
+  // the command writes its output right after the header, which is filled in once the length is known
+  std::string response(6, '\0');
+  StringAppendBuffer responseBuffer(response);
+  std::ostream out(&responseBuffer);
+  Console::Outcome outcome;
+  try {
+    if (stopRequested.load()) { // the requests still queued are not worth waiting for
+      outcome.failed = true;
+      outcome.error = "The server is shutting down";
+    } else if (read) {
+      outcome = console.execute(line, out, binary);
+    } else {
+      std::lock_guard<std::mutex> lock(writeLock);
+      outcome = console.execute(line, out, binary);
+    }
+  } catch (std::exception &e) { // a bad argument must not take the server down
+    outcome.failed = true;
+    outcome.error = e.what();
+  }
+
+  if (outcome.failed) {
+    response.resize(6);
+    response += outcome.error;
+  } else if (!outcome.binary && response.size() > 6 && response.back() == '\n')
+    response.pop_back();
+  response[0] = outcome.failed ? 'E' : 'O';
+  response[1] = !outcome.failed && outcome.binary ? 'B' : 'T';
+  const std::uint32_t length = response.size() - 6;
+  std::memcpy(&response[2], &length, sizeof(length));
+  if (outcome.shouldExit) {
+    std::lock_guard<std::mutex> lock(connection.mutex);
+    connection.closing = true;
+  }
+  deliver(connection, sequence, std::move(response));
+}
+
+
+/* Hands the response to the writer of the connection: a pool worker never waits for a client */
+void CommandServer::deliver(Connection &connection, std::uint64_t sequence, std::string response) {
+  std::lock_guard<std::mutex> lock(connection.mutex);
+  connection.ready.emplace(sequence, std::move(response));
+  connection.responsesReady.notify_all();
+}
+
+
+/* Sends the responses in request order, outside of the lock; ends once the reader is done and all are sent */
+void CommandServer::writeResponses(Connection &connection) {
+  std::unique_lock<std::mutex> lock(connection.mutex);
+  while (true) {
+    connection.responsesReady.wait(lock, [&]() {
+      return (connection.readerDone && connection.inFlight == 0) ||
+             (!connection.ready.empty() && connection.ready.begin()->first == connection.nextToSend);
+    });
+    if (connection.ready.empty() || connection.ready.begin()->first != connection.nextToSend)
+      return;
+    const std::string data = std::move(connection.ready.begin()->second);
+    connection.ready.erase(connection.ready.begin());
+    ++connection.nextToSend;
+    bool failed = connection.writeFailed;
+    lock.unlock();
+    for (std::size_t sent = 0; !failed && sent < data.size();) {
+      const ssize_t written = send(connection.fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+      if (written < 0 && errno == EINTR)
+        continue;
+      if (written <= 0)
+        failed = true; // the client went away, the rest is dropped
+      else
+        sent += written;
+    }
+    lock.lock();
+    connection.writeFailed = failed;
+    --connection.inFlight;
+    connection.idle.notify_all();
+  }
+}
+
+
+/* Joins the readers of the closed connections, or of all of them when the server stops */
+void CommandServer::reapConnections(bool all) {
+  for (auto it = connections.begin(); it != connections.end();) {
+    Connection &connection = **it;
+    if (all && !connection.finished)
+      shutdown(connection.fd, SHUT_RD); // ends the reader once the pending requests are answered
+    if (all || connection.finished) {
+      connection.reader.join();
+      close(connection.fd);
+      it = connections.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
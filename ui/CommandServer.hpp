@@ -0,0 +1,80 @@
+#pragma once
+#include "Console.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Serves the commands of a Console to local clients over a Unix domain socket or localhost TCP.
+//
+// A request is one command line, in the console syntax; a leading '!' asks for the binary encoding
+// of the edge and path lists (see controller/BinaryResponse.hpp). Clients may pipeline: the requests
+// of a connection are read ahead and the responses come back in request order. Every connection has a
+// writer thread that sends its responses; once MAX_IN_FLIGHT requests of a connection are unanswered or
+// unsent, its requests are not read until the client reads responses. A response is
+//   status ('O' ok, 'E' error), encoding ('T' text, 'B' binary), uint32 payload length, payload
+// with the length in native byte order.
+//
+// The commands run concurrently on a thread pool. The reads never wait for the writes: they run on a
+// snapshot of the graph (GraphService::snapshot) while the writers, one at a time, publish new versions.
+// Within a connection a command that is not a read waits for the requests before it and blocks the ones
+// after it, so every client sees its own commands in order.
+class CommandServer {
+public:
+  // address is "unix:<path>" or "tcp:<port>" (bound to 127.0.0.1, port 0 picks a free one)
+  CommandServer(Console &console, const std::string &address, unsigned nrThreads);
+  ~CommandServer();
+
+  // Serves until requestStop is called, returns the exit status
+  int run();
+  // Async signal safe
+  static void requestStop();
+
+private:
+  static constexpr std::size_t MAX_IN_FLIGHT = 64;
+
+  struct Connection {
+    int fd;
+    std::mutex mutex;
+    std::condition_variable idle; // inFlight went down
+    std::condition_variable responsesReady; // for the writer
+    std::size_t inFlight = 0; // requests read whose response is not sent yet
+    std::uint64_t nextToSend = 0;
+    std::map<std::uint64_t, std::string> ready; // finished responses waiting for the ones before them
+    bool writeFailed = false;
+    bool closing = false; // the client sent exit
+    bool readerDone = false;
+    std::atomic<bool> finished{false};
+    std::thread reader;
+    std::thread writer;
+  };
+
+  Console &console;
+  std::string address;
+  std::string unixPath; // removed when the server stops
+  int listenFd = -1;
+  std::mutex writeLock; // keeps a command that makes several service calls from interleaving with another one
+
+  std::vector<std::thread> workers;
+  std::mutex queueMutex;
+  std::condition_variable queueChanged;
+  std::deque<std::function<void()>> queue;
+  bool stopping = false;
+
+  std::list<std::unique_ptr<Connection>> connections;
+
+  void listen();
+  void submit(std::function<void()> task);
+  void serveConnection(Connection &connection);
+  void runRequest(Connection &connection, std::uint64_t sequence, const std::string &line, bool binary, bool read);
+  void deliver(Connection &connection, std::uint64_t sequence, std::string response);
+  void writeResponses(Connection &connection);
+  void reapConnections(bool all);
+};
@@ -0,0 +1,153 @@
+#include "CommandStats.hpp"
+#include <algorithm>
+#include <bit>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+
+int LatencyHistogram::getBucket(std::uint64_t value) {
+  if (value < SUB_BUCKETS)
+    return (int)value;
+  // value >> shift is in [SUB_BUCKETS, 2 * SUB_BUCKETS)
+  const int shift = std::bit_width(value) - SUB_BUCKET_BITS - 1;
+  return shift * SUB_BUCKETS + (int)(value >> shift);
+}
+
+
+std::uint64_t LatencyHistogram::getBucketUpperBound(int bucket) {
+  if (bucket < SUB_BUCKETS)
+    return bucket;
+  const int shift = bucket / SUB_BUCKETS - 1;
+  const std::uint64_t subBucket = bucket % SUB_BUCKETS + SUB_BUCKETS;
+  return ((subBucket + 1) << shift) - 1; // wraps to UINT64_MAX for the last bucket
+}
+
+
+void LatencyHistogram::record(std::uint64_t ns) {
+  ++counts[getBucket(ns)];
+  ++count;
+  total += ns;
+  min = std::min(min, ns);
+  max = std::max(max, ns);
+}
+
+
+void LatencyHistogram::merge(const LatencyHistogram &other) {
+  for (int bucket = 0; bucket < NR_OF_BUCKETS; ++bucket)
+    counts[bucket] += other.counts[bucket];
+  count += other.count;
+  total += other.total;
+  min = std::min(min, other.min);
+  max = std::max(max, other.max);
+}
+
+
+std::uint64_t LatencyHistogram::getPercentile(double p) const {
+  if (count == 0)
+    return 0;
+  const std::uint64_t rank = std::max<std::uint64_t>(1, (std::uint64_t)(p * count + 0.5));
+  std::uint64_t seen = 0;
+  for (int bucket = 0; bucket < NR_OF_BUCKETS; ++bucket) {
+    seen += counts[bucket];
+    if (seen >= rank)
+      return std::min(getBucketUpperBound(bucket), max);
+  }
+  return max;
+}
+
+
+void ConsoleStats::record(const std::string &command, const std::array<std::uint64_t, NR_OF_COMMAND_PHASES> &phaseNs,
+                          bool failed) {
+  std::lock_guard<std::mutex> lock(mutex);
+  CommandStats &stats = commands[command];
+  ++stats.calls;
+  if (failed)
+    ++stats.errors;
+  std::uint64_t total = 0;
+  for (int phase = 0; phase < NR_OF_COMMAND_PHASES; ++phase) {
+    stats.phases[phase].record(phaseNs[phase]);
+    total += phaseNs[phase];
+  }
+  stats.latency.record(total);
+}
+
+
+void ConsoleStats::recordUnknownCommand() {
+  std::lock_guard<std::mutex> lock(mutex);
+  ++unknownCommands;
+}
+
+
+void ConsoleStats::reset() {
+  std::lock_guard<std::mutex> lock(mutex);
+  commands.clear();
+  unknownCommands = 0;
+}
+
+
+std::string formatDuration(double ns) {
+  if (ns < 1e3)
+    return std::format("{:.0f}ns", ns);
+  if (ns < 1e6)
+    return std::format("{:.1f}us", ns / 1e3);
+  if (ns < 1e9)
+    return std::format("{:.2f}ms", ns / 1e6);
+  return std::format("{:.2f}s", ns / 1e9);
+}
+
+
+std::string ConsoleStats::toString() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (commands.empty() && unknownCommands == 0)
+    return "No commands were recorded.";
+  std::string output = std::format("{:<26}{:>8}{:>8}{:>10}{:>10}{:>10}{:>10}{:>11}{:>11}{:>11}", "command", "calls",
+                                   "errors", "p50", "p90", "p99", "max", "parse", "compute", "format");
+  for (const auto &[name, stats] : commands) {
+    output += std::format("\n{:<26}{:>8}{:>8}{:>10}{:>10}{:>10}{:>10}", name, stats.calls, stats.errors,
+                          formatDuration(stats.latency.getPercentile(0.50)),
+                          formatDuration(stats.latency.getPercentile(0.90)),
+                          formatDuration(stats.latency.getPercentile(0.99)), formatDuration(stats.latency.getMax()));
+    for (const auto &phase : stats.phases)
+      output += std::format("{:>11}", formatDuration(phase.getMean()));
+  }
+  output += "\n(percentiles of the whole command, mean per phase)";
+  if (unknownCommands > 0)
+    output += std::format("\nUnknown commands: {}", unknownCommands);
+  return output;
+}
+
+
+static std::string histogramToJson(const LatencyHistogram &histogram) {
+  return std::format("{{\"count\": {}, \"totalNs\": {}, \"minNs\": {}, \"meanNs\": {:.0f}, \"p50Ns\": {}, "
+                     "\"p90Ns\": {}, \"p99Ns\": {}, \"p999Ns\": {}, \"maxNs\": {}}}",
+                     histogram.getCount(), histogram.getTotal(), histogram.getMin(), histogram.getMean(),
+                     histogram.getPercentile(0.50), histogram.getPercentile(0.90), histogram.getPercentile(0.99),
+                     histogram.getPercentile(0.999), histogram.getMax());
+}
+
+
+std::string ConsoleStats::toJson() const {
+  static const char *phaseNames[NR_OF_COMMAND_PHASES] = {"parse", "compute", "format"};
+  std::lock_guard<std::mutex> lock(mutex);
+  std::string output = std::format("{{\"unknownCommands\": {}, \"commands\": {{", unknownCommands);
+  bool first = true;
+  for (const auto &[name, stats] : commands) {
+    // the command names are registered identifiers, nothing to escape
+    output += std::format("{}\n  \"{}\": {{\"calls\": {}, \"errors\": {}, \"latency\": {}", first ? "" : ",", name,
+                          stats.calls, stats.errors, histogramToJson(stats.latency));
+    for (int phase = 0; phase < NR_OF_COMMAND_PHASES; ++phase)
+      output += std::format(", \"{}\": {}", phaseNames[phase], histogramToJson(stats.phases[phase]));
+    output += "}";
+    first = false;
+  }
+  output += "\n}}\n";
+  return output;
+}
+
+
+void ConsoleStats::saveJson(const std::string &path) const {
+  std::ofstream fout(path);
+  if (!fout)
+    throw std::runtime_error("Unable to open " + path);
+  fout << toJson();
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+// Log-linear latency histogram (HDR style): the values below 16 ns have their own bucket and
+// every power of two above is split in 16 linear sub-buckets, so a value is known within 1/16
+// of itself. Recording is a few bit operations on a fixed table, there is nothing to allocate.
+class LatencyHistogram {
+public:
+  void record(std::uint64_t ns);
+  void merge(const LatencyHistogram &other);
+  std::uint64_t getCount() const { return count; }
+  std::uint64_t getTotal() const { return total; }
+  std::uint64_t getMin() const { return count == 0 ? 0 : min; }
+  std::uint64_t getMax() const { return max; }
+  double getMean() const { return count == 0 ? 0 : (double)total / count; }
+  // The highest value of the bucket holding the p-th value (p in [0, 1])
+  std::uint64_t getPercentile(double p) const;
+
+private:
+  static constexpr int SUB_BUCKET_BITS = 4;
+  static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+  static constexpr int NR_OF_BUCKETS = SUB_BUCKETS + (64 - SUB_BUCKET_BITS) * SUB_BUCKETS;
+  static int getBucket(std::uint64_t value);
+  static std::uint64_t getBucketUpperBound(int bucket);
+
+  std::array<std::uint64_t, NR_OF_BUCKETS> counts{};
+  std::uint64_t count = 0;
+  std::uint64_t total = 0;
+  std::uint64_t min = UINT64_MAX;
+  std::uint64_t max = 0;
+};
+
+// Where the time of a command goes: splitting the line into arguments, the handler until it
+// calls Console::beginOutput (the GraphService work), and building plus printing the output
+enum class CommandPhase { Parse, Compute, Format };
+constexpr int NR_OF_COMMAND_PHASES = 3;
+
+struct CommandStats {
+  std::uint64_t calls = 0;
+  std::uint64_t errors = 0;
+  LatencyHistogram latency;
+  std::array<LatencyHistogram, NR_OF_COMMAND_PHASES> phases;
+};
+
+// 950ns, 12.3us, 4.56ms, 7.89s
+std::string formatDuration(double ns);
+
+// Safe to record from several threads (the server runs commands concurrently)
+class ConsoleStats {
+public:
+  void record(const std::string &command, const std::array<std::uint64_t, NR_OF_COMMAND_PHASES> &phaseNs, bool failed);
+  void recordUnknownCommand();
+  void reset();
+
+  // Table with one line per command that was called
+  std::string toString() const;
+  std::string toJson() const;
+  void saveJson(const std::string &path) const;
+
+private:
+  mutable std::mutex mutex;
+  std::map<std::string, CommandStats> commands; // ordered for the reports
+  std::uint64_t unknownCommands = 0;
+};
@@ -1,11 +1,20 @@
 #include "Console.hpp"
 #include "../errors/InvalidInputError.cpp"
 #include <iostream>
+#include <stdexcept>
 #include <unordered_map>
 #include <vector>
 
-void Console::registerCommand(const std::string& name, CommandHandler handler) {
+void Console::registerCommand(const std::string& name, CommandHandler handler, CommandAccess access) {
   commands[name] = handler;
+  if (access == CommandAccess::Read)
+    readCommands.insert(name);
+  else
+    readCommands.erase(name);
+}
+
+bool Console::isReadCommand(const std::string& name) const {
+  return readCommands.count(name) > 0;
 }
 
 void Console::documentCommand(const std::string& name, const std::string& description) {
@@ -23,45 +32,146 @@ std::unordered_map<std::string, std::string> Console::getMan() const {
   return man;
 }
 
-void Console::startConsoleLoop() {
+// State of the command the calling thread runs (the server runs several at once)
+static thread_local std::optional<std::chrono::steady_clock::time_point> outputStart;
+static thread_local bool binaryRequested = false;
+static thread_local OutputSink *currentOutput = nullptr;
+
+void Console::beginOutput() {
+  outputStart = std::chrono::steady_clock::now();
+}
+
+bool Console::wantsBinary() const {
+  return binaryRequested;
+}
+
+OutputSink &Console::output() {
+  if (currentOutput == nullptr)
+    throw std::logic_error("Console::output is only available to a running command");
+  return *currentOutput;
+}
+
+
+static std::uint64_t elapsedNs(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+}
+
+
+Console::Outcome Console::execute(const std::string &line, std::ostream &out, bool binary) {
+  using clock = std::chrono::steady_clock;
+  Outcome outcome;
+  const auto parseStart = clock::now();
+  std::vector<std::string> args = parseLine(line);
+  if (args.empty())
+    return outcome;
+  outcome.command = args[0];
+
+  auto commandMapIt = commands.find(args[0]);
+  if (commandMapIt == commands.end()) {
+    stats.recordUnknownCommand();
+    outcome.failed = true;
+    outcome.error = "Unknown command: " + args[0];
+    outcome.elapsedNs = elapsedNs(parseStart, clock::now());
+    return outcome;
+  }
+
+  CommandResult result;
+  OutputSink sink(out);
+  const auto computeStart = clock::now();
+  outputStart.reset();
+  binaryRequested = binary;
+  currentOutput = &sink;
+  try {
+    result = commandMapIt->second(args);
+  } catch (InvalidUsageError &e) {
+    outcome.failed = true;
+    outcome.error = e.what();
+  } catch (std::runtime_error &e) {
+    outcome.failed = true;
+    outcome.error = e.what();
+  } catch (std::logic_error &e) { // std::stoi and the like on a bad number, at() out of range
+    outcome.failed = true;
+    outcome.error = std::string("Invalid argument (") + e.what() + ")";
+  } catch (std::exception &e) {
+    outcome.failed = true;
+    outcome.error = e.what();
+  }
+  currentOutput = nullptr;
+  binaryRequested = false;
+  const auto handlerEnd = clock::now();
+  const auto computeEnd = outputStart.value_or(handlerEnd);
+
+  sink.write(result.output);
+  if (!result.binary && !sink.empty())
+    sink.put('\n');
+  sink.flush();
+  const auto formatEnd = clock::now();
+  stats.record(args[0],
+               {elapsedNs(parseStart, computeStart), elapsedNs(computeStart, computeEnd), elapsedNs(computeEnd, formatEnd)},
+               outcome.failed);
+  outcome.shouldExit = result.shouldExit;
+  outcome.binary = result.binary;
+  outcome.elapsedNs = elapsedNs(parseStart, formatEnd);
+  return outcome;
+}
+
+
+int Console::startConsoleLoop() {
   while (true) {
-    std::vector<std::string> args = parseLine(getInput());
-    if (args.empty())
-      continue;
+    std::optional<std::string> line = getInput();
+    if (!line)
+      return std::cin.bad() ? 1 : 0;
+    Outcome outcome = execute(*line, std::cout);
+    if (outcome.failed)
+      std::cout << outcome.error << '\n';
+    if (outcome.shouldExit)
+      return 0;
+  }
+}
 
-    auto commandMapIt = commands.find(args[0]);
-    if (commandMapIt == commands.end()) {
-      std::cout << "Unknown command: " << args[0] << "\n";
-      continue;
-    }
 
-    CommandResult result;
-    try {
-      result = commandMapIt->second(args);
-    } catch (InvalidUsageError &e) {
-      std::cout << e.what() << '\n';
-      continue;
-    } catch (std::runtime_error &e) {
-      std::cout << e.what() << '\n';
+int Console::runScript(std::istream &in, std::ostream &out, const BatchOptions &options) {
+  std::string line;
+  std::size_t lineNumber = 0;
+  int status = 0;
+  while (std::getline(in, line)) {
+    ++lineNumber;
+    const auto firstCharacter = line.find_first_not_of(" \t\r");
+    if (firstCharacter == std::string::npos || line[firstCharacter] == '#') // blank lines and comments
       continue;
+
+    Outcome outcome = execute(line, out);
+    if (options.timing && !outcome.command.empty())
+      std::cerr << "[line " << lineNumber << "] " << outcome.command << ": " << formatDuration(outcome.elapsedNs) << '\n';
+    if (outcome.failed) {
+      out.flush(); // keep the error after the output of the commands before it
+      std::cerr << "line " << lineNumber << ": " << outcome.error << '\n';
+      status = 1;
+      if (!options.keepGoing)
+        break;
     }
-    
-    if (!result.output.empty()) {
-      std::cout << result.output << '\n';
-    }
-    if (result.shouldExit)
-      return;
+    if (outcome.shouldExit)
+      break;
+  }
+  if (in.bad()) {
+    std::cerr << "Error reading the script\n";
+    status = 1;
   }
+  out.flush();
+  if (options.timing)
+    std::cerr << stats.toString() << '\n';
+  return status;
 }
 
 
-std::string Console::getInput() const {
+std::optional<std::string> Console::getInput() const {
   std::string line;
 
   std::cout << "-> ";
   if (!getline(std::cin, line)) {
-    std::cerr << "Error reading line. Exiting...\n";
-    exit(1);
+    if (std::cin.bad())
+      std::cerr << "Error reading line. Exiting...\n";
+    return std::nullopt;
   }
   return line;
 }
@@ -1,8 +1,14 @@
 #pragma once
+#include "CommandStats.hpp"
+#include "OutputSink.hpp"
+#include <chrono>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <functional>
+#include <iosfwd>
 
 #if defined(__linux__)
 #define CLEAR_SCREEN system("clear");
@@ -12,22 +18,62 @@
 #define CLEAR_SCREEN system("clear");
 #endif
 
+// A handler returns its output, or writes it to Console::output as it goes (then output comes after it)
 struct CommandResult {
   std::string output;
   bool shouldExit = false;
+  bool binary = false; // output is the binary encoding the client asked for (see Console::wantsBinary)
+};
+
+// Read commands only look at the GraphService and may run concurrently in the server
+enum class CommandAccess { Read, Write };
+
+struct BatchOptions {
+  bool keepGoing = false; // run the rest of the script after a command failed
+  bool timing = false;    // report the latency of every command and a summary on stderr
 };
 
 class Console {
 public:
   using CommandHandler = std::function<CommandResult(const std::vector<std::string>&)>;
-  void startConsoleLoop();
-  void registerCommand(const std::string &name, CommandHandler handler);
+  // Returns the exit status: 0 after a command asked to exit or at the end of the input, 1 on a read error
+  int startConsoleLoop();
+  // Runs the commands of in back to back, without prompts, with the output buffered into out.
+  // Errors go to stderr with their line number. Returns 1 if a command failed, else 0.
+  int runScript(std::istream &in, std::ostream &out, const BatchOptions &options);
+  void registerCommand(const std::string &name, CommandHandler handler, CommandAccess access = CommandAccess::Write);
+  bool isReadCommand(const std::string &name) const;
   void documentCommand(const std::string &name, const std::string &description);
   std::vector<std::string> getRegisteredCommands() const;
   std::unordered_map<std::string, std::string> getMan() const;
   std::vector<std::string> parseLine(std::string line) const;
-  std::string getInput() const;
+  std::optional<std::string> getInput() const;
+  // Called by a handler when its computation is done and it starts building the output,
+  // the rest of the handler is accounted to the format phase
+  void beginOutput();
+  // True while a handler runs for a client that asked for binary responses
+  bool wantsBinary() const;
+  // Where the handler running on the calling thread streams its output, without a final newline (the
+  // console adds it). What was written stays written when the handler fails afterwards.
+  OutputSink &output();
+  ConsoleStats &getStats() { return stats; }
+  const ConsoleStats &getStats() const { return stats; }
+
+  struct Outcome {
+    std::string command; // empty for blank lines
+    bool failed = false;
+    bool shouldExit = false;
+    bool binary = false; // the output was written without the trailing newline
+    std::string error;
+    std::uint64_t elapsedNs = 0;
+  };
+  // Parses and runs one line, writes its output to out and records its statistics.
+  // Safe to call from several threads once all the commands are registered.
+  Outcome execute(const std::string &line, std::ostream &out, bool binary = false);
+
 private:
   std::unordered_map<std::string, CommandHandler> commands;
+  std::unordered_set<std::string> readCommands;
   std::unordered_map<std::string, std::string> man;
+  ConsoleStats stats;
 };
@@ -0,0 +1,95 @@
+#pragma once
+#include <charconv>
+#include <concepts>
+#include <format>
+#include <iterator>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// Where a command writes its output as it produces it (Console::output): a fixed size buffer in front of
+// the stream of the console, the script or the server response, so a listing takes the memory of the
+// buffer instead of the memory of the whole listing.
+class OutputSink {
+public:
+  static constexpr std::size_t BUFFER_SIZE = 64 * 1024;
+
+  explicit OutputSink(std::ostream &out) : out(out) { buffer.reserve(BUFFER_SIZE); }
+  OutputSink(const OutputSink &) = delete;
+  OutputSink &operator=(const OutputSink &) = delete;
+  ~OutputSink() { flush(); }
+
+  void write(std::string_view text) {
+    if (text.empty())
+      return;
+    written = true;
+    if (buffer.size() + text.size() > BUFFER_SIZE) {
+      flush();
+      if (text.size() >= BUFFER_SIZE) {
+        out.write(text.data(), text.size());
+        return;
+      }
+    }
+    buffer.append(text);
+  }
+
+  void put(char c) {
+    written = true;
+    if (buffer.size() == BUFFER_SIZE)
+      flush();
+    buffer.push_back(c);
+  }
+
+  // Integers go through to_chars, without a temporary string
+  template <std::integral T>
+  void write(T value) {
+    char digits[24];
+    auto [end, _] = std::to_chars(digits, digits + sizeof(digits), value);
+    write(std::string_view(digits, end - digits));
+  }
+
+  template <typename... Args>
+  void print(std::format_string<Args...> format, Args &&...args) {
+    written = true;
+    std::format_to(std::back_inserter(buffer), format, std::forward<Args>(args)...);
+    if (buffer.size() >= BUFFER_SIZE)
+      flush();
+  }
+
+  void flush() {
+    out.write(buffer.data(), buffer.size());
+    buffer.clear();
+  }
+
+  // True until something is written
+  bool empty() const { return !written; }
+
+private:
+  std::ostream &out;
+  std::string buffer;
+  bool written = false;
+};
+
+
+// A stream buffer that appends to a string, for building a response in place (no str() copy)
+class StringAppendBuffer : public std::streambuf {
+public:
+  explicit StringAppendBuffer(std::string &target) : target(target) {}
+
+protected:
+  int_type overflow(int_type c) override {
+    if (!traits_type::eq_int_type(c, traits_type::eof()))
+      target.push_back(traits_type::to_char_type(c));
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char *data, std::streamsize count) override {
+    target.append(data, count);
+    return count;
+  }
+
+private:
+  std::string &target;
+};